@@ -42,16 +42,17 @@ int main(int argc, char* argv[])
     double mean, scale;
     Matrix<double> normalized(rawImg.normalize(mean,scale).transpose());
 
-    // SVD decomposition
-    Decomposition::SVDResult deco = Decomposition::svd(normalized);
+    // Truncated randomized SVD: only the mods, which are used for the
+    // reconstruction, are computed
+    size_t maxMods = std::min<size_t>(100, std::min(normalized.rows(), normalized.cols()));
+    Decomposition::SVDResult deco = Decomposition::svdRandomized(normalized, maxMods);
 
-    // as the SVD decomposition may take several hours, it makes sense
-    // to keep the resulting matrices
+    // keep the resulting matrices
     deco.S.save("S.mat"); deco.U.save("U.mat"); deco.V.save("V.mat");
 
     // generate several compressed images, by increasing the number of mods used
     // for the reconstruction.
-    for( size_t mods = 1; mods < deco.S.cols(); mods++)
+    for( size_t mods = 1; mods <= maxMods; mods++)
     {
         // create compressed image
         Matrix<double> compressed =
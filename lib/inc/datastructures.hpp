@@ -25,11 +25,15 @@
 #define MY_DATASTRUCTURES_H
 
 #include "exceptions.hpp"
+#include "matrix.hpp"
+#include "parallel.hpp"
 
 #include <vector>
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <numeric>
+#include <limits>
 
 template <typename T, size_t C>
 class HeapNode
@@ -885,4 +889,226 @@ private:
     }
 };
 
+/**
+ * Static k-d tree over the columns of a 3 x n point set for nearest
+ * neighbour queries. The nodes are stored in a flat array and the points
+ * in tree order, so that the leaves are contiguous. The queries are const
+ * and can be run concurrently.
+ */
+class KdTree
+{
+public:
+    /**
+     * Builds the tree by median splits along the axis of largest extent.
+     * @param points Point set (3 x n matrix).
+     * @param leafSize Maximum number of points in a leaf.
+     */
+    KdTree(const Matrix<double>& points, size_t leafSize = 8)
+    : m_points(points), m_leafSize(std::max<size_t>(1, leafSize))
+    {
+        if (points.rows() != 3)
+            throw InvalidInputException();
+
+        size_t n = points.cols();
+        m_order.resize(n);
+        std::iota(m_order.begin(), m_order.end(), 0);
+        if (n > 0)
+            build(0, n);
+
+        m_xyz.resize(3 * n);
+        for (size_t k = 0; k < n; k++)
+            for (size_t i = 0; i < 3; i++)
+                m_xyz[3 * k + i] = points(i, m_order[k]);
+    }
+
+    size_t size() const
+    {
+        return m_order.size();
+    }
+
+    /**
+     * The point set (3 x n matrix).
+     */
+    const Matrix<double>& points() const
+    {
+        return m_points;
+    }
+
+    /**
+     * Finds the nearest point to query.
+     * @param query Array with x, y and z.
+     * @param index On return, the column of the nearest point.
+     * @param distance2 On return, the squared distance to the nearest point.
+     * @param maxDistance2 Only points closer than this squared distance are considered.
+     * @return False if no point was closer than maxDistance2.
+     */
+    bool nearest(const double* query, size_t& index, double& distance2,
+                 double maxDistance2 = std::numeric_limits<double>::infinity()) const
+    {
+        size_t best  = size();
+        double best2 = maxDistance2;
+        search(query, 1, &best, &best2, best2);
+        index     = best;
+        distance2 = best2;
+        return best < size();
+    }
+
+    /**
+     * Finds the k nearest points to query.
+     * @param query Array with x, y and z.
+     * @param k Number of neighbours.
+     * @return Columns of the min(k, n) nearest points, the nearest first.
+     */
+    std::vector<size_t> nearestK(const double* query, size_t k) const
+    {
+        k = std::min(k, size());
+        std::vector<size_t> indices(k, size());
+        std::vector<double> distances2(k, std::numeric_limits<double>::infinity());
+        if (k > 0)
+            search(query, k, indices.data(), distances2.data(), std::numeric_limits<double>::infinity());
+        return indices;
+    }
+
+    /**
+     * Nearest points to all columns of queries, in parallel.
+     * @param queries Query points (3 x m matrix).
+     * @param indices On return, the column of the nearest point of each query, or size() if none was closer than maxDistance.
+     * @param distances2 On return, the squared distances.
+     * @param maxDistance Only points closer than this distance are considered.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    void nearest(const Matrix<double>& queries, std::vector<size_t>& indices, std::vector<double>& distances2,
+                 double maxDistance = std::numeric_limits<double>::infinity(), size_t nbrOfThreads = 0) const
+    {
+        if (queries.rows() != 3)
+            throw InvalidInputException();
+
+        size_t m = queries.cols();
+        indices.resize(m);
+        distances2.resize(m);
+        auto worker = [&](size_t q0, size_t q1) {
+            for (size_t q = q0; q < q1; q++)
+            {
+                double query[3] = {queries(0, q), queries(1, q), queries(2, q)};
+                nearest(query, indices[q], distances2[q], maxDistance * maxDistance);
+            }
+        };
+        Parallel::forRange(0, m, worker, nbrOfThreads, 256);
+    }
+
+private:
+    struct Node
+    {
+        Node(size_t begin, size_t end)
+        : Begin(begin), End(end), Left(0), Right(0), Axis(0), Split(0.0)
+        {
+        }
+        size_t Begin; // First point in tree order
+        size_t End;   // One past the last point
+        size_t Left;  // Child nodes, 0 for leaves
+        size_t Right;
+        size_t Axis;  // Split axis
+        double Split; // Points of the left child have coordinates <= Split
+    };
+
+    size_t build(size_t begin, size_t end)
+    {
+        size_t node = m_nodes.size();
+        m_nodes.push_back(Node(begin, end));
+        if (end - begin <= m_leafSize)
+            return node;
+
+        // axis of the largest extent
+        double lo[3] = {m_points(0, m_order[begin]), m_points(1, m_order[begin]), m_points(2, m_order[begin])};
+        double hi[3] = {lo[0], lo[1], lo[2]};
+        for (size_t k = begin; k < end; k++)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                lo[i] = std::min(lo[i], m_points(i, m_order[k]));
+                hi[i] = std::max(hi[i], m_points(i, m_order[k]));
+            }
+        }
+        size_t axis = 0;
+        for (size_t i = 1; i < 3; i++)
+            if (hi[i] - lo[i] > hi[axis] - lo[axis])
+                axis = i;
+
+        // identical points stay in one leaf
+        if (hi[axis] == lo[axis])
+            return node;
+
+        size_t         mid = begin + (end - begin) / 2;
+        const double*  row = m_points.data() + axis * m_points.cols();
+        std::nth_element(m_order.begin() + begin, m_order.begin() + mid, m_order.begin() + end,
+                         [row](size_t x, size_t y) { return row[x] < row[y]; });
+
+        m_nodes[node].Axis  = axis;
+        m_nodes[node].Split = row[m_order[mid]];
+        size_t left         = build(begin, mid);
+        size_t right        = build(mid, end);
+        m_nodes[node].Left  = left;
+        m_nodes[node].Right = right;
+        return node;
+    }
+
+    // Keeps the k best candidates sorted in indices and distances2. Subtrees, which
+    // are further away than the worst candidate, are skipped.
+    void search(const double* query, size_t k, size_t* indices, double* distances2, double maxDistance2) const
+    {
+        // node and its lower bound of the squared distance
+        std::pair<size_t, double> stack[128];
+        size_t                    top = 0;
+        stack[top++]                  = std::make_pair(size_t(0), 0.0);
+
+        while (top > 0)
+        {
+            std::pair<size_t, double> entry = stack[--top];
+            double                    worst = distances2[k - 1];
+            if (entry.second >= worst || entry.second >= maxDistance2)
+                continue;
+
+            const Node& node = m_nodes[entry.first];
+            if (node.Left == 0)
+            {
+                for (size_t p = node.Begin; p < node.End; p++)
+                {
+                    const double* x  = &m_xyz[3 * p];
+                    double        dx = x[0] - query[0];
+                    double        dy = x[1] - query[1];
+                    double        dz = x[2] - query[2];
+                    double        d2 = dx * dx + dy * dy + dz * dz;
+                    if (d2 < distances2[k - 1])
+                    {
+                        // insert sorted
+                        size_t pos = k - 1;
+                        while (pos > 0 && distances2[pos - 1] > d2)
+                        {
+                            distances2[pos] = distances2[pos - 1];
+                            indices[pos]    = indices[pos - 1];
+                            pos--;
+                        }
+                        distances2[pos] = d2;
+                        indices[pos]    = m_order[p];
+                    }
+                }
+                continue;
+            }
+
+            // the far child first on the stack, so that the near one is visited first
+            double diff = query[node.Axis] - node.Split;
+            size_t nearChild = diff <= 0.0 ? node.Left : node.Right;
+            size_t farChild  = diff <= 0.0 ? node.Right : node.Left;
+            stack[top++]     = std::make_pair(farChild, std::max(entry.second, diff * diff));
+            stack[top++]     = std::make_pair(nearChild, entry.second);
+        }
+    }
+
+    Matrix<double>      m_points;   // Point set (3 x n)
+    size_t              m_leafSize; // Maximum number of points in a leaf
+    std::vector<size_t> m_order;    // Column of the point at each tree position
+    std::vector<double> m_xyz;      // Coordinates in tree order
+    std::vector<Node>   m_nodes;    // Node 0 is the root
+};
+
 #endif //MY_DATASTRUCTURES_H
@@ -25,6 +25,8 @@
 #define MY_DECOMPOSITION_H
 
 #include "matrix.hpp"
+#include "parallel.hpp"
+#include "kernels.hpp"
 
 class Decomposition
 {
@@ -41,6 +43,18 @@ public:
         size_t         NbrRowSwaps; // Number of row swaps
     };
 
+    struct LUPackedResult
+    {
+        LUPackedResult(Matrix<double> lu, std::vector<size_t> pivots, size_t n, bool singular)
+        : LU(lu), Pivots(pivots), NbrRowSwaps(n), Singular(singular)
+        {
+        }
+        Matrix<double>      LU;          // L below the diagonal (unit diagonal implied), U on and above
+        std::vector<size_t> Pivots;      // Row k was swapped with row Pivots[k] in step k
+        size_t              NbrRowSwaps; // Number of row swaps
+        bool                Singular;    // A zero pivot was encountered
+    };
+
     struct EigenPair
     {
         EigenPair(Matrix<double> v, double l, bool valid)
@@ -52,6 +66,19 @@ public:
         bool           Valid; // Is eigen pair valid? It is if precision was reached.
     };
 
+    struct ComplexEigenPair
+    {
+        ComplexEigenPair(Matrix<double> vReal, Matrix<double> vImag, double lReal, double lImag, bool valid)
+        : VReal(vReal), VImag(vImag), LReal(lReal), LImag(lImag), Valid(valid)
+        {
+        }
+        Matrix<double> VReal; // Real part of the Eigen vector
+        Matrix<double> VImag; // Imaginary part of the Eigen vector
+        double         LReal; // Real part of the Eigen value
+        double         LImag; // Imaginary part of the Eigen value
+        bool           Valid; // Is eigen pair valid? It is if the QR algorithm converged.
+    };
+
     static void sortDescending(std::vector<EigenPair>& pairs)
     {
         std::sort(pairs.begin(), pairs.end(), [](const EigenPair& a, const EigenPair& b) {
@@ -121,6 +148,71 @@ public:
         Matrix<double> R; // Upper triangle matrix
     };
 
+    struct QRPackedResult
+    {
+        QRPackedResult(Matrix<double> qr, std::vector<double> tau)
+        : QR(qr), Tau(tau)
+        {
+        }
+        Matrix<double>      QR;  // R on and above the diagonal, Householder vectors below (leading 1 implied)
+        std::vector<double> Tau; // Q = H_0 * H_1 * ..., where H_k = I - Tau[k] * v_k * v_k'
+    };
+
+    struct QRCPResult
+    {
+        QRCPResult(Matrix<double> q, Matrix<double> r, std::vector<size_t> permutation, size_t rank)
+        : Q(q), R(r), Permutation(permutation), Rank(rank)
+        {
+        }
+        Matrix<double>      Q;           // Orthogonal matrix (empty if not requested)
+        Matrix<double>      R;           // Upper triangle matrix with decreasing diagonal magnitudes
+        std::vector<size_t> Permutation; // Column k of Q*R is column Permutation[k] of the input
+        size_t              Rank;        // Numerical rank
+    };
+
+    struct HessenbergResult
+    {
+        HessenbergResult(Matrix<double> h, Matrix<double> q)
+        : H(h), Q(q)
+        {
+        }
+        Matrix<double> H; // Upper Hessenberg matrix, mat = Q * H * Q'
+        Matrix<double> Q; // Orthogonal matrix (empty if not requested)
+    };
+
+    struct TridiagonalResult
+    {
+        TridiagonalResult(std::vector<double> d, std::vector<double> e, Matrix<double> q)
+        : Diagonal(d), OffDiagonal(e), Q(q)
+        {
+        }
+        std::vector<double> Diagonal;    // n diagonal entries of T, mat = Q * T * Q'
+        std::vector<double> OffDiagonal; // n-1 sub- and superdiagonal entries of T
+        Matrix<double>      Q;           // Orthogonal matrix (empty if not requested)
+    };
+
+    struct SymmetricEigenResult
+    {
+        SymmetricEigenResult(std::vector<double> values, Matrix<double> vectors, bool valid)
+        : Values(values), Vectors(vectors), Valid(valid)
+        {
+        }
+        std::vector<double> Values;  // Eigen values in ascending order
+        Matrix<double>      Vectors; // Eigen vectors as columns, in the order of Values (empty if not requested)
+        bool                Valid;   // False if the QR iteration of a subproblem did not converge
+    };
+
+    struct SchurResult
+    {
+        SchurResult(Matrix<double> t, Matrix<double> q, bool converged)
+        : T(t), Q(q), Converged(converged)
+        {
+        }
+        Matrix<double> T;         // Quasi upper triangle matrix with 1x1 and 2x2 blocks, mat = Q * T * Q'
+        Matrix<double> Q;         // Orthogonal matrix
+        bool           Converged; // False if the QR algorithm did not converge
+    };
+
     struct SVDResult
     {
         SVDResult(Matrix<double> u, Matrix<double> s, Matrix<double> v)
@@ -180,22 +272,148 @@ public:
     template <class T>
     static LUResult luDecomposition(const Matrix<T>& mat, bool pivoting = true);
 
+    /**
+     * LU decomposition with partial pivoting, where L and U are stored
+     * together in one matrix. This is the form to use for solving
+     * linear systems, see luPackedSolveInPlace.
+     * @param mat Square matrix.
+     * @return Packed LU decomposition.
+     */
+    template <class T>
+    static LUPackedResult luPacked(const Matrix<T>& mat);
+
+    /**
+     * Overwrites the square matrix a with its packed LU decomposition
+     * (partial pivoting). No memory is allocated if pivots has already
+     * the right size, which makes it suitable for repeated factorizations.
+     * @param a Input matrix, on return L and U.
+     * @param pivots On return, row k was swapped with row pivots[k] in step k.
+     * @param nbrRowSwaps On return, number of row swaps.
+     * @param pivotFloor Pivots with a magnitude below this value are replaced by +-pivotFloor.
+     *                   Used by inverse iterations, where the matrix is singular by intention.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return True if a pivot was zero (or had to be replaced), meaning the matrix is singular.
+     */
+    static bool luPackedInPlace(Matrix<double>& a, std::vector<size_t>& pivots, size_t& nbrRowSwaps, double pivotFloor = 0.0,
+                                size_t nbrOfThreads = 0);
+
+    /**
+     * Solves L*U*X = P*B in place for a packed LU decomposition.
+     * @param lu Packed LU matrix (n x n).
+     * @param pivots Row swaps of the decomposition.
+     * @param b Right hand sides (n x k), on return the solution X.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void luPackedSolveInPlace(const Matrix<double>& lu, const std::vector<size_t>& pivots, Matrix<double>& b, size_t nbrOfThreads = 0);
+
+    /**
+     * Solves A' * X = B in place for a packed LU decomposition of A.
+     * @param lu Packed LU matrix (n x n).
+     * @param pivots Row swaps of the decomposition.
+     * @param b Right hand sides (n x k), on return the solution X.
+     */
+    static void luPackedSolveTransposedInPlace(const Matrix<double>& lu, const std::vector<size_t>& pivots, Matrix<double>& b);
+
+    /**
+     * Cholesky decomposition A = L * L' of a symmetric positive definite matrix.
+     * Throws NotPositiveDefiniteException otherwise.
+     * @param mat Symmetric matrix. Only the lower triangle is read.
+     * @return Lower triangle matrix L.
+     */
+    template <class T>
+    static Matrix<double> cholesky(const Matrix<T>& mat);
+
+    /**
+     * Checks if a symmetric matrix is positive definite by attempting
+     * a Cholesky decomposition.
+     * @param mat Symmetric matrix. Only the lower triangle is read.
+     * @return True if positive definite.
+     */
+    template <class T>
+    static bool isPositiveDefinite(const Matrix<T>& mat);
+
+    /**
+     * Overwrites the symmetric matrix a with its Cholesky factor L, where A = L * L'.
+     * Blocked algorithm, where the panel and the trailing update are distributed on threads.
+     * Only the lower triangle of a is read. On return, L is in the lower triangle
+     * and the strict upper triangle is zero.
+     * @param a Symmetric input matrix, on return L.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return False if a is not positive definite. In this case a is only partially factorized.
+     */
+    static bool choleskyPackedInPlace(Matrix<double>& a, size_t nbrOfThreads = 0);
+
+    /**
+     * Solves L * L' * X = B in place.
+     * @param l Cholesky factor (n x n), see choleskyPackedInPlace.
+     * @param b Right hand sides (n x k), on return the solution X.
+     */
+    static void choleskyPackedSolveInPlace(const Matrix<double>& l, Matrix<double>& b);
+
+    /**
+     * Logarithm of the determinant of A = L * L'. Unlike the
+     * determinant itself, it does not overflow for large matrices.
+     * @param l Cholesky factor (n x n), see choleskyPackedInPlace.
+     * @return log(det(A))
+     */
+    static double choleskyLogDeterminant(const Matrix<double>& l);
+
+    /**
+     * Overwrites the symmetric matrix a with its LDL' decomposition A = L * D * L',
+     * where L is unit lower triangle and D diagonal. There is no pivoting, which is
+     * stable for definite matrices. Blocked and multithreaded like choleskyPackedInPlace.
+     * On return, L is in the strict lower triangle, D on the diagonal and the strict upper
+     * triangle is zero.
+     * @param a Symmetric input matrix, on return L and D.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return False if a zero pivot was encountered. In this case a is only partially factorized.
+     */
+    static bool ldltPackedInPlace(Matrix<double>& a, size_t nbrOfThreads = 0);
+
+    /**
+     * Solves L * D * L' * X = B in place.
+     * @param ld Packed LDL' decomposition (n x n), see ldltPackedInPlace.
+     * @param b Right hand sides (n x k), on return the solution X.
+     */
+    static void ldltPackedSolveInPlace(const Matrix<double>& ld, Matrix<double>& b);
+
+    /**
+     * Logarithm of the absolute determinant of A = L * D * L'.
+     * @param ld Packed LDL' decomposition (n x n), see ldltPackedInPlace.
+     * @param sign On return, the sign of the determinant.
+     * @return log(abs(det(A)))
+     */
+    static double ldltLogDeterminant(const Matrix<double>& ld, double& sign);
+
+    /**
+     * Solves T * X = B or T' * X = B in place, where T is a triangle matrix.
+     * The right hand sides are distributed on threads.
+     * @param t Square triangle matrix. Entries of the other triangle are not read.
+     * @param b Right hand sides (n x k), on return the solution X.
+     * @param lower True if T is lower triangle, false if upper triangle.
+     * @param transposed If true, T' * X = B is solved.
+     * @param unitDiagonal If true, the diagonal of T is assumed to be 1 and is not read.
+     */
+    static void triangularSolveInPlace(const Matrix<double>& t, Matrix<double>& b, bool lower, bool transposed = false, bool unitDiagonal = false);
+
     enum EigenMethod
     {
         PowerIterationAndHotellingsDeflation, //Power iteration and hotelling's deflation
         QRAlgorithm,                          // QR algorithm
+        DivideAndConquer,                     // Divide and conquer for symmetric matrices, otherwise QR algorithm
     };
 
     /**
      * Eigen decomposition of the matrix mat. Finds all Eigen pairs
-     * in symmetric real matrices. In non-symmetric matrices, it finds
-     * at least the most significant Eigen pair.
+     * in symmetric real matrices. In non-symmetric matrices, the QRAlgorithm
+     * method finds all real Eigen pairs (see eigenComplex for the complex ones)
+     * and PowerIterationAndHotellingsDeflation the most significant Eigen pair.
      * @param mat
      * @param method Eigen computation method to used.
      * @return Vector of Eigen pairs.
      */
     template <class T>
-    static std::vector<EigenPair> eigen(const Matrix<T>& mat, EigenMethod method = QRAlgorithm);
+    static std::vector<EigenPair> eigen(const Matrix<T>& mat, EigenMethod method = DivideAndConquer);
 
     /**
      * Eigen decomposition of 2x2 matrix.
@@ -217,6 +435,19 @@ public:
     template <class T>
     static EigenPair rayleighIteration(const Matrix<T>& mat, const Matrix<double>& initialEigenVector, double initialEigenValue, size_t maxIteration, double precision);
 
+    /**
+     * Batched Rayleigh iteration: refines each of the initial Eigen pairs. The
+     * pairs are distributed onto multiple threads, each thread reuses one workspace.
+     * @param mat Matrix of which to perform Eigen decomposition.
+     * @param initialPairs Initial Eigen vectors and Eigen values.
+     * @param maxIteration Maximum number of rayleigh iterations per pair.
+     * @param precision Rayleigh iteration stops when the Eigen value change is below the passed precision value
+     * @param nbrOfThreads Number of threads. 0 uses all hardware threads.
+     * @return Refined Eigen pairs, in the order of initialPairs.
+     */
+    template <class T>
+    static std::vector<EigenPair> rayleighIteration(const Matrix<T>& mat, const std::vector<EigenPair>& initialPairs, size_t maxIteration, double precision, size_t nbrOfThreads = 0);
+
     /**
      * Converges to Eigen pair with most significant Eigen value.
      * @param mat  Matrix of which to perform Eigen decomposition.
@@ -228,17 +459,126 @@ public:
     static EigenPair powerIteration(const Matrix<T>& mat, size_t maxIteration, double precision);
 
     /**
-     * The QR algorithm iteratively finds all Eigen values and Eigen vectors of a matrix
-     * by applying iteratively the QR decomposition.
-     * @param mat  Matrix of which to perform Eigen decomposition.
-     * @param maxIteration Maximum number of power iterations. If precision not reached, no Eigen pair was found.
-     * @param precision Power iteration stops when the Eigen value change is below the passed precision value
+     * Block power iteration (subspace iteration) for the k Eigen pairs of largest magnitude of
+     * a symmetric matrix. A block of slightly more than k vectors is multiplied by the matrix in
+     * each step, which reads the matrix once for all vectors. The block is orthonormalized and
+     * the Ritz pairs are extracted by Rayleigh-Ritz projection.
+     * @param mat Symmetric matrix.
+     * @param k Number of Eigen pairs.
+     * @param initialPairs Warm start: the Eigen vectors of a previous, similar problem. Can be empty.
+     * @param maxIteration Maximum number of iterations. If exceeded, unconverged pairs are not valid.
+     * @param precision Required residual norm |A*v - l*v|, relative to the largest Ritz value.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Eigen pairs, ordered by descending magnitude of the Eigen value.
+     */
+    template <class T>
+    static std::vector<EigenPair> subspaceIteration(const Matrix<T>& mat, size_t k, const std::vector<EigenPair>& initialPairs = std::vector<EigenPair>(),
+                                                    size_t maxIteration = 1000, double precision = 1e-10, size_t nbrOfThreads = 0);
+
+    /**
+     * The QR algorithm finds all Eigen values and Eigen vectors of a matrix. The matrix
+     * is reduced once to tridiagonal (symmetric) or Hessenberg form, followed by implicit
+     * QR sweeps with Wilkinson shifts (symmetric) or Francis double shifts. Converged
+     * Eigen values are deflated, so each sweep costs O(n) (O(n^2) with the Eigen vectors).
+     * Of non-symmetric matrices, only the real Eigen pairs are returned, see eigenComplex.
+     * @param mat  Square matrix of which to perform Eigen decomposition.
+     * @param maxIteration Maximum number of QR sweeps per Eigen value. If exceeded, the Eigen pairs are not valid.
+     * @param precision Deflation threshold, relative to the neighbouring diagonal entries. At least machine epsilon.
      * @param showProgress Prints the progress of the algorithm
      * @return Eigen pairs
      */
     template <class T>
     static std::vector<EigenPair> qrAlgorithm(const Matrix<T>& mat, size_t maxIteration, double precision, bool showProgress = false);
 
+    /**
+     * Eigen decomposition of a symmetric matrix: Householder tridiagonalization followed
+     * by Cuppen's divide and conquer method on the tridiagonal matrix. The two halves of
+     * each split are solved on separate threads, the merges solve the secular equations
+     * and form the Eigen vectors in parallel. Without Eigen vectors, the tridiagonal
+     * matrix is solved by the implicit QR algorithm in O(n^2).
+     * @param mat Symmetric matrix.
+     * @param computeVectors If false, only the Eigen values are computed.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Eigen values in ascending order and the Eigen vectors.
+     */
+    template <class T>
+    static SymmetricEigenResult symmetricEigen(const Matrix<T>& mat, bool computeVectors = true, size_t nbrOfThreads = 0);
+
+    /**
+     * Computes the k largest or smallest Eigen pairs of a symmetric matrix by the
+     * thick restart Lanczos method. See lanczosOperator.
+     * @param mat Symmetric matrix.
+     * @param k Number of Eigen pairs.
+     * @param largest If true, the largest Eigen values are computed, otherwise the smallest.
+     * @param precision Required residual norm |A*v - l*v|, relative to the largest Ritz value.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Eigen pairs, the largest (smallest) Eigen value first.
+     */
+    template <class T>
+    static std::vector<EigenPair> lanczos(const Matrix<T>& mat, size_t k, bool largest = true, double precision = 1e-10, size_t nbrOfThreads = 0);
+
+    /**
+     * Computes the k largest or smallest Eigen pairs of a symmetric operator by the
+     * thick restart Lanczos method (Wu and Simon). The operator is only accessed by
+     * matrix vector products, so it can be a dense, sparse or implicitly given matrix.
+     * A Krylov basis of max(2k + 1, k + 20) vectors is kept and fully reorthogonalized.
+     * At each restart, the wanted Ritz vectors are kept and the basis is extended again.
+     * @param op Functor with signature void(const Matrix<double>& x, Matrix<double>& y),
+     *           which computes y = A * x. x and y are n x 1.
+     * @param n Dimension of the operator.
+     * @param k Number of Eigen pairs.
+     * @param largest If true, the largest Eigen values are computed, otherwise the smallest.
+     * @param precision Required residual norm |A*v - l*v|, relative to the largest Ritz value.
+     * @param maxRestarts Maximum number of restarts. If exceeded, unconverged pairs are not valid.
+     * @param nbrOfThreads Maximum number of threads for the basis operations. 0 means Parallel::defaultNbrOfThreads().
+     * @return Eigen pairs, the largest (smallest) Eigen value first.
+     */
+    template <class F>
+    static std::vector<EigenPair> lanczosOperator(F op, size_t n, size_t k, bool largest = true, double precision = 1e-10,
+                                                  size_t maxRestarts = 300, size_t nbrOfThreads = 0);
+
+    /**
+     * Eigen decomposition of a general square matrix, including complex Eigen values.
+     * Complex Eigen values appear in conjugate pairs, the positive imaginary part first.
+     * The Eigen vectors are normalized to length 1 and the Eigen vectors of real Eigen
+     * values have a positive largest component.
+     * @param mat Square matrix.
+     * @param maxIteration Maximum number of QR sweeps per Eigen value.
+     * @return Eigen pairs, in the order of the diagonal of the Schur form.
+     */
+    template <class T>
+    static std::vector<ComplexEigenPair> eigenComplex(const Matrix<T>& mat, size_t maxIteration = 100);
+
+    /**
+     * Reduces a square matrix to upper Hessenberg form by Householder reflections.
+     * @param mat Square matrix.
+     * @param computeQ If false, the orthogonal matrix Q is not formed.
+     * @return H and Q, where mat = Q * H * Q'.
+     */
+    template <class T>
+    static HessenbergResult hessenberg(const Matrix<T>& mat, bool computeQ = true);
+
+    /**
+     * Reduces a symmetric matrix to tridiagonal form by Householder reflections,
+     * which applied from both sides cost half of the Hessenberg reduction.
+     * @param mat Symmetric matrix.
+     * @param computeQ If false, the orthogonal matrix Q is not formed.
+     * @return Diagonal and off-diagonal of T and Q, where mat = Q * T * Q'.
+     */
+    template <class T>
+    static TridiagonalResult tridiagonalization(const Matrix<T>& mat, bool computeQ = true);
+
+    /**
+     * Real Schur decomposition by the Francis double shift QR algorithm.
+     * Complex Eigen values remain as 2x2 blocks on the diagonal of T,
+     * real Eigen values in 2x2 blocks are split.
+     * @param mat Square matrix.
+     * @param maxIteration Maximum number of QR sweeps per Eigen value.
+     * @return T and Q, where mat = Q * T * Q'.
+     */
+    template <class T>
+    static SchurResult schur(const Matrix<T>& mat, size_t maxIteration = 100);
+
     /**
      * Compute Rayleigh quotient of a matrix and a vector. This can be
      * used to find the Eigenvalue to a corresponding Eigenvector and
@@ -270,20 +610,51 @@ public:
     template <class T>
     static Matrix<double> householderMatrix(const Matrix<T>& v, double b);
 
+    /**
+     * Applies the Householder reflection P = I - b*v*v' from the left to the
+     * block of a, which starts at (row, col) and has as many rows as v:
+     * A(row:row+k, col:n) = P * A(row:row+k, col:n).
+     * The work is O(k*n) and P is not formed.
+     * @param a Matrix, modified in place.
+     * @param v Householder vector (k x 1).
+     * @param b Scalar value. If not finite, a is not modified (P = I).
+     * @param row First row of the block.
+     * @param col First column of the block.
+     */
+    static void applyHouseholderLeft(Matrix<double>& a, const Matrix<double>& v, double b, size_t row = 0, size_t col = 0);
+
+    /**
+     * Applies the Householder reflection P = I - b*v*v' from the right to the
+     * block of a, which starts at (row, col) and has as many columns as v:
+     * A(row:m, col:col+k) = A(row:m, col:col+k) * P.
+     * The work is O(m*k) and P is not formed.
+     * @param a Matrix, modified in place.
+     * @param v Householder vector (k x 1).
+     * @param b Scalar value. If not finite, a is not modified (P = I).
+     * @param row First row of the block.
+     * @param col First column of the block.
+     */
+    static void applyHouseholderRight(Matrix<double>& a, const Matrix<double>& v, double b, size_t row = 0, size_t col = 0);
+
     /**
      * Bidiagonalization of a Matrix A, so that
      * U'*A*V = B,
-     * where B is bidiagonal.
-     * @param a Input matrix.
+     * where B is upper bidiagonal. The reduction is blocked (LAPACK xGEBRD): the
+     * reflectors of a panel are collected and the trailing matrix is updated by
+     * two matrix products. U and V are formed from the stored reflectors.
+     * @param a Input matrix with at least as many rows as columns.
+     * @param computeU If false, U is not formed and empty.
+     * @param computeV If false, V is not formed and empty.
      * @return Diagonalization result.
      */
     template <class T>
-    static DiagonalizationResult bidiagonalization(const Matrix<T>& a);
+    static DiagonalizationResult bidiagonalization(const Matrix<T>& a, bool computeU = true, bool computeV = true);
 
     enum QRMethod
     {
         Householder, /* Householder reflection */
-        Givens       /* Givens rotation */
+        Givens,      /* Givens rotation */
+        TSQR         /* Tall skinny QR on row blocks. Q is thin (m x n) and R is n x n */
     };
 
     /**
@@ -329,14 +700,181 @@ public:
     template <class T>
     static QRResult qrSignModifier(const Matrix<T>& q, const Matrix<T>& r, size_t row);
 
+    /**
+     * Householder QR decomposition, where Q is not formed but kept as the
+     * sequence of its reflectors. This is the form to use for least
+     * squares problems and tall matrices, since Q would be m x m.
+     * @param mat Matrix A (m x n).
+     * @return Packed QR decomposition.
+     */
+    template <class T>
+    static QRPackedResult qrPacked(const Matrix<T>& mat);
+
+    /**
+     * Overwrites a with its packed QR decomposition, see qrPacked.
+     * @param a Input matrix (m x n), on return R and the reflectors.
+     * @param tau On return, min(m,n) reflector factors.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void qrPackedInPlace(Matrix<double>& a, std::vector<double>& tau, size_t nbrOfThreads = 0);
+
+    /**
+     * Computes Q' * B in place without forming Q.
+     * @param qr Packed QR matrix (m x n).
+     * @param tau Reflector factors.
+     * @param b Matrix (m x k), on return Q' * B.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void qrPackedApplyQTransposedInPlace(const Matrix<double>& qr, const std::vector<double>& tau, Matrix<double>& b, size_t nbrOfThreads = 0);
+
+    /**
+     * Computes Q * B in place without forming Q.
+     * @param qr Packed QR matrix (m x n).
+     * @param tau Reflector factors.
+     * @param b Matrix (m x k), on return Q * B.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void qrPackedApplyQInPlace(const Matrix<double>& qr, const std::vector<double>& tau, Matrix<double>& b, size_t nbrOfThreads = 0);
+
+    /**
+     * Forms the first columns of Q.
+     * @param qr Packed QR matrix (m x n).
+     * @param tau Reflector factors.
+     * @param economy If true, the thin Q (m x min(m,n)) is returned, otherwise the full Q (m x m).
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Q
+     */
+    static Matrix<double> qrPackedQ(const Matrix<double>& qr, const std::vector<double>& tau, bool economy = true, size_t nbrOfThreads = 0);
+
+    /**
+     * Extracts R.
+     * @param qr Packed QR matrix (m x n).
+     * @param economy If true, the square R (min(m,n) x n) is returned, otherwise R is m x n.
+     * @return R
+     */
+    static Matrix<double> qrPackedR(const Matrix<double>& qr, bool economy = true);
+
+    /**
+     * Tall skinny QR decomposition (TSQR) of a matrix with many more rows
+     * than columns. The rows are split into blocks, which are decomposed
+     * in parallel. Their R factors are combined pairwise in a reduction tree.
+     * R may have negative diagonal elements.
+     * @param mat Matrix A (m x n).
+     * @param computeQ If true, the thin Q (m x n) is reconstructed from the tree. Otherwise Q is empty.
+     * @param rowBlockSize Minimal number of rows per block. 0 chooses it by the number of threads.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Thin Q (m x n) and R (n x n). If m < n, Q is m x m and R is m x n.
+     */
+    template <class T>
+    static QRResult tsqr(const Matrix<T>& mat, bool computeQ = false, size_t rowBlockSize = 0, size_t nbrOfThreads = 0);
+
+    /**
+     * QR decomposition of a matrix, which is passed in chunks of rows,
+     * e.g. when it does not fit into memory. Only the n x n factor R is
+     * kept. Appending the right hand sides as additional columns gives
+     * Q' * b in the last columns of R, which solves least squares problems.
+     */
+    class StreamingQR
+    {
+    public:
+        /**
+         * @param cols Number of columns of the matrix.
+         */
+        explicit StreamingQR(size_t cols)
+        : m_cols(cols), m_rows(0), m_r(0, cols)
+        {
+        }
+
+        /**
+         * Adds the next rows of the matrix. Large chunks are
+         * decomposed with tsqr.
+         * @param rows Chunk of rows (k x cols).
+         */
+        template <class T>
+        void addRows(const Matrix<T>& rows);
+
+        /**
+         * @return Upper triangle factor R (min(rows, cols) x cols) of all rows added so far.
+         */
+        const Matrix<double>& R() const
+        {
+            return m_r;
+        }
+
+        /**
+         * @return Number of rows added so far.
+         */
+        size_t rows() const
+        {
+            return m_rows;
+        }
+
+    private:
+        size_t         m_cols;
+        size_t         m_rows;
+        Matrix<double> m_r;
+    };
+
+    /**
+     * Rank revealing QR decomposition with column pivoting, such that
+     * A * P = Q * R. In each step, the remaining column with the largest
+     * norm is chosen, so the magnitude of the diagonal elements of R is
+     * non-increasing. The number of diagonal elements above the tolerance
+     * is the numerical rank.
+     * @param mat Matrix A
+     * @param tolerance Diagonal elements of R with a magnitude below or equal this value count as zero.
+     *                  A negative value selects max(m,n) * eps * |R(0,0)|.
+     * @param computeQ If false, Q is not accumulated and returned empty.
+     * @return QRCP decomposition
+     */
+    template <class T>
+    static QRCPResult qrColumnPivoting(const Matrix<T>& mat, double tolerance = -1.0, bool computeQ = true);
+
+    /**
+     * Orthonormal basis of the range (column space) of the matrix A.
+     * @param mat Matrix A (m x n)
+     * @param tolerance Rank tolerance, see qrColumnPivoting.
+     * @return m x rank matrix with orthonormal columns.
+     */
+    template <class T>
+    static Matrix<double> rangeSpace(const Matrix<T>& mat, double tolerance = -1.0);
+
+    /**
+     * Orthonormal basis of the null space of the matrix A, A * N = 0.
+     * @param mat Matrix A (m x n)
+     * @param tolerance Rank tolerance, see qrColumnPivoting.
+     * @return n x (n - rank) matrix with orthonormal columns.
+     */
+    template <class T>
+    static Matrix<double> nullSpace(const Matrix<T>& mat, double tolerance = -1.0);
+
+    enum SVDMode
+    {
+        FullSVD,                 // U is m x m, S is m x n and V is n x n
+        ThinSVD,                 // U is m x k, S is k x k and V is n x k, where k = min(m, n)
+        SingularValuesOnly,      // S is k x k, U and V are empty
+        LeftSingularVectorsOnly, // U is m x k, S is k x k and V is empty
+        RightSingularVectorsOnly // S is k x k, V is n x k and U is empty
+    };
+
     /**
      * Performs a singular value decomposition of the
      * passed matrix mat.
      * @param mat Passed matrix.
+     * @param mode Which parts are computed. The singular vectors, which are not
+     *             requested, are not accumulated at all.
      * @return SVD decomposition
      */
     template <class T>
-    static SVDResult svd(const Matrix<T>& mat);
+    static SVDResult svd(const Matrix<T>& mat, SVDMode mode = FullSVD);
+
+    /**
+     * Singular values of the matrix mat, see svd with SingularValuesOnly.
+     * @param mat Passed matrix.
+     * @return The min(m, n) singular values in descending order.
+     */
+    template <class T>
+    static std::vector<double> singularValues(const Matrix<T>& mat);
 
     /**
      * Performs a singular value decomposition of the
@@ -351,364 +889,191 @@ public:
     /**
      * Performs a singular value decomposition of the
      * passed matrix mat. The method applied is the
-     * Golub and Kahan algorithm.
+     * Golub and Kahan algorithm. Matrices with many more rows than
+     * columns are reduced to a triangle matrix by QR first.
      * @param mat Passed matrix.
+     * @param mode Which parts are computed, see SVDMode.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
      * @return SVD decomposition
      */
     template <class T>
-    static SVDResult svdGolubKahan(const Matrix<T>& mat);
+    static SVDResult svdGolubKahan(const Matrix<T>& mat, SVDMode mode = FullSVD, size_t nbrOfThreads = 0);
 
-    struct SvdStepResult
-    {
-        Matrix<double> u;
-        Matrix<double> v;
-    };
+    /**
+     * Performs a singular value decomposition of the passed matrix
+     * mat by the one-sided Jacobi method. Pairs of columns are
+     * rotated until they are orthogonal, the disjoint pairs of a
+     * round-robin schedule in parallel. It is slower than svdGolubKahan
+     * for large matrices, but computes also the small singular values
+     * to high relative accuracy, e.g. those of graded matrices.
+     * Matrices with many more rows than columns are reduced by QR first.
+     * @param mat Passed matrix.
+     * @param mode Which parts are computed, see SVDMode.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return SVD decomposition
+     */
+    template <class T>
+    static SVDResult svdJacobi(const Matrix<T>& mat, SVDMode mode = FullSVD, size_t nbrOfThreads = 0);
 
-    static SvdStepResult svdStepGolubKahan(Matrix<double>& b)
-    {
-        // b is an upper bidiagonal matrix
+    /**
+     * Randomized truncated singular value decomposition (Halko, Martinsson
+     * and Tropp). The range of A is sampled by A * G with a Gaussian matrix G of
+     * rank + oversampling columns, refined by power iterations and
+     * orthonormalized to Q. The small matrix Q' * A is decomposed exactly.
+     * The products with A are multithreaded matrix products.
+     * @param mat Matrix A (m x n).
+     * @param rank Number of singular triplets, at most min(m, n).
+     * @param oversampling Additional samples, which improve the accuracy.
+     * @param nbrOfPowerIterations Each iteration costs two passes over A and
+     *        sharpens the result if the singular values decay slowly.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Thin SVD with U (m x rank), S (rank x rank) and V (n x rank).
+     */
+    template <class T>
+    static SVDResult svdRandomized(const Matrix<T>& mat, size_t rank, size_t oversampling = 10,
+                                   size_t nbrOfPowerIterations = 2, size_t nbrOfThreads = 0);
 
-        size_t m = b.rows();
-        size_t n = b.cols();
+    /**
+     * Randomized truncated singular value decomposition of a matrix A, which
+     * is read in blocks of rows, e.g. from a file or generated on the fly.
+     * A is passed 2 + 2 * nbrOfPowerIterations times and never held in memory
+     * as a whole. See svdRandomized.
+     * @param rowBlock Functor with signature void(size_t firstRow, Matrix<double>& block).
+     *        It fills the passed block with the rows of A starting at firstRow.
+     *        The block has the number of rows to read and n columns.
+     * @param m Number of rows of A.
+     * @param n Number of columns of A.
+     * @param rank Number of singular triplets, at most min(m, n).
+     * @param oversampling Additional samples, which improve the accuracy.
+     * @param nbrOfPowerIterations Number of power iterations.
+     * @param rowBlockSize Rows per block. 0 chooses blocks of about 8 MB.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Thin SVD with U (m x rank), S (rank x rank) and V (n x rank).
+     */
+    template <class F>
+    static SVDResult svdRandomizedStreamed(F rowBlock, size_t m, size_t n, size_t rank, size_t oversampling = 10,
+                                           size_t nbrOfPowerIterations = 2, size_t rowBlockSize = 0,
+                                           size_t nbrOfThreads = 0);
 
-        // lower right 2x2 submatrix - eigen decomposition   -> special case when 2x2 mat
-        double d11 = std::pow(b(m-2, m-2), 2.0);
-        if( m > 2 )
-            d11 += std::pow(b(m-3, m-2), 2.0);
-
-        double od = b(m-2, m-2) * b(m-2, m-1);
-        double d22 = std::pow(b(m-1, m-1), 2.0) + std::pow(b(m-2, m-1), 2.0);
-
-        Matrix<double> t_minor(2,2);
-        t_minor(0, 0) = d11; t_minor(0, 1) = od;
-        t_minor(1, 0) = od;  t_minor(1, 1) = d22;
-        std::vector<Decomposition::EigenPair> eig = Decomposition::eigen(t_minor);
-
-        // choose eigen value closer to tnn
-        double l;
-        double l1 = eig.at(0).L;
-        double l2 = eig.at(1).L;
-        double tnn = t_minor(1, 1);
-        if (std::abs(tnn - l1) < std::abs(tnn - l2))
-            l = l1;
-        else
-            l = l2;
+    /**
+     * Updates the thin SVD A = U * S * V' to the one of [A C], where C are
+     * new columns (Brand's incremental SVD). The part of C orthogonal to U is
+     * orthonormalized to J, and only the small matrix [S U'C; 0 J'C] is
+     * decomposed. The cost is linear in the size of A, so that columns can be
+     * appended in batches without recomputing the whole decomposition. The
+     * small SVD grows cubically with p: batches of a few times k columns are
+     * most efficient.
+     * @param svd Thin SVD of A: U (m x k), S (k x k) and V (n x k).
+     * @param columns New columns C (m x p).
+     * @param rank Rank of the returned truncated SVD. 0 keeps k.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Thin SVD of [A C], truncated to rank.
+     */
+    static SVDResult svdAppendColumns(const SVDResult& svd, const Matrix<double>& columns, size_t rank = 0, size_t nbrOfThreads = 0);
 
-        // use eigenvalue to perform the first Givens rotation
-        double y = std::pow(b(0, 0), 2.0) - l;
-        double z = b(0, 0) * b(0, 1);
+    /**
+     * Updates the thin SVD A = U * S * V' to the one of [A; R], where R are
+     * new rows. See svdAppendColumns.
+     * @param svd Thin SVD of A: U (m x k), S (k x k) and V (n x k).
+     * @param rows New rows R (q x n).
+     * @param rank Rank of the returned truncated SVD. 0 keeps k.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Thin SVD of [A; R], truncated to rank.
+     */
+    static SVDResult svdAppendRows(const SVDResult& svd, const Matrix<double>& rows, size_t rank = 0, size_t nbrOfThreads = 0);
 
-        Matrix<double> vR = Matrix<double>::identity(n);
-        Matrix<double> uL = Matrix<double>::identity(m);
+    /**
+     * Downdates the thin SVD A = U * S * V' to the one of A without the columns
+     * [firstColumn, firstColumn + nbrOfColumns), e.g. to keep a sliding window
+     * over old columns. The remaining rows of V are orthonormalized by QR and
+     * the small matrix S * R' is decomposed.
+     * @param svd Thin SVD of A: U (m x k), S (k x k) and V (n x k).
+     * @param firstColumn First column to remove.
+     * @param nbrOfColumns Number of columns to remove.
+     * @param rank Rank of the returned truncated SVD. 0 keeps k.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Thin SVD of the remaining columns, truncated to rank.
+     */
+    static SVDResult svdRemoveColumns(const SVDResult& svd, size_t firstColumn, size_t nbrOfColumns, size_t rank = 0,
+                                      size_t nbrOfThreads = 0);
 
-        for (size_t k = 0; k < n - 1; k++)
-        {
-            Matrix<double> gr = applyGivensRotationRowDirection(b, y, z, k, k, k + 1);
-            vR = vR * gr;
+    static Decomposition::SVDResult svdGolubKahanBidiagonal(Matrix<double>& b)
+    {
+        // b is an upper bidiagonal matrix with at least as many rows as columns. The
+        // rotations are accumulated in place, in the rows of the transposed U and V.
+        size_t m = b.rows();
+        size_t n = b.cols();
+        if (m < n)
+            throw InvalidInputException();
+
+        std::vector<double> d(n);
+        std::vector<double> e(n > 0 ? n - 1 : 0);
+        for (size_t k = 0; k < n; k++)
+            d[k] = b(k, k);
+        for (size_t k = 0; k + 1 < n; k++)
+            e[k] = b(k, k + 1);
+
+        Matrix<double> ut = Matrix<double>::identity(m);
+        Matrix<double> vt = Matrix<double>::identity(n);
+        if (!bidiagonalQRInPlace(d, e, &ut, &vt))
+            throw SVDFailedException();
+
+        b.fill(0.0);
+        for (size_t k = 0; k < n; k++)
+            b(k, k) = d[k];
+
+        return SVDResult(ut.transpose(), b, vt.transpose());
+    }
 
-            y = b(k, k);
-            z = b(k + 1, k);
+    static Decomposition::SVDResult sortSingularValues(const Decomposition::SVDResult& svdRes)
+    {
+        Matrix<double> u = svdRes.U;
+        Matrix<double> s = svdRes.S;
+        Matrix<double> v = svdRes.V;
 
-            Matrix<double> gl = applyGivensRotatioColumnDirection(b, y, z, k, k, k + 1);
-            uL = gl * uL;
+        size_t m = s.rows();
 
-            if (k < n - 1)
+        // perform bubble sort on s
+        bool altered = true;
+        while(altered)
+        {
+            altered = false;
+            for(size_t k = 0; k < m-1; k++)
             {
-                // set the values for the next column
-                y = b(k, k + 1);
-                z = b(k, k + 2);
+                if( s(k, k) < s(k+1, k+1) )
+                {
+                    // swap k and k+1
+                    altered = true;
+
+                    double sk = s(k, k);
+                    s(k, k) = s(k+1, k+1);
+                    s(k+1, k+1) = sk;
+
+                    u.swapCols(k, k+1);
+                    v.swapCols(k, k+1);
+                }
             }
-        }
 
-        SvdStepResult res;
-        res.v = vR;
-        res.u = uL;
+        }
 
-        return res;
+        Decomposition::SVDResult sortedRes(u, s, v);
+        return sortedRes;
     }
 
-    /*
-     *  Example matrix n = 5
-     *
-     *      d   0   0   0   0
-     *      0   d   f   0   0
-     *      0   0   d   0   0
-     *      0   0   0   d   0
-     *      0   0   0   0   d
-     *
-     *    |  p |       |  q   |
+
+    /**
+     * Computes the given rotation based on a and b as input. See
+     * the article https://en.wikipedia.org/wiki/Givens_rotation#Stable_calculation
+     * @param a First number
+     * @param b Second number -> Givens Rotation will zero b!
+     * @return Givens Rotation parameters
      */
-    static void svdCheckMatrixGolubKahan(const Matrix<double>& mat, size_t& p, size_t& q)
+    static GivensRotation givensRotation(double a, double b)
     {
-        double tol = 100.0 * std::numeric_limits<double>::epsilon();
-        size_t n = mat.cols();
+        // based on https://en.wikipedia.org/wiki/Givens_rotation#Stable_calculation
 
-        // find q - diagonality from back
-        q = 0;
-        for( size_t i = 0; i < n; i++ )
-        {
-            size_t x = (n - 1) - i;
-            size_t y = (n - 1) - i - 1;
-
-            if( x == 0 )
-            {
-                // first diagonal entry  does not have an upper element
-                q++;
-                break;
-            }
-            else if( std::abs(mat(y,x)) < std::numeric_limits<double>::epsilon() ) // small upper band values were already set to 0.0
-            {
-                // still diagonal
-                q++;
-            }
-            else
-            {
-                // stop - not anymore diagonal, as upper diagonal element not zero.
-                break;
-            }
-        }
-
-        p = n - q;
-        for( size_t i = q; i < n; i++ )
-        {
-            size_t x = (n - 1) - i;
-            size_t y = (n - 1) - i - 1;
-
-            if( x == 0 )
-            {
-                // first diagonal entry  does not have an upper element
-                p--;
-                break;
-            }
-            else if( std::abs(mat(y, x)) > 0.0 )
-            {
-                // still not diagonal again
-                p--;
-            }
-            else
-            {
-                // stop - upper element is 0. However, this belongs to B22 too
-                p--;
-                break;
-            }
-        }
-
-    }
-
-    /*
-    *  Example matrix n = 5 (p=2,q=1)
-    *
-    *      1   0   0   0   0
-    *      0   1   0   0   0
-    *      0   0   m   m   0
-    *      0   0   m   m   0
-    *      0   0   0   0   1
-    *
-    *    |   p   |       | q |
-    */
-    static Matrix<double> svdPaddingRotation(const Matrix<double>& mat, size_t p, size_t q)
-    {
-        Matrix<double> padded = Matrix<double>::identity( mat.cols() + p + q );
-        padded.setSubMatrix(p,p,mat);
-        return padded;
-    }
-
-
-
-    // Chapter 8, p. 490 -> If dk = 0 for some k < n, then premultiplication by a sequence of
-    //                      Givens transformations can zero fk.
-    static Matrix<double> svdZeroRow(Matrix<double>& b, size_t row)
-    {
-        size_t n = b.cols();
-
-        Matrix<double> u_left = Matrix<double>::identity(b.rows());
-        for( size_t i = row ; i < (n-1); i++ )
-        {
-
-            Matrix<double> uS = Decomposition::applyGivensRotatioColumnDirection(b, i+1, i+1, row);
-            u_left = uS * u_left;
-        }
-
-        return u_left;
-    }
-
-
-    static Matrix<double> svdZeroColumn(Matrix<double> &b, size_t column)
-    {
-        Matrix<double> v_right = Matrix<double>::identity(b.cols());
-        for( size_t i = 1; i <= column; i++ )
-        {
-            Matrix<double> vS = Decomposition::applyGivensRotationRowDirection(b, column-i, column-i, column);
-            v_right = v_right * vS;
-        }
-
-        return v_right;
-    }
-
-    static SvdStepResult svdHandleZeroDiagonalEntries( Matrix<double>& b, size_t p, size_t q, bool& modified)
-    {
-        double bNorm = b.normInf();
-        double tol = bNorm * std::numeric_limits<double>::epsilon();
-        size_t n = b.cols();
-
-        SvdStepResult ret;
-        ret.v = Matrix<double>::identity(b.cols());
-        ret.u = Matrix<double>::identity(b.rows());
-
-        for( size_t r = p; r < n - q && !modified; r++ )
-        {
-            // if any diagonal entry in B22 is zero, then zero the
-            // superdiagonal entry in the same row.
-            if( std::abs(b(r,r)) < tol )
-            {
-                if( r < (n-1-q) )
-                {
-                    ret.u = svdZeroRow(b, r);
-                }
-                else
-                {
-                    // special case: last diagonal element of b22
-                    ret.v = svdZeroColumn(b, r);
-                }
-
-                modified = true;
-            }
-        }
-
-        return ret;
-    };
-
-    static Decomposition::SVDResult svdGolubKahanBidiagonal(Matrix<double>& b)
-    {
-        double eps = std::numeric_limits<double>::epsilon() ;
-
-        size_t m = b.rows();
-        size_t n = b.cols();
-
-        std::vector<Matrix<double>> uLeftV;
-        std::vector<Matrix<double>> vRightV;
-
-        // svd step
-        size_t q = 0;
-        int maxIter = 100000;
-        while( q != n && maxIter > 0)
-        {
-            maxIter--;
-
-            // go through the upper band and zero values close to zero
-            for(size_t r = 0; r < n-1; r++)
-            {
-                // close to zero -> consider the magnitude of the two diagonal elements
-                //                  or the magnitude of the upper band element itself.
-                // Note: The second check is very important -> having a lower value than
-                //       10000 does often not work. This is quite ugly!
-                double mag_bandelement = std::abs(b(r,r+1));
-                if(mag_bandelement < 10.0 * eps * (std::abs(b(r,r)) + std::abs(b(r+1,r+1)) )  ||
-                   mag_bandelement < 10000.0 * eps)
-                {
-                    b(r,r+1) = 0.0;
-                }
-            }
-
-            size_t p;
-            svdCheckMatrixGolubKahan(b, p, q);
-
-            if( q < n )
-            {
-                bool modified = false;
-
-                // check B22 (middle matrix) for zero diagonal element
-                Decomposition::SvdStepResult extraRotations = Decomposition::svdHandleZeroDiagonalEntries(b,p,q, modified);
-                if( modified )
-                {
-                    vRightV.push_back(extraRotations.v);
-                    uLeftV.push_back(extraRotations.u);
-                }
-                else
-                {
-                    size_t subMatSize = n-q-p;
-                    Matrix<double> b22 = b.subMatrix(p,p,subMatSize,subMatSize);
-                    Decomposition::SvdStepResult step = Decomposition::svdStepGolubKahan(b22);
-
-                    Matrix<double> paddedV = Decomposition::svdPaddingRotation(step.v,p,q);
-                    Matrix<double> paddedU = Decomposition::svdPaddingRotation(step.u,p,q); // adapt here for non quadratic matrix
-
-                    // copy b22 back into b
-                    b.setSubMatrix(p,p,b22);
-
-                    // is equal to b.setSubMatrix(p,p,b22);
-                    Matrix<double> k = paddedU * b * paddedV;
-
-                    vRightV.push_back(paddedV);
-                    uLeftV.push_back(paddedU);
-                }
-            }
-
-        }
-
-        Matrix<double> u_left_accum = Matrix<double>::identity(b.rows());
-        Matrix<double> v_right_accum = Matrix<double>::identity(b.cols());
-        for( size_t k = 0; k < uLeftV.size(); k++ )
-        {
-            v_right_accum = v_right_accum * vRightV.at(k);
-            u_left_accum = uLeftV.at(k) * u_left_accum;
-        }
-
-        Matrix<double> u = u_left_accum.transpose();
-        Matrix<double> v = v_right_accum;
-
-        return SVDResult(u,b,v);
-    }
-
-    static Decomposition::SVDResult sortSingularValues(const Decomposition::SVDResult& svdRes)
-    {
-        Matrix<double> u = svdRes.U;
-        Matrix<double> s = svdRes.S;
-        Matrix<double> v = svdRes.V;
-
-        size_t m = s.rows();
-
-        // perform bubble sort on s
-        bool altered = true;
-        while(altered)
-        {
-            altered = false;
-            for(size_t k = 0; k < m-1; k++)
-            {
-                if( s(k, k) < s(k+1, k+1) )
-                {
-                    // swap k and k+1
-                    altered = true;
-
-                    double sk = s(k, k);
-                    s(k, k) = s(k+1, k+1);
-                    s(k+1, k+1) = sk;
-
-                    u.swapCols(k, k+1);
-                    v.swapCols(k, k+1);
-                }
-            }
-
-        }
-
-        Decomposition::SVDResult sortedRes(u, s, v);
-        return sortedRes;
-    }
-
-
-    /**
-     * Computes the given rotation based on a and b as input. See
-     * the article https://en.wikipedia.org/wiki/Givens_rotation#Stable_calculation
-     * @param a First number
-     * @param b Second number -> Givens Rotation will zero b!
-     * @return Givens Rotation parameters
-     */
-    static GivensRotation givensRotation(double a, double b)
-    {
-        // based on https://en.wikipedia.org/wiki/Givens_rotation#Stable_calculation
-
-        GivensRotation res;
-        if (std::abs(b) > std::numeric_limits<double>::epsilon())
+        GivensRotation res;
+        if (std::abs(b) > std::numeric_limits<double>::epsilon())
         {
             double h = std::hypot(a, b); // no precession problem
             double d = 1.0 / h;
@@ -800,15 +1165,7 @@ public:
     static Matrix<double> applyGivensRotatioColumnDirection(Matrix<double> &mat, double a, double b,  size_t col, size_t a_row, size_t b_row)
     {
         Matrix<double> g = givensRotatioColumnDirection(a, b, mat.rows(), col, a_row, b_row);
-
-        for(size_t n = 0; n < mat.cols(); n++)
-        {
-            double e0 = g(a_row, a_row) * mat(a_row, n) + g(a_row, b_row) * mat(b_row, n);
-            double e1 = g(b_row, a_row) * mat(a_row, n) + g(b_row, b_row) * mat(b_row, n);
-
-            mat(a_row, n) = e0;
-            mat(b_row, n) = e1;
-        }
+        applyGivensRotationToRows(mat, givensRotation(a, b), a_row, b_row);
 
         return g;
     }
@@ -886,23 +1243,229 @@ public:
      */
     static Matrix<double> applyGivensRotationRowDirection(Matrix<double> &mat, double a, double b, size_t row, size_t a_col, size_t b_col)
     {
-        Matrix<double> g = givensRotationRowDirection(a, b, mat.rows(), row, a_col, b_col);
-
-        for(size_t m = 0; m < mat.rows(); m++)
-        {
-            double e1 = mat(m, a_col) * g(a_col, a_col) + mat(m, b_col) * g(b_col, a_col);
-            double e2 = mat(m, a_col) * g(a_col, b_col) + mat(m, b_col) * g(b_col, b_col);
-            mat(m, a_col) = e1;
-            mat(m, b_col) = e2;
-        }
+        Matrix<double> g = givensRotationRowDirection(a, b, mat.cols(), row, a_col, b_col);
+        applyGivensRotationToColumns(mat, givensRotation(a, b), a_col, b_col);
 
         return g;
     }
 
+    /**
+     * Applies the Givens rotation g in place to the two rows a_row and b_row of mat:
+     * row a = C * row a - S * row b, row b = S * row a + C * row b.
+     * This equals givensRotatioColumnDirection(..) * mat, but costs O(n)
+     * and touches only the two rows.
+     * @param mat Input/Output matrix.
+     * @param g Givens rotation, see givensRotation.
+     * @param a_row Plane a index.
+     * @param b_row Plane b index.
+     * @param colBegin Columns left of colBegin are not touched, e.g. because they are zero.
+     */
+    static void applyGivensRotationToRows(Matrix<double>& mat, const GivensRotation& g, size_t a_row, size_t b_row, size_t colBegin = 0)
+    {
+        size_t n = mat.cols();
+        if (std::max(a_row, b_row) >= mat.rows() || colBegin > n)
+            throw InvalidInputException();
+
+        Kernels::rot(mat.data() + a_row * n + colBegin, mat.data() + b_row * n + colBegin, n - colBegin, g.C, g.S);
+    }
+
+    /**
+     * Applies the Givens rotation g in place to the two columns a_col and b_col of mat:
+     * col a = C * col a - S * col b, col b = S * col a + C * col b.
+     * This equals mat * givensRotationRowDirection(..), but costs O(m)
+     * and touches only the two columns.
+     * @param mat Input/Output matrix.
+     * @param g Givens rotation, see givensRotation.
+     * @param a_col Plane a index.
+     * @param b_col Plane b index.
+     * @param rowBegin Rows above rowBegin are not touched.
+     */
+    static void applyGivensRotationToColumns(Matrix<double>& mat, const GivensRotation& g, size_t a_col, size_t b_col, size_t rowBegin = 0)
+    {
+        size_t n = mat.cols();
+        if (std::max(a_col, b_col) >= n || rowBegin > mat.rows())
+            throw InvalidInputException();
+
+        Kernels::rot(mat.data() + rowBegin * n + a_col, mat.data() + rowBegin * n + b_col, mat.rows() - rowBegin, g.C, g.S, n);
+    }
+
 private:
     template <class T>
     static LUResult doolittle(const Matrix<T>& a, bool pivoting);
 
+    static bool symmetricFactorInPlace(Matrix<double>& a, bool ldlt, size_t nbrOfThreads);
+
+    static void makeDiagonalPositive(QRResult& res);
+
+    // QR of the matrix [top; bottom]: returns R and keeps the packed decomposition
+    static Matrix<double> stackedQR(const Matrix<double>& top, const Matrix<double>& bottom, Matrix<double>& packed, std::vector<double>& tau,
+                                    size_t nbrOfThreads);
+
+    // Computes the Householder reflector, which zeros a(row+1:m, col). The
+    // vector overwrites a(row+1:m, col) with v(row) = 1 implied and a(row, col)
+    // becomes beta. Returns tau of H = I - tau * v * v'.
+    static double householderInColumn(Matrix<double>& a, size_t row, size_t col);
+
+    // As householderInColumn, but zeros a(row, col+1:n) and the vector overwrites the row.
+    static double householderInRow(Matrix<double>& a, size_t row, size_t col);
+
+    // Reflector of the n elements x[0], x[stride], ... (LAPACK xLARFG), see householderInColumn.
+    static double householderStrided(double* x, size_t n, size_t stride);
+
+    // Applies the reflector stored in column col of v from row on (see householderInColumn)
+    // from the left to b(row:m, colBegin:colEnd). w is a workspace.
+    static void applyColumnHouseholderLeft(const Matrix<double>& v, size_t row, size_t col, double tau,
+                                           Matrix<double>& b, size_t colBegin, size_t colEnd, std::vector<double>& w);
+
+    // Triangle factor T (nb x nb, row major) of the compact WY form
+    // H_c0 * ... * H_c0+nb-1 = I - V * T * V', where the reflectors are
+    // stored in the columns c0:c0+nb of v from the diagonal on (LAPACK xLARFT).
+    static void householderBlockFactor(const Matrix<double>& v, size_t c0, size_t nb, const double* tau, std::vector<double>& t);
+
+    // b(c0:m, colBegin:colEnd) = (I - V * T * V') * b, or with T' if transposed.
+    // The column range is split on at most nbrOfThreads threads and each part
+    // is updated by two matrix products, W = T * V' * b and b = b - V * W.
+    static void applyBlockHouseholderLeft(const Matrix<double>& v, size_t c0, size_t nb, const std::vector<double>& t, bool transposed,
+                                          Matrix<double>& b, size_t colBegin, size_t colEnd, size_t nbrOfThreads);
+
+    static size_t householderBlockSize()
+    {
+        return 32;
+    }
+
+    // Overwrites the square matrix a with its Hessenberg form. The reflector k
+    // is stored below the subdiagonal of column k, see householderInColumn.
+    // If symmetric, the two-sided update is done by a symmetric rank 2 update
+    // and a becomes tridiagonal (the upper triangle is not valid on return).
+    // nbrOfThreads 0 means Parallel::defaultNbrOfThreads().
+    static void hessenbergPackedInPlace(Matrix<double>& a, std::vector<double>& tau, bool symmetric, size_t nbrOfThreads = 0);
+
+    // Forms Q = H_0 * H_1 * ... of the reflectors of hessenbergPackedInPlace.
+    static Matrix<double> hessenbergPackedQ(const Matrix<double>& a, const std::vector<double>& tau);
+
+    // b = Q * b for the reflectors of hessenbergPackedInPlace (blocked, see qrPackedApplyQInPlace).
+    static void hessenbergPackedApplyQInPlace(const Matrix<double>& a, const std::vector<double>& tau, Matrix<double>& b, size_t nbrOfThreads = 0);
+
+    // Overwrites a (m x n, m >= n) with its upper bidiagonal form B = Q' * A * P. The left
+    // reflector k is stored below the diagonal of column k (see householderInColumn), the
+    // right reflector k right of the superdiagonal of row k (see householderInRow). Panels
+    // of householderBlockSize() columns are reduced as in LAPACK xLABRD, then the trailing
+    // matrix is updated by A = A - V * Y' - X * U'. nbrOfThreads 0 means Parallel::defaultNbrOfThreads().
+    static void bidiagonalPackedInPlace(Matrix<double>& a, std::vector<double>& tauQ, std::vector<double>& tauP, size_t nbrOfThreads = 0);
+
+    // Forms Q (m x m, or m x n if economy) of the left reflectors of bidiagonalPackedInPlace.
+    static Matrix<double> bidiagonalPackedQ(const Matrix<double>& a, const std::vector<double>& tauQ, bool economy, size_t nbrOfThreads = 0);
+
+    // Forms P (n x n) of the right reflectors of bidiagonalPackedInPlace.
+    static Matrix<double> bidiagonalPackedP(const Matrix<double>& a, const std::vector<double>& tauP, size_t nbrOfThreads = 0);
+
+    // Diagonal and subdiagonal of the packed tridiagonal matrix of hessenbergPackedInPlace.
+    static void packedTridiagonal(const Matrix<double>& a, std::vector<double>& d, std::vector<double>& e);
+
+    // Cuppen's divide and conquer on the symmetric tridiagonal matrix (d, e). On return, d holds
+    // the Eigen values in ascending order and q (n x n) the Eigen vectors as columns.
+    static bool tridiagonalDivideAndConquer(std::vector<double>& d, std::vector<double>& e, Matrix<double>& q, size_t nbrOfThreads);
+
+    // Merges the Eigen decompositions of the two halves T1 (m x m) and T2, given in d and
+    // q = diag(Q1, Q2), to the one of the tridiagonal matrix, whose coupling entry is beta.
+    static void divideAndConquerMerge(std::vector<double>& d, Matrix<double>& q, size_t m, double beta, size_t nbrOfThreads);
+
+    // Subproblems up to this size are solved by the QR algorithm
+    static size_t divideAndConquerLeafSize()
+    {
+        return 32;
+    }
+
+    // Implicit symmetric QR with Wilkinson shifts on the tridiagonal matrix (d, e).
+    // On return, d holds the Eigen values. The rotations are applied to the rows
+    // of qt (if not null), which for qt = Q' yields the Eigen vectors as rows.
+    static bool symmetricTridiagonalQRInPlace(std::vector<double>& d, std::vector<double>& e, Matrix<double>* qt,
+                                              size_t maxIteration, double precision, bool showProgress);
+
+    // Francis double shift QR of the Hessenberg matrix h to real Schur form. The
+    // transformations are accumulated into the columns of q (if not null).
+    // lReal and lImag receive the Eigen values.
+    static bool schurInPlace(Matrix<double>& h, Matrix<double>* q, size_t maxIteration, double precision,
+                             std::vector<double>& lReal, std::vector<double>& lImag, bool showProgress);
+
+    // Eigen vectors of the real Schur form t by back substitution. Returns q * X, where
+    // a real Eigen vector is one column and a complex one two (real and imaginary part).
+    static Matrix<double> schurEigenVectors(const Matrix<double>& t, const Matrix<double>& q,
+                                            const std::vector<double>& lReal, const std::vector<double>& lImag);
+
+    static std::vector<ComplexEigenPair> eigenComplexInPlace(Matrix<double>& a, size_t maxIteration, double precision, bool showProgress);
+
+    // Plane rotation [c s; -s c] * [f; g] = [r; 0] (LAPACK xLARTG)
+    static void planeRotation(double f, double g, double& c, double& s, double& r)
+    {
+        if (g == 0.0)
+        {
+            c = 1.0;
+            s = 0.0;
+            r = f;
+        }
+        else if (f == 0.0)
+        {
+            c = 0.0;
+            s = 1.0;
+            r = g;
+        }
+        else
+        {
+            r = std::hypot(f, g);
+            c = f / r;
+            s = g / r;
+        }
+    }
+
+    // Singular values of the upper triangle matrix [f g; 0 h] (LAPACK xLAS2)
+    static void singularValues2x2(double f, double g, double h, double& ssmin, double& ssmax);
+
+    // Implicit QR iteration on the upper bidiagonal matrix with diagonal d and superdiagonal e
+    // (Demmel and Kahan, LAPACK xBDSQR). The rotations are applied to the rows 0:n of ut and
+    // vt, which hold the left and right singular vectors as rows. On return, d holds the
+    // singular values in descending order. Returns false if the iteration did not converge.
+    static bool bidiagonalQRInPlace(std::vector<double>& d, std::vector<double>& e, Matrix<double>* ut, Matrix<double>* vt);
+
+    // One-sided Jacobi (Hestenes): rotates pairs of rows of at until all rows are mutually
+    // orthogonal to working precision. The pairs of a round-robin schedule are disjoint and
+    // rotated concurrently. The rotations are applied to the rows of vt as well (if not null).
+    // Returns false if the sweeps did not converge.
+    static bool jacobiOrthogonalizeRowsInPlace(Matrix<double>& at, Matrix<double>* vt, size_t nbrOfThreads);
+
+    // Replaces the rows [nbrOfValid, rows) of q by unit vectors orthogonal to all preceding
+    // rows, which have to be orthonormal.
+    static void completeOrthonormalRows(Matrix<double>& q, size_t nbrOfValid);
+
+    // Throws if svd is not a thin SVD, i.e. U (m x k), S (k x k) and V (n x k).
+    static void checkThinSVD(const SVDResult& svd);
+
+    // Thin SVD of the small matrix, truncated to rank (at least 1 and at most min(rows, cols)).
+    static SVDResult truncatedSVD(const Matrix<double>& small, size_t rank);
+
+    // (xr + i*xi) / (yr + i*yi) without intermediate overflow (Smith's algorithm)
+    static void complexDivision(double xr, double xi, double yr, double yi, double& cr, double& ci)
+    {
+        if (std::abs(yr) > std::abs(yi))
+        {
+            double r = yi / yr;
+            double d = yr + r * yi;
+            cr       = (xr + r * xi) / d;
+            ci       = (xi - r * xr) / d;
+        }
+        else
+        {
+            double r = yr / yi;
+            double d = yi + r * yr;
+            cr       = (r * xr + xi) / d;
+            ci       = (r * xi - xr) / d;
+        }
+    }
+
+    static EigenPair rayleighIterationWorkspace(const Matrix<double>& matD, const Matrix<double>& initialEigenVector, double initialEigenValue,
+                                                size_t maxIteration, double precision, Matrix<double>& shifted, std::vector<size_t>& pivots,
+                                                size_t nbrOfThreads);
+
 };
 
 // Infos from:
@@ -1023,16 +1586,29 @@ std::vector<Decomposition::EigenPair> Decomposition::eigen(const Matrix<T>& mat,
     {
         Matrix<double> cMat(mat);
 
-        if (cMat.isSymmetric())
+        switch (method)
         {
-            switch (method)
-            {
-                case QRAlgorithm:
-                    // QR algorithm
-                    pairs = qrAlgorithm(cMat, 200, std::numeric_limits<double>::epsilon(), false);
-                    break;
+            case DivideAndConquer:
+                if (cMat.isSymmetric())
+                {
+                    SymmetricEigenResult res = symmetricEigen(cMat);
+                    for (size_t i = 0; i < res.Values.size(); i++)
+                        pairs.push_back(EigenPair(res.Vectors.column(i), res.Values[i], res.Valid));
+                }
+                else
+                {
+                    pairs = qrAlgorithm(cMat, 100, std::numeric_limits<double>::epsilon(), false);
+                }
+                break;
+
+            case QRAlgorithm:
+                // QR algorithm, all real Eigen pairs also of non-symmetric matrices
+                pairs = qrAlgorithm(cMat, 100, std::numeric_limits<double>::epsilon(), false);
+                break;
 
-                case PowerIterationAndHotellingsDeflation:
+            case PowerIterationAndHotellingsDeflation:
+                if (cMat.isSymmetric())
+                {
                     // Power iteration and hotelling's deflation
                     // http://www.robots.ox.ac.uk/~sjrob/Teaching/EngComp/ecl4.pdf
                     for (size_t i = 0; i < cMat.rows(); i++)
@@ -1046,17 +1622,13 @@ std::vector<Decomposition::EigenPair> Decomposition::eigen(const Matrix<T>& mat,
                             cMat = cMat - (ePair.L * ePair.V * ePair.V.transpose());
                         }
                     }
-                    break;
-            }
-        }
-        else
-        {
-            std::cout
-                << "Warning: The Eigen decomposition of non-symmetric matrices does not work yet properly in this library!!"
-                << std::endl;
-
-            // compute the largest eigenvalue
-            pairs.push_back(powerIteration(cMat, 30, std::numeric_limits<double>::epsilon()));
+                }
+                else
+                {
+                    // Hotelling's deflation requires symmetry -> compute the largest eigenvalue only
+                    pairs.push_back(powerIteration(cMat, 30, std::numeric_limits<double>::epsilon()));
+                }
+                break;
         }
     }
 
@@ -1121,130 +1693,295 @@ std::vector<Decomposition::EigenPair> Decomposition::eigen2x2(const Matrix<T>& m
 }
 
 template <class T>
-Decomposition::EigenPair Decomposition::rayleighIteration(const Matrix<T>& mat, const Matrix<double>& initialEigenVector, double initialEigenValue, size_t maxIteration, double precision)
+Decomposition::LUPackedResult Decomposition::luPacked(const Matrix<T>& mat)
 {
-    Matrix<double> matD = mat;
+    if (mat.rows() != mat.cols())
+        throw SquareMatrixException();
 
-    // Rayleigh quotient iteration: https://en.wikipedia.org/wiki/Rayleigh_quotient_iteration
+    Matrix<double>      lu = mat;
+    std::vector<size_t> pivots;
+    size_t              nbrRowSwaps = 0;
+    bool                singular    = luPackedInPlace(lu, pivots, nbrRowSwaps);
 
-    Matrix<double> e_vec        = initialEigenVector;
-    double         e_val        = initialEigenValue;
-    double         e_val_before = e_val;
+    return LUPackedResult(lu, pivots, nbrRowSwaps, singular);
+}
 
-    // init used variables
-    Matrix<double> ident           = Matrix<double>::identity(matD.cols());
-    Matrix<double> e_vec_unscaled  = Matrix<double>(matD.cols(), 1);
-    bool           go              = true;
-    size_t         nbrOfIterations = 0;
-    bool           validEigenPair  = false;
+inline bool Decomposition::luPackedInPlace(Matrix<double>& a, std::vector<size_t>& pivots, size_t& nbrRowSwaps, double pivotFloor, size_t nbrOfThreads)
+{
+    if (a.rows() != a.cols())
+        throw SquareMatrixException();
 
-    while (go)
+    size_t n = a.rows();
+    pivots.resize(n);
+    nbrRowSwaps   = 0;
+    bool singular = false;
+
+    double* d = a.data();
+
+    for (size_t k = 0; k < n; k++)
     {
-        e_vec_unscaled = (matD - (ident * e_val)).adjugate() * e_vec;
-        e_vec          = e_vec_unscaled.normalizeColumns();
-        e_val          = rayleighQuotient(matD, e_vec);
+        // find pivot row
+        size_t pivotRow   = k;
+        double pivotValue = std::abs(d[k * n + k]);
+        for (size_t i = k + 1; i < n; i++)
+        {
+            double cVal = std::abs(d[i * n + k]);
+            if (cVal > pivotValue)
+            {
+                pivotRow   = i;
+                pivotValue = cVal;
+            }
+        }
 
-        // check stopping criteria of Rayleigh iteration
-        if (std::abs(e_val - e_val_before) < precision * std::abs(e_val + e_val_before))
+        pivots[k] = pivotRow;
+        if (pivotRow != k)
         {
-            go             = false;
-            validEigenPair = true;
+            std::swap_ranges(d + k * n, d + (k + 1) * n, d + pivotRow * n);
+            nbrRowSwaps++;
         }
-        else if (nbrOfIterations >= maxIteration)
+
+        double& pivot = d[k * n + k];
+        if (!(std::abs(pivot) > pivotFloor))
         {
-            go             = false;
-            validEigenPair = false;
+            singular = true;
+            if (pivotFloor > 0.0)
+                pivot = std::copysign(pivotFloor, pivot);
+            else
+                continue; // column is already eliminated
         }
 
-        e_val_before = e_val;
-        nbrOfIterations++;
+        // eliminate below pivot. The rows are independent of each other.
+        const double* pivotRowPtr = d + k * n;
+        const double  pivotValueK = pivot;
+        size_t        length      = n - k - 1;
+        auto          eliminate   = [d, n, k, length, pivotRowPtr, pivotValueK](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                double* cRow   = d + i * n;
+                double  factor = cRow[k] / pivotValueK;
+                cRow[k]        = factor;
+
+                if (factor != 0.0)
+                    Kernels::axpy(cRow + k + 1, pivotRowPtr + k + 1, length, -factor);
+            }
+        };
+
+        size_t minChunk = std::max<size_t>(1, Kernels::ColumnStepGrainSize / std::max<size_t>(1, length));
+        Parallel::forRange(k + 1, n, eliminate, nbrOfThreads, minChunk);
     }
 
-    return EigenPair(e_vec, e_val, validEigenPair);
+    return singular;
 }
 
-template <class T>
-std::vector<Decomposition::EigenPair> Decomposition::qrAlgorithm(const Matrix<T>& mat, size_t maxIteration, double precision, bool showProgress)
+inline void Decomposition::luPackedSolveInPlace(const Matrix<double>& lu, const std::vector<size_t>& pivots, Matrix<double>& b, size_t nbrOfThreads)
 {
-    // https://en.wikipedia.org/wiki/QR_algorithm
-    std::vector<EigenPair> ret;
+    if (lu.rows() != lu.cols())
+        throw SquareMatrixException();
 
-    Matrix<double> a = mat;
+    size_t n    = lu.rows();
+    size_t nRhs = b.cols();
 
-    size_t         nbrOfIterations = 0;
-    bool           go              = true;
-    bool           foundEig        = false;
-    Matrix<double> q_before        = Matrix<double>(a.rows(), a.rows());
-    q_before.fill(0);
-    Matrix<double> qProd = Matrix<double>::identity(a.rows());
+    if (b.rows() != n || pivots.size() != n)
+        throw InvalidInputException();
 
-    while (go)
+    const double* l = lu.data();
+    double*       x = b.data();
+
+    // apply row swaps
+    for (size_t k = 0; k < n; k++)
     {
-        Decomposition::QRResult qr = Decomposition::qr(a, false); // note: not important to have positive elements on diagonal of R
+        if (pivots[k] != k)
+            std::swap_ranges(x + k * nRhs, x + (k + 1) * nRhs, x + pivots[k] * nRhs);
+    }
+
+    // The right hand sides are independent. Each thread substitutes
+    // a range of columns.
+    auto substitute = [l, x, n, nRhs](size_t c0, size_t c1) {
+        size_t width = c1 - c0;
 
-        // check stopping criteria
-        if (q_before.compare(qr.Q, true, precision))
+        // forward substitution with unit lower triangle
+        for (size_t i = 1; i < n; i++)
         {
-            // q changed less than required precission.
-            // q is good choice since its normalized
-            go       = false;
-            foundEig = true;
+            double* xi = x + i * nRhs + c0;
+            for (size_t j = 0; j < i; j++)
+            {
+                double f = l[i * n + j];
+                if (f != 0.0)
+                    Kernels::axpy(xi, x + j * nRhs + c0, width, -f);
+            }
         }
-        else if (nbrOfIterations >= maxIteration)
+
+        // backward substitution with upper triangle
+        for (size_t ii = n; ii > 0; ii--)
         {
-            go       = false;
-            foundEig = false;
+            size_t  i  = ii - 1;
+            double* xi = x + i * nRhs + c0;
+            for (size_t j = i + 1; j < n; j++)
+            {
+                double f = l[i * n + j];
+                if (f != 0.0)
+                    Kernels::axpy(xi, x + j * nRhs + c0, width, -f);
+            }
+
+            Kernels::scale(xi, width, 1.0 / l[i * n + i]);
         }
-        else
-        {
-            // continue -> prepare next loop
+    };
 
-            a     = qr.R * qr.Q;  // iteratively converge to a - diag(a) are eigenvalues
-            qProd = qProd * qr.Q; // accumlate q transformations to get eigenvectors
+    size_t minChunk = std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, n * n));
+    Parallel::forRange(0, nRhs, substitute, nbrOfThreads, minChunk);
+}
 
-            if (showProgress)
+inline void Decomposition::luPackedSolveTransposedInPlace(const Matrix<double>& lu, const std::vector<size_t>& pivots, Matrix<double>& b)
+{
+    // A = P' * L * U  ->  A' = U' * L' * P
+    size_t n    = lu.rows();
+    size_t nRhs = b.cols();
+
+    if (b.rows() != n || pivots.size() != n)
+        throw InvalidInputException();
+
+    const double* l = lu.data();
+    double*       x = b.data();
+
+    // forward substitution with U'
+    for (size_t i = 0; i < n; i++)
+    {
+        double* xi = x + i * nRhs;
+        for (size_t j = 0; j < i; j++)
+        {
+            double f = l[j * n + i];
+            if (f != 0.0)
             {
-                std::cout << "qrAlgorithm progress = " << static_cast<double>(nbrOfIterations) / static_cast<double>(maxIteration) << std::endl;
+                const double* xj = x + j * nRhs;
+                for (size_t c = 0; c < nRhs; c++)
+                    xi[c] -= f * xj[c];
             }
+        }
+
+        double invDiag = 1.0 / l[i * n + i];
+        for (size_t c = 0; c < nRhs; c++)
+            xi[c] *= invDiag;
+    }
 
-            q_before = qr.Q;
-            nbrOfIterations++;
+    // backward substitution with unit L'
+    for (size_t ii = n; ii > 1; ii--)
+    {
+        size_t  i  = ii - 2;
+        double* xi = x + i * nRhs;
+        for (size_t j = i + 1; j < n; j++)
+        {
+            double f = l[j * n + i];
+            if (f != 0.0)
+            {
+                const double* xj = x + j * nRhs;
+                for (size_t c = 0; c < nRhs; c++)
+                    xi[c] -= f * xj[c];
+            }
         }
     }
 
-    // The eigenvalues are in a and eigenvectors in qProd
-    for (size_t i = 0; i < qProd.cols(); i++)
+    // undo row swaps in reverse order
+    for (size_t kk = n; kk > 0; kk--)
     {
-        EigenPair eP(qProd.column(i), a(i, i), foundEig);
-        ret.push_back(eP);
+        size_t k = kk - 1;
+        if (pivots[k] != k)
+            std::swap_ranges(x + k * nRhs, x + (k + 1) * nRhs, x + pivots[k] * nRhs);
     }
+}
 
-    return ret;
+template <class T>
+Decomposition::EigenPair Decomposition::rayleighIteration(const Matrix<T>& mat, const Matrix<double>& initialEigenVector, double initialEigenValue, size_t maxIteration, double precision)
+{
+    if (!mat.isSquare())
+        throw SquareMatrixException();
+
+    Matrix<double>      matD = mat;
+    Matrix<double>      shifted(matD.rows(), matD.cols());
+    std::vector<size_t> pivots(matD.rows());
+
+    return rayleighIterationWorkspace(matD, initialEigenVector, initialEigenValue, maxIteration, precision, shifted, pivots, 0);
 }
 
 template <class T>
-Decomposition::EigenPair Decomposition::powerIteration(const Matrix<T>& mat, size_t maxIteration, double precision)
+std::vector<Decomposition::EigenPair> Decomposition::rayleighIteration(const Matrix<T>& mat, const std::vector<EigenPair>& initialPairs, size_t maxIteration, double precision, size_t nbrOfThreads)
 {
-    // Power iteration : https://en.wikipedia.org/wiki/Power_iteration
-    // Finds most significant eigenvalue
+    if (!mat.isSquare())
+        throw SquareMatrixException();
 
-    Matrix<double> matD = mat;
-    Matrix<double> eVec(matD.rows(), 1);
-    eVec.fill(1.0);
-    double eVal       = 1;
-    double eValBefore = eVal;
+    const Matrix<double>   matD = mat;
+    std::vector<EigenPair> pairs(initialPairs);
+
+    Parallel::forRange(0, pairs.size(), [&](size_t begin, size_t end) {
+        // one workspace per thread. The outer loop is the only parallel one,
+        // the LU kernels run on the calling thread.
+        Matrix<double>      shifted(matD.rows(), matD.cols());
+        std::vector<size_t> pivots(matD.rows());
+
+        for (size_t i = begin; i < end; i++)
+            pairs[i] = rayleighIterationWorkspace(matD, initialPairs[i].V, initialPairs[i].L, maxIteration, precision, shifted, pivots, 1);
+    },
+                       nbrOfThreads);
+
+    return pairs;
+}
+
+inline Decomposition::EigenPair Decomposition::rayleighIterationWorkspace(const Matrix<double>& matD, const Matrix<double>& initialEigenVector, double initialEigenValue,
+                                                                          size_t maxIteration, double precision, Matrix<double>& shifted, std::vector<size_t>& pivots,
+                                                                          size_t nbrOfThreads)
+{
+    // Rayleigh quotient iteration: https://en.wikipedia.org/wiki/Rayleigh_quotient_iteration
+    // Instead of applying the adjugate of the shifted matrix, the system
+    // (A - e_val * I) * x = e_vec is solved by a LU decomposition. Near convergence
+    // the shifted matrix becomes singular. Zero pivots are then replaced by a tiny
+    // value, which only scales x - its direction is the wanted eigenvector.
+
+    size_t n = matD.rows();
+
+    if (initialEigenVector.rows() != n || initialEigenVector.cols() != 1)
+        throw InvalidInputException();
+
+    Matrix<double> e_vec        = initialEigenVector;
+    double         e_val        = initialEigenValue;
+    double         e_val_before = e_val;
+
+    double matNorm    = matD.normInf();
+    double pivotFloor = std::numeric_limits<double>::epsilon() * std::max(matNorm, std::numeric_limits<double>::min());
+
+    // an eigen pair with a residual at rounding error level cannot be improved further
+    double residualTolerance = 10.0 * n * std::numeric_limits<double>::epsilon() * matNorm;
 
-    bool   validEigenPair  = false;
-    size_t nbrOfIterations = 0;
     bool   go              = true;
+    size_t nbrOfIterations = 0;
+    bool   validEigenPair  = false;
 
     while (go)
     {
-        eVec = (matD * eVec).normalizeColumns();
-        eVal = rayleighQuotient(matD, eVec);
+        // shifted = matD - e_val * I
+        copyMatData(matD, shifted);
+        for (size_t i = 0; i < n; i++)
+            shifted(i, i) -= e_val;
 
-        // check stopping criteria of power iteration
-        if (std::abs(eVal - eValBefore) < precision * std::abs(eVal + eValBefore))
+        size_t nbrRowSwaps;
+        luPackedInPlace(shifted, pivots, nbrRowSwaps, pivotFloor, nbrOfThreads);
+        luPackedSolveInPlace(shifted, pivots, e_vec, nbrOfThreads);
+
+        // normalize in place
+        double length = e_vec.norm();
+        if (!(length > 0.0) || !std::isfinite(length))
+            break;
+
+        std::for_each(e_vec.data(), e_vec.data() + n, [length](double& v) { v = v / length; });
+
+        Matrix<double> aV = matD * e_vec;
+        e_val             = (e_vec.transpose() * aV)(0, 0); // e_vec is normalized
+
+        double residual = 0.0;
+        for (size_t i = 0; i < n; i++)
+            residual += std::pow(aV(i, 0) - e_val * e_vec(i, 0), 2.0);
+        residual = std::sqrt(residual);
+
+        // check stopping criteria of Rayleigh iteration
+        if (std::abs(e_val - e_val_before) < precision * std::abs(e_val + e_val_before) || residual <= residualTolerance)
         {
             go             = false;
             validEigenPair = true;
@@ -1255,259 +1992,2774 @@ Decomposition::EigenPair Decomposition::powerIteration(const Matrix<T>& mat, siz
             validEigenPair = false;
         }
 
-        eValBefore = eVal;
+        e_val_before = e_val;
         nbrOfIterations++;
     }
 
-    return EigenPair(eVec, eVal, validEigenPair);
+    return EigenPair(e_vec, e_val, validEigenPair);
 }
 
-// info: https://www.mathematik.uni-wuerzburg.de/~borzi/RQGradient_Chapter_10.pdf
 template <class T>
-double Decomposition::rayleighQuotient(const Matrix<T>& m, const Matrix<T>& v)
+std::vector<Decomposition::EigenPair> Decomposition::qrAlgorithm(const Matrix<T>& mat, size_t maxIteration, double precision, bool showProgress)
 {
-    Matrix<T> vT = v.transpose();
-    return static_cast<double>((vT * m * v)(0, 0)) / static_cast<double>((vT * v)(0, 0));
-}
+    // https://en.wikipedia.org/wiki/QR_algorithm
+    // Golub, Van Loan: Matrix Computations, chapters 7.5 and 8.3
+    if (!mat.isSquare())
+        throw SquareMatrixException();
 
-template <class T>
-Decomposition::HouseholderResult Decomposition::householder(const Matrix<T>& x)
-{
-    // generate basis vector [1.0, 0, 0, ..]
-    Matrix<double> e(x.rows(), 1);
-    e.fill(0.0);
-    e(0, 0) = 1.0;
+    std::vector<EigenPair> ret;
 
-    double sign = 1.0;
-    if (x(0, 0) > 0.0)
-        sign = -1.0;
+    Matrix<double> a = mat;
+    size_t         n = a.rows();
 
-    // vh -> Householder vector
-    Matrix<double> v = x - (e * x.norm() * sign);
+    if (a.isSymmetric())
+    {
+        std::vector<double> tau;
+        hessenbergPackedInPlace(a, tau, true);
 
-    // scalar
-    double b = 2.0 / (v.transpose() * v)(0, 0);
+        std::vector<double> d;
+        std::vector<double> e;
+        packedTridiagonal(a, d, e);
 
-    return HouseholderResult(b, v);
+        // the rotations of the QR sweeps are accumulated into the rows of Q'
+        Matrix<double> qt       = hessenbergPackedQ(a, tau).transpose();
+        bool           foundEig = symmetricTridiagonalQRInPlace(d, e, &qt, maxIteration, precision, showProgress);
+
+        for (size_t i = 0; i < n; i++)
+            ret.push_back(EigenPair(Matrix<double>(n, 1, qt.data() + i * n), d[i], foundEig));
+    }
+    else
+    {
+        std::vector<ComplexEigenPair> pairs = eigenComplexInPlace(a, maxIteration, precision, showProgress);
+        for (const ComplexEigenPair& p : pairs)
+        {
+            if (p.LImag == 0.0)
+                ret.push_back(EigenPair(p.VReal, p.LReal, p.Valid));
+        }
+    }
+
+    return ret;
 }
 
 template <class T>
-Matrix<double> Decomposition::householderMatrix(const Matrix<T>& v, double b)
+std::vector<Decomposition::ComplexEigenPair> Decomposition::eigenComplex(const Matrix<T>& mat, size_t maxIteration)
 {
-    Matrix<double> p = Matrix<double>::identity(v.rows());
-
-    if (std::isfinite(b))
-        p = p - b * v * v.transpose();
+    if (!mat.isSquare())
+        throw SquareMatrixException();
 
-    return p;
+    Matrix<double> a = mat;
+    return eigenComplexInPlace(a, maxIteration, std::numeric_limits<double>::epsilon(), false);
 }
 
-// Sources:
-// Householder bidiagonalization, Matrix computation, 4th ed, Golub & Loan, p.284
-// documents/bidiagonalization.pdf -> Martin Plesinger
 template <class T>
-Decomposition::DiagonalizationResult Decomposition::bidiagonalization(const Matrix<T>& a_m)
+Decomposition::HessenbergResult Decomposition::hessenberg(const Matrix<T>& mat, bool computeQ)
 {
-    size_t m = a_m.rows();
-    size_t n = a_m.cols();
-
-    if (m < n)
-    {
-        std::cout << "bidiagonalization: Invalid matrix dimension";
-        std::exit(-1);
-    }
+    if (!mat.isSquare())
+        throw SquareMatrixException();
 
-    Matrix<double> a = a_m;
-    Matrix<double> u = Matrix<double>::identity(m);
-    Matrix<double> v = Matrix<double>::identity(n);
+    Matrix<double>      h = mat;
+    std::vector<double> tau;
+    hessenbergPackedInPlace(h, tau, false);
 
-    for (size_t j = 0; j < n; j++)
-    {
-        // row direction
-        Matrix<double>    x_r     = a.subMatrix(j, j, m - j, 1);
-        HouseholderResult h_r     = householder(x_r);
-        Matrix<double>    h_mat_r = householderMatrix(h_r.V, h_r.B);
+    Matrix<double> q;
+    if (computeQ)
+        q = hessenbergPackedQ(h, tau);
 
-        Matrix<double> a_sub_r = a.subMatrix(j, j, m - j, n - j);
+    // clear the reflectors
+    for (size_t i = 2; i < h.rows(); i++)
+        std::fill(h.data() + i * h.cols(), h.data() + i * h.cols() + i - 1, 0.0);
 
-        // transform a with householder matrix
-        a_sub_r = h_mat_r * a_sub_r;
-        a.setSubMatrix(j, j, a_sub_r); // place submatrix into a
+    return HessenbergResult(h, q);
+}
 
-        // concatenate householder matrix to u
-        Matrix<double> H_MAT_R = Matrix<double>::identity(m);
-        H_MAT_R.setSubMatrix(j, j, h_mat_r);
-        u = u * H_MAT_R;
+template <class T>
+Decomposition::TridiagonalResult Decomposition::tridiagonalization(const Matrix<T>& mat, bool computeQ)
+{
+    if (!mat.isSquare())
+        throw SquareMatrixException();
 
-        // column direction
-        if (j < n - 2)
-        {
-            Matrix<double>    x_c     = a.subMatrix(j, j + 1, 1, n - (j + 1));
-            HouseholderResult h_c     = householder(x_c.transpose());
-            Matrix<double>    h_mat_c = householderMatrix(h_c.V, h_c.B);
+    Matrix<double>      a = mat;
+    std::vector<double> tau;
+    hessenbergPackedInPlace(a, tau, true);
 
-            Matrix<double> a_sub_c = a.subMatrix(j, j + 1, m - j, n - j - 1);
-            a_sub_c                = a_sub_c * h_mat_c;
-            a.setSubMatrix(j, j + 1, a_sub_c); // place submatrix into a
+    std::vector<double> d;
+    std::vector<double> e;
+    packedTridiagonal(a, d, e);
 
-            // concatenate householder matrix to v
-            Matrix<double> H_MAT_C = Matrix<double>::identity(n);
-            H_MAT_C.setSubMatrix(j + 1, j + 1, h_mat_c);
-            v = v * H_MAT_C;
-        }
-    }
+    Matrix<double> q;
+    if (computeQ)
+        q = hessenbergPackedQ(a, tau);
 
-    return DiagonalizationResult(u, a, v);
+    return TridiagonalResult(d, e, q);
 }
 
-// QR decomposition by using Householder reflection -> see documents/qr_decomposition.pdf
 template <class T>
-Decomposition::QRResult Decomposition::qr(const Matrix<T>& mat, bool positive, QRMethod method)
+Decomposition::SchurResult Decomposition::schur(const Matrix<T>& mat, size_t maxIteration)
 {
-    switch (method)
-    {
-        case Householder:
-            return qr_householder(mat, positive);
+    if (!mat.isSquare())
+        throw SquareMatrixException();
 
-        case Givens:
-            return qr_givens(mat, positive);
-    }
+    Matrix<double>      t = mat;
+    std::vector<double> tau;
+    hessenbergPackedInPlace(t, tau, false);
+    Matrix<double> q = hessenbergPackedQ(t, tau);
+    for (size_t i = 2; i < t.rows(); i++)
+        std::fill(t.data() + i * t.cols(), t.data() + i * t.cols() + i - 1, 0.0);
+
+    std::vector<double> lReal;
+    std::vector<double> lImag;
+    bool converged = schurInPlace(t, &q, maxIteration, std::numeric_limits<double>::epsilon(), lReal, lImag, false);
+
+    return SchurResult(t, q, converged);
 }
 
-// QR decomposition by using Householder reflection -> see documents/qr_decomposition.pdf
-template <class T>
-Decomposition::QRResult Decomposition::qr_householder(const Matrix<T>& mat, bool positive)
+inline void Decomposition::hessenbergPackedInPlace(Matrix<double>& a, std::vector<double>& tau, bool symmetric, size_t nbrOfThreads)
 {
-    Matrix<double> r = mat;
-    size_t         m = r.rows();
-    size_t         n = r.cols();
+    size_t n = a.rows();
+    tau.assign(n > 2 ? n - 2 : 0, 0.0);
 
-    // initialize q as identity
-    Matrix<double> q = Matrix<double>::identity(m);
+    double*             data = a.data();
+    std::vector<double> v;
+    std::vector<double> p;
+    std::vector<double> w;
 
-    for (size_t i = 0; i < n; i++)
+    if (symmetric)
     {
-        // copy current column
-        Matrix<double>    x     = r.subMatrix(i, i, m - i, 1);
-        HouseholderResult house = householder(x);
-        Matrix<double>    h     = householderMatrix(house.V, house.B);
+        // A22 = H * A22 * H = A22 - v * w' - w * v', where p = tau * A22 * v and
+        // w = p - tau / 2 * (p' * v) * v. The rank 2 update of step k is deferred
+        // and fused with the product A22 * v of step k+1, which halves the passes
+        // over the trailing matrix. vPrev and wPrev start at row and column k.
+        std::vector<double> vPrev;
+        std::vector<double> wPrev;
+        bool                pending = false;
+        for (size_t k = 0; k + 2 < n; k++)
+        {
+            size_t c0  = k + 1;
+            size_t len = n - c0;
 
-        // create the matrix for next loop.
-        Matrix<double> rSub = h * r.subMatrix(i, i, m - i, n - i);
-        r.setSubMatrix(i, i, rSub);
+            // the reflector needs the updated column k
+            if (pending)
+            {
+                for (size_t i = k; i < n; i++)
+                    a(i, k) -= vPrev[i - k] * wPrev[0] + wPrev[i - k] * vPrev[0];
+            }
 
-        // use the smaller Householder matrix h to
-        // create one of the right size, H.
-        // each H is used to get step by step to to
-        // the matrix Q.
-        Matrix<double> H = Matrix<double>::identity(m);
-        H.setSubMatrix(i, i, h);
-        q = q * H;
-    }
+            double t = householderInColumn(a, c0, k);
+            tau[k]   = t;
 
-    QRResult retResult(q, r);
+            v.resize(len);
+            v[0] = 1.0;
+            for (size_t i = 1; i < len; i++)
+                v[i] = a(c0 + i, k);
 
-    if (positive)
-    {
-        // There exist multiple qr solutions. To get a unique result,
-        // the diagonal elements on r are chosen to be positive.
-        for (size_t i = 0; i < m; i++)
-        {
-            if (retResult.R(i, i) < 0)
+            p.resize(len);
+            Parallel::forRange(0, len, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; i++)
+                {
+                    double* row = data + (c0 + i) * n + c0;
+                    if (pending)
+                    {
+                        Kernels::axpy(row, wPrev.data() + 1, len, -vPrev[i + 1]);
+                        Kernels::axpy(row, vPrev.data() + 1, len, -wPrev[i + 1]);
+                    }
+                    p[i] = (t != 0.0) ? t * Kernels::dot(row, v.data(), len) : 0.0;
+                }
+            }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / len));
+
+            pending = (t != 0.0);
+            if (pending)
             {
-                retResult = qrSignModifier(retResult.Q, retResult.R, i);
+                w = p;
+                Kernels::axpy(w.data(), v.data(), len, -0.5 * t * Kernels::dot(p.data(), v.data(), len));
+                vPrev.swap(v);
+                wPrev.swap(w);
             }
         }
-    }
-
-    return retResult;
-}
-
-// QR decomposition by using Givens rotations -> see documents/qr_decomposition.pdf
-template <class T>
-Decomposition::QRResult Decomposition::qr_givens(const Matrix<T>& mat, bool positive)
-{
-    Matrix<double> r = mat;
-    size_t         m = r.rows();
-    size_t         n = r.cols();
-
-    // initialize q as identity
-    Matrix<double> q = Matrix<double>::identity(m);
 
-    for (size_t j = 0; j < n; j++)
-    {
-        for (size_t i = m - 1; i > j; i--)
+        // deferred update of the trailing 2x2 block
+        if (pending)
         {
-            Matrix<double> gs = givensRotatioColumnDirection(r, j, i - 1, i);
-            r                 = gs * r;
-            q                 = q * gs.transpose();
+            for (size_t i = n - 2; i < n; i++)
+                for (size_t j = n - 2; j < n; j++)
+                    a(i, j) -= vPrev[i + 2 - n] * wPrev[j + 2 - n] + wPrev[i + 2 - n] * vPrev[j + 2 - n];
         }
-    }
 
-    QRResult res(q, r);
+        return;
+    }
 
-    if (positive)
+    for (size_t k = 0; k + 2 < n; k++)
     {
-        // There exist multiple qr solutions. To get a unique result,
-        // the diagonal elements on r are chosen to be positive.
-        for (size_t i = 0; i < m; i++)
-        {
-            if (res.R(i, i) < 0)
+        size_t c0  = k + 1;
+        size_t len = n - c0;
+        double t   = householderInColumn(a, c0, k);
+        tau[k]     = t;
+        if (t == 0.0)
+            continue;
+
+        // contiguous copy of the reflector
+        v.resize(len);
+        v[0] = 1.0;
+        for (size_t i = 1; i < len; i++)
+            v[i] = a(c0 + i, k);
+
+        // A = H * A * H: from the left to the rows c0:n, then from the right to all rows
+        applyColumnHouseholderLeft(a, c0, k, t, a, c0, n, w);
+
+        Parallel::forRange(0, n, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; i++)
             {
-                res = qrSignModifier(res.Q, res.R, i);
+                double* row = data + i * n + c0;
+                Kernels::axpy(row, v.data(), len, -t * Kernels::dot(row, v.data(), len));
             }
-        }
+        }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / len));
     }
-
-    return res;
 }
 
-template <class T>
-Decomposition::QRResult Decomposition::rq(const Matrix<T>& mat, QRMethod method)
+inline void Decomposition::bidiagonalPackedInPlace(Matrix<double>& a, std::vector<double>& tauQ, std::vector<double>& tauP, size_t nbrOfThreads)
 {
-    // info: https://math.stackexchange.com/questions/1640695/rq-decomposition
-    size_t m = mat.rows();
+    size_t m = a.rows();
+    size_t n = a.cols();
+    if (m < n)
+        throw InvalidInputException();
 
-    Matrix<double> p = Matrix<double>(m, m);
-    p.fill(0.0);
-    for (size_t i = 0; i < m; i++)
+    tauQ.assign(n, 0.0);
+    tauP.assign(n, 0.0);
+    if (n == 0)
+        return;
+
+    double*             data = a.data();
+    std::vector<double> d(n);
+    std::vector<double> e(n, 0.0);
+    std::vector<double> v;
+    std::vector<double> tmp;
+
+    for (size_t k0 = 0; k0 < n; k0 += householderBlockSize())
     {
-        p(i, m - 1 - i) = 1.0;
-    }
+        size_t nb = std::min(householderBlockSize(), n - k0);
 
-    Matrix<double> ad = p * mat; // reverses the rows in mat
+        // x (m x nb) and the transposed y (nb x n) of the panel, A22 = A22 - V * Y' - X * U'
+        Matrix<double> x(m, nb);
+        Matrix<double> yt(nb, n);
+        x.fill(0.0);
+        yt.fill(0.0);
 
-    Decomposition::QRResult qrD = Decomposition::qr(ad.transpose(), method);
+        for (size_t i = 0; i < nb; i++)
+        {
+            size_t c = k0 + i;
 
-    Matrix<double> q = p * qrD.Q.transpose();
-    Matrix<double> r = p * qrD.R.transpose() * p;
+            // update column c with the previous reflectors of the panel
+            if (i > 0)
+            {
+                tmp.resize(i);
+                for (size_t p = 0; p < i; p++)
+                    tmp[p] = yt(p, c);
+                for (size_t r = c; r < m; r++)
+                    a(r, c) -= Kernels::dot(data + r * n + k0, tmp.data(), i);
+
+                for (size_t p = 0; p < i; p++)
+                    tmp[p] = a(k0 + p, c);
+                for (size_t r = c; r < m; r++)
+                    a(r, c) -= Kernels::dot(x.data() + r * nb, tmp.data(), i);
+            }
 
-    return QRResult(q, r);
-}
+            tauQ[c] = householderInColumn(a, c, c);
+            d[c]    = a(c, c);
+            a(c, c) = 1.0;
 
-template <class T>
-Decomposition::QRResult Decomposition::qrSignModifier(const Matrix<T>& q, const Matrix<T>& r, size_t row)
-{
+            if (c + 1 == n)
+                break;
+
+            // y(c+1:n, i) = tau * (A' - Y * V' - U * X') * v
+            size_t len = m - c;
+            v.resize(len);
+            for (size_t r = 0; r < len; r++)
+                v[r] = a(c + r, c);
+
+            double* yi = yt.data() + i * n;
+            Parallel::forRange(c + 1, n, [&](size_t b, size_t en) {
+                for (size_t r = 0; r < len; r++)
+                    Kernels::axpy(yi + b, data + (c + r) * n + b, en - b, v[r]);
+            }, nbrOfThreads, std::max<size_t>(1, Kernels::ColumnStepGrainSize / len));
+
+            tmp.assign(i, 0.0);
+            for (size_t r = 0; r < len; r++)
+                Kernels::axpy(tmp.data(), data + (c + r) * n + k0, i, v[r]);
+            for (size_t p = 0; p < i; p++)
+                Kernels::axpy(yi + c + 1, yt.data() + p * n + c + 1, n - c - 1, -tmp[p]);
+
+            tmp.assign(i, 0.0);
+            for (size_t r = 0; r < len; r++)
+                Kernels::axpy(tmp.data(), x.data() + (c + r) * nb, i, v[r]);
+            for (size_t p = 0; p < i; p++)
+                Kernels::axpy(yi + c + 1, data + (k0 + p) * n + c + 1, n - c - 1, -tmp[p]);
+
+            Kernels::scale(yi + c + 1, n - c - 1, tauQ[c]);
+
+            // update row c
+            double* rowC = data + c * n + c + 1;
+            for (size_t p = 0; p <= i; p++)
+                Kernels::axpy(rowC, yt.data() + p * n + c + 1, n - c - 1, -a(c, k0 + p));
+            for (size_t p = 0; p < i; p++)
+                Kernels::axpy(rowC, data + (k0 + p) * n + c + 1, n - c - 1, -x(c, p));
+
+            tauP[c]     = householderInRow(a, c, c + 1);
+            e[c]        = a(c, c + 1);
+            a(c, c + 1) = 1.0;
+
+            // x(c+1:m, i) = tau * (A - V * Y' - X * U') * u
+            double tp = tauP[c];
+            tmp.assign(i + 1, 0.0);
+            for (size_t p = 0; p <= i; p++)
+                tmp[p] = Kernels::dot(yt.data() + p * n + c + 1, rowC, n - c - 1);
+
+            std::vector<double> tmp2(i);
+            for (size_t p = 0; p < i; p++)
+                tmp2[p] = Kernels::dot(data + (k0 + p) * n + c + 1, rowC, n - c - 1);
+
+            Parallel::forRange(c + 1, m, [&](size_t b, size_t en) {
+                for (size_t r = b; r < en; r++)
+                {
+                    double xr = Kernels::dot(data + r * n + c + 1, rowC, n - c - 1);
+                    xr -= Kernels::dot(data + r * n + k0, tmp.data(), i + 1);
+                    xr -= Kernels::dot(x.data() + r * nb, tmp2.data(), i);
+                    x(r, i) = tp * xr;
+                }
+            }, nbrOfThreads, std::max<size_t>(1, Kernels::ColumnStepGrainSize / (n - c)));
+        }
+
+        // trailing matrix, row by row: A22 = A22 - V * Y' - X * U'
+        size_t t0 = k0 + nb;
+        if (t0 < n)
+        {
+            size_t width = n - t0;
+            Parallel::forRange(t0, m, [&](size_t b, size_t en) {
+                for (size_t r = b; r < en; r++)
+                {
+                    double* row = data + r * n + t0;
+                    for (size_t p = 0; p < nb; p++)
+                    {
+                        Kernels::axpy(row, yt.data() + p * n + t0, width, -a(r, k0 + p));
+                        Kernels::axpy(row, data + (k0 + p) * n + t0, width, -x(r, p));
+                    }
+                }
+            }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / (2 * nb * width)));
+        }
+
+        // the bidiagonal entries replace the implied ones
+        for (size_t c = k0; c < k0 + nb; c++)
+        {
+            a(c, c) = d[c];
+            if (c + 1 < n)
+                a(c, c + 1) = e[c];
+        }
+    }
+}
+
+inline Matrix<double> Decomposition::bidiagonalPackedQ(const Matrix<double>& a, const std::vector<double>& tauQ, bool economy, size_t nbrOfThreads)
+{
+    // The left reflectors are stored as the ones of a packed QR decomposition
+    return qrPackedQ(a, tauQ, economy, nbrOfThreads);
+}
+
+inline Matrix<double> Decomposition::bidiagonalPackedP(const Matrix<double>& a, const std::vector<double>& tauP, size_t nbrOfThreads)
+{
+    size_t         n = a.cols();
+    Matrix<double> p = Matrix<double>::identity(n);
+    if (n < 2)
+        return p;
+
+    // The right reflector k starts in column k+1, so P = diag(1, P~), where P~ is the
+    // orthogonal matrix of the packed QR decomposition a(0:n-1, 1:n)'.
+    std::vector<double> tau(tauP.begin(), tauP.begin() + (n - 1));
+    p.setSubMatrix(1, 1, qrPackedQ(a.subMatrix(0, 1, n - 1, n - 1).transpose(), tau, true, nbrOfThreads));
+
+    return p;
+}
+
+inline Matrix<double> Decomposition::hessenbergPackedQ(const Matrix<double>& a, const std::vector<double>& tau)
+{
+    Matrix<double> q = Matrix<double>::identity(a.rows());
+    hessenbergPackedApplyQInPlace(a, tau, q);
+
+    return q;
+}
+
+inline void Decomposition::hessenbergPackedApplyQInPlace(const Matrix<double>& a, const std::vector<double>& tau, Matrix<double>& b, size_t nbrOfThreads)
+{
+    size_t n = a.rows();
+    if (b.rows() != n)
+        throw InvalidInputException();
+
+    if (tau.empty())
+        return;
+
+    // The reflector k starts in row k+1, so Q = diag(1, Q~), where Q~ is the
+    // orthogonal matrix of the packed QR decomposition a(1:n, 0:n-2).
+    Matrix<double> bSub = b.subMatrix(1, 0, n - 1, b.cols());
+    qrPackedApplyQInPlace(a.subMatrix(1, 0, n - 1, n - 2), tau, bSub, nbrOfThreads);
+    b.setSubMatrix(1, 0, bSub);
+}
+
+inline void Decomposition::packedTridiagonal(const Matrix<double>& a, std::vector<double>& d, std::vector<double>& e)
+{
+    size_t n = a.rows();
+    d.resize(n);
+    e.resize(n > 0 ? n - 1 : 0);
+    for (size_t k = 0; k < n; k++)
+        d[k] = a(k, k);
+    for (size_t k = 0; k + 1 < n; k++)
+        e[k] = a(k + 1, k);
+}
+
+template <class T>
+Decomposition::SymmetricEigenResult Decomposition::symmetricEigen(const Matrix<T>& mat, bool computeVectors, size_t nbrOfThreads)
+{
+    if (!mat.isSquare())
+        throw SquareMatrixException();
+
+    if (nbrOfThreads == 0)
+        nbrOfThreads = Parallel::defaultNbrOfThreads();
+
+    if (mat.rows() == 0)
+        return SymmetricEigenResult(std::vector<double>(), Matrix<double>(), true);
+
+    Matrix<double>      a = mat;
+    std::vector<double> tau;
+    hessenbergPackedInPlace(a, tau, true, nbrOfThreads);
+
+    std::vector<double> d;
+    std::vector<double> e;
+    packedTridiagonal(a, d, e);
+
+    if (!computeVectors)
+    {
+        bool valid = symmetricTridiagonalQRInPlace(d, e, nullptr, 30, std::numeric_limits<double>::epsilon(), false);
+        std::sort(d.begin(), d.end());
+        return SymmetricEigenResult(d, Matrix<double>(), valid);
+    }
+
+    // Eigen vectors of A are Q * Z, where T = Z * D * Z'
+    Matrix<double> z;
+    bool           valid = tridiagonalDivideAndConquer(d, e, z, nbrOfThreads);
+    hessenbergPackedApplyQInPlace(a, tau, z, nbrOfThreads);
+
+    return SymmetricEigenResult(d, z, valid);
+}
+
+template <class T>
+std::vector<Decomposition::EigenPair> Decomposition::lanczos(const Matrix<T>& mat, size_t k, bool largest, double precision, size_t nbrOfThreads)
+{
+    if (!mat.isSquare())
+        throw SquareMatrixException();
+
+    Matrix<double> a        = mat;
+    size_t         n        = a.rows();
+    size_t         minChunk = std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, n));
+
+    auto op = [&a, n, nbrOfThreads, minChunk](const Matrix<double>& x, Matrix<double>& y) {
+        Parallel::forRange(0, n, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; i++)
+                y(i, 0) = Kernels::dot(a.data() + i * n, x.data(), n);
+        }, nbrOfThreads, minChunk);
+    };
+
+    return lanczosOperator(op, n, k, largest, precision, 300, nbrOfThreads);
+}
+
+template <class F>
+std::vector<Decomposition::EigenPair> Decomposition::lanczosOperator(F op, size_t n, size_t k, bool largest, double precision,
+                                                                     size_t maxRestarts, size_t nbrOfThreads)
+{
+    if (n == 0 || k > n)
+        throw InvalidInputException();
+
+    std::vector<EigenPair> ret;
+    if (k == 0)
+        return ret;
+
+    if (nbrOfThreads == 0)
+        nbrOfThreads = Parallel::defaultNbrOfThreads();
+
+    // The basis vectors are the rows of v, the projected matrix V' * A * V is t
+    size_t         m = std::min(n, std::max(2 * k + 1, k + 20));
+    Matrix<double> v(m + 1, n);
+    Matrix<double> t(m, m);
+    t.fill(0.0);
+
+    size_t nbrOfBlocks = std::max<size_t>(1, std::min(nbrOfThreads, n / Kernels::ParallelGrainSize));
+    size_t blockSize   = (n + nbrOfBlocks - 1) / nbrOfBlocks;
+    size_t minChunk    = std::max<size_t>(1, Kernels::ParallelGrainSize / (m + 1));
+
+    // Classical Gram-Schmidt of row r against the rows [0, cnt), repeated once if the
+    // norm dropped below 1/sqrt(2) (Daniel, Gragg, Kaufman and Stewart). The projection
+    // coefficients are accumulated in h. The basis is processed in column tiles, which
+    // stay in the cache while all basis rows are visited.
+    const size_t        tile = 512;
+    std::vector<double> partial(nbrOfBlocks * (m + 1));
+    std::vector<double> coef(m + 1);
+    auto rowNorm = [&](size_t r) { return std::sqrt(Kernels::dot(v.data() + r * n, v.data() + r * n, n)); };
+    auto orthogonalize = [&](size_t r, size_t cnt, std::vector<double>& h) {
+        std::fill(h.begin(), h.begin() + cnt, 0.0);
+        double norm = rowNorm(r);
+        for (size_t pass = 0; pass < 2 && cnt > 0; pass++)
+        {
+            Parallel::forRange(0, nbrOfBlocks, [&](size_t bb, size_t be) {
+                for (size_t blk = bb; blk < be; blk++)
+                {
+                    double* p  = partial.data() + blk * (m + 1);
+                    size_t  c1 = std::min(n, (blk + 1) * blockSize);
+                    std::fill(p, p + cnt, 0.0);
+                    for (size_t c = blk * blockSize; c < c1; c += tile)
+                    {
+                        size_t len = std::min(tile, c1 - c);
+                        for (size_t i = 0; i < cnt; i++)
+                            p[i] += Kernels::dot(v.data() + i * n + c, v.data() + r * n + c, len);
+                    }
+                }
+            }, nbrOfThreads);
+
+            for (size_t i = 0; i < cnt; i++)
+            {
+                coef[i] = 0.0;
+                for (size_t blk = 0; blk < nbrOfBlocks; blk++)
+                    coef[i] += partial[blk * (m + 1) + i];
+                h[i] += coef[i];
+            }
+
+            Parallel::forRange(0, n, [&](size_t b, size_t e) {
+                for (size_t c = b; c < e; c += tile)
+                {
+                    size_t len = std::min(tile, e - c);
+                    for (size_t i = 0; i < cnt; i++)
+                        Kernels::axpy(v.data() + r * n + c, v.data() + i * n + c, len, -coef[i]);
+                }
+            }, nbrOfThreads, minChunk);
+
+            double newNorm = rowNorm(r);
+            if (newNorm > 0.7071 * norm)
+                break;
+            norm = newNorm;
+        }
+    };
+
+    // Fills row r with a random vector orthonormal to the rows [0, r)
+    std::mt19937                           gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double>                    h(m + 1);
+    auto randomRow = [&](size_t r) {
+        for (size_t c = 0; c < n; c++)
+            v(r, c) = dist(gen);
+        orthogonalize(r, r, h);
+        Kernels::scale(v.data() + r * n, n, 1.0 / rowNorm(r));
+    };
+
+    Matrix<double> x(n, 1);
+    Matrix<double> y(n, 1);
+    randomRow(0);
+
+    size_t l    = 0; // number of kept Ritz vectors
+    double beta = 0.0;
+    for (size_t restart = 0;; restart++)
+    {
+        // extend the basis from l to m vectors, row m holds the residual direction
+        for (size_t j = l; j < m; j++)
+        {
+            std::copy(v.data() + j * n, v.data() + (j + 1) * n, x.data());
+            op(x, y);
+            std::copy(y.data(), y.data() + n, v.data() + (j + 1) * n);
+
+            orthogonalize(j + 1, j + 1, h);
+            for (size_t i = 0; i <= j; i++)
+            {
+                t(i, j) = h[i];
+                t(j, i) = h[i];
+            }
+
+            beta         = rowNorm(j + 1);
+            double hNorm = std::sqrt(Kernels::dot(h.data(), h.data(), j + 1) + beta * beta);
+            if (beta <= std::numeric_limits<double>::epsilon() * hNorm)
+            {
+                // invariant subspace found: continue with an uncoupled vector
+                beta = 0.0;
+                if (j + 1 < n)
+                    randomRow(j + 1);
+            }
+            else
+            {
+                Kernels::scale(v.data() + (j + 1) * n, n, 1.0 / beta);
+            }
+        }
+
+        // Rayleigh-Ritz: A * V * Y = V * Y * D + beta * v_m * Y(m-1, :)
+        SymmetricEigenResult ritz  = symmetricEigen(t, true, nbrOfThreads);
+        double               anorm = std::max(std::abs(ritz.Values.front()), std::abs(ritz.Values.back()));
+        double               tol   = precision * std::max(anorm, std::numeric_limits<double>::min());
+
+        auto wanted = [&](size_t s) { return largest ? m - 1 - s : s; };
+
+        bool converged = true;
+        for (size_t s = 0; s < k; s++)
+            converged = converged && std::abs(beta * ritz.Vectors(m - 1, wanted(s))) <= tol;
+
+        // a basis of dimension n spans the whole space, the Ritz pairs are exact
+        bool   last = converged || restart >= maxRestarts || m == n;
+        size_t keep = last ? k : std::max(k, std::min(m - 2, (k + m) / 2));
+
+        // Ritz vectors of the kept Ritz values replace the basis
+        Matrix<double> ritzVectors(keep, n);
+        Parallel::forRange(0, n, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; c += tile)
+            {
+                size_t len = std::min(tile, e - c);
+                for (size_t s = 0; s < keep; s++)
+                {
+                    double* dst = ritzVectors.data() + s * n + c;
+                    std::fill(dst, dst + len, 0.0);
+                    for (size_t i = 0; i < m; i++)
+                        Kernels::axpy(dst, v.data() + i * n + c, len, ritz.Vectors(i, wanted(s)));
+                }
+            }
+        }, nbrOfThreads, minChunk);
+
+        if (last)
+        {
+            for (size_t s = 0; s < k; s++)
+            {
+                bool valid = ritz.Valid && std::abs(beta * ritz.Vectors(m - 1, wanted(s))) <= tol;
+                ret.push_back(EigenPair(Matrix<double>(n, 1, ritzVectors.data() + s * n), ritz.Values[wanted(s)], valid));
+            }
+            return ret;
+        }
+
+        // the projected matrix becomes an arrow matrix: Ritz values on the diagonal,
+        // the couplings to the residual direction are computed by the next extension
+        std::copy(ritzVectors.data(), ritzVectors.data() + keep * n, v.data());
+        std::copy(v.data() + m * n, v.data() + (m + 1) * n, v.data() + keep * n);
+        t.fill(0.0);
+        for (size_t s = 0; s < keep; s++)
+            t(s, s) = ritz.Values[wanted(s)];
+        l = keep;
+    }
+}
+
+inline bool Decomposition::tridiagonalDivideAndConquer(std::vector<double>& d, std::vector<double>& e, Matrix<double>& q, size_t nbrOfThreads)
+{
+    // Cuppen: A divide and conquer method for the symmetric tridiagonal eigenproblem (1981)
+    size_t n = d.size();
+
+    if (n <= divideAndConquerLeafSize())
+    {
+        Matrix<double> qt    = Matrix<double>::identity(n);
+        bool           valid = symmetricTridiagonalQRInPlace(d, e, &qt, 30, std::numeric_limits<double>::epsilon(), false);
+
+        std::vector<size_t> perm(n);
+        for (size_t i = 0; i < n; i++)
+            perm[i] = i;
+        std::sort(perm.begin(), perm.end(), [&d](size_t x, size_t y) { return d[x] < d[y]; });
+
+        std::vector<double> sorted(n);
+        q = Matrix<double>(n, n);
+        for (size_t c = 0; c < n; c++)
+        {
+            sorted[c] = d[perm[c]];
+            for (size_t r = 0; r < n; r++)
+                q(r, c) = qt(perm[c], r);
+        }
+        d = sorted;
+
+        return valid;
+    }
+
+    // T = diag(T1, T2) + |beta| * v * v', where v = [e_m-1; sign(beta) * e_0]
+    size_t m    = n / 2;
+    double beta = e[m - 1];
+
+    std::vector<double> d1(d.begin(), d.begin() + m);
+    std::vector<double> e1(e.begin(), e.begin() + (m - 1));
+    std::vector<double> d2(d.begin() + m, d.end());
+    std::vector<double> e2(e.begin() + m, e.end());
+    d1[m - 1] -= std::abs(beta);
+    d2[0] -= std::abs(beta);
+
+    // the two halves are independent
+    Matrix<double> q1;
+    Matrix<double> q2;
+    bool           valid1      = true;
+    bool           valid2      = true;
+    size_t         halfThreads = std::max<size_t>(1, nbrOfThreads / 2);
+    Parallel::forRange(0, 2, [&](size_t b, size_t en) {
+        for (size_t h = b; h < en; h++)
+        {
+            if (h == 0)
+                valid1 = tridiagonalDivideAndConquer(d1, e1, q1, halfThreads);
+            else
+                valid2 = tridiagonalDivideAndConquer(d2, e2, q2, std::max<size_t>(1, nbrOfThreads - halfThreads));
+        }
+    }, std::min<size_t>(2, nbrOfThreads));
+
+    q = Matrix<double>(n, n);
+    q.fill(0.0);
+    q.setSubMatrix(0, 0, q1);
+    q.setSubMatrix(m, m, q2);
+    std::copy(d1.begin(), d1.end(), d.begin());
+    std::copy(d2.begin(), d2.end(), d.begin() + m);
+
+    divideAndConquerMerge(d, q, m, beta, nbrOfThreads);
+
+    return valid1 && valid2;
+}
+
+inline void Decomposition::divideAndConquerMerge(std::vector<double>& d, Matrix<double>& q, size_t m, double beta, size_t nbrOfThreads)
+{
+    // T = q * (D + rho * z * z') * q', where z = q' * v. Deflation and the stable computation of the
+    // Eigen vectors follow LAPACK dlaed2 and Gu, Eisenstat: A divide-and-conquer algorithm for the
+    // symmetric tridiagonal eigenproblem (1995).
+    const double eps = std::numeric_limits<double>::epsilon();
+    size_t       n   = d.size();
+    double*      qd  = q.data();
+
+    std::vector<double> z(n);
+    for (size_t i = 0; i < m; i++)
+        z[i] = q(m - 1, i);
+    for (size_t i = m; i < n; i++)
+        z[i] = std::copysign(1.0, beta) * q(m, i);
+
+    double zz = 0.0;
+    for (size_t i = 0; i < n; i++)
+        zz += z[i] * z[i];
+    double rho = std::abs(beta) * zz;
+    for (size_t i = 0; i < n; i++)
+        z[i] /= std::sqrt(zz);
+
+    // sort ascending, col maps the sorted index to the column of q
+    std::vector<size_t> col(n);
+    for (size_t i = 0; i < n; i++)
+        col[i] = i;
+    std::sort(col.begin(), col.end(), [&d](size_t x, size_t y) { return d[x] < d[y]; });
+
+    std::vector<double> ds(n);
+    std::vector<double> zs(n);
+    double              dMax = 0.0;
+    double              zMax = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        ds[i] = d[col[i]];
+        zs[i] = z[col[i]];
+        dMax  = std::max(dMax, std::abs(ds[i]));
+        zMax  = std::max(zMax, std::abs(zs[i]));
+    }
+
+    // Deflation: a negligible z component leaves the Eigen pair of D unchanged. Of
+    // two close Eigen values, a rotation zeros one z component.
+    double              tol = 8.0 * eps * std::max(dMax, zMax);
+    std::vector<size_t> kept;
+    std::vector<size_t> deflated;
+    size_t              pj     = 0;
+    bool                havePj = false;
+    for (size_t j = 0; j < n; j++)
+    {
+        if (rho * std::abs(zs[j]) <= tol)
+        {
+            deflated.push_back(j);
+            continue;
+        }
+
+        if (havePj)
+        {
+            double tau = std::hypot(zs[j], zs[pj]);
+            double c   = zs[j] / tau;
+            double s   = -zs[pj] / tau;
+            if (std::abs((ds[j] - ds[pj]) * c * s) <= tol)
+            {
+                zs[j]  = tau;
+                zs[pj] = 0.0;
+                Kernels::rot(qd + col[pj], qd + col[j], n, c, -s, n);
+
+                double t = ds[pj] * c * c + ds[j] * s * s;
+                ds[j]    = ds[pj] * s * s + ds[j] * c * c;
+                ds[pj]   = t;
+                deflated.push_back(pj);
+            }
+            else
+            {
+                kept.push_back(pj);
+            }
+        }
+        pj     = j;
+        havePj = true;
+    }
+    if (havePj)
+        kept.push_back(pj);
+
+    // secular equation 1 + rho * sum(z_i^2 / (d_i - l)) = 0 of the kept part
+    size_t              k = kept.size();
+    std::vector<double> dk(k);
+    std::vector<double> zk(k);
+    double              zkNorm2 = 0.0;
+    for (size_t i = 0; i < k; i++)
+    {
+        dk[i] = ds[kept[i]];
+        zk[i] = zs[kept[i]];
+        zkNorm2 += zk[i] * zk[i];
+    }
+
+    // root j is stored relative to the closest pole: l_j = dk[origin[j]] + tau[j]
+    std::vector<size_t> origin(k);
+    std::vector<double> tau(k);
+    Parallel::forRange(0, k, [&](size_t b, size_t en) {
+        std::vector<double> delta(k);
+        for (size_t j = b; j < en; j++)
+        {
+            if (k == 1)
+            {
+                origin[j] = 0;
+                tau[j]    = rho * zk[0] * zk[0];
+                continue;
+            }
+
+            size_t o;
+            double lo;
+            double hi;
+            if (j + 1 < k)
+            {
+                // the sign of f in the middle of the interval tells which pole is closer to the root
+                double mid  = 0.5 * (dk[j + 1] - dk[j]);
+                double fMid = 1.0;
+                for (size_t i = 0; i < k; i++)
+                    fMid += rho * zk[i] * zk[i] / ((dk[i] - dk[j]) - mid);
+
+                o  = fMid >= 0.0 ? j : j + 1;
+                lo = fMid >= 0.0 ? 0.0 : -mid;
+                hi = fMid >= 0.0 ? mid : 0.0;
+            }
+            else
+            {
+                o  = j;
+                lo = 0.0;
+                hi = rho * zkNorm2;
+            }
+
+            for (size_t i = 0; i < k; i++)
+                delta[i] = dk[i] - dk[o];
+
+            // the rational model c + s / (delta_pa - x) + S / (delta_pb - x) interpolates f and f',
+            // where pa, pb are the two poles next to the root. Its root is safeguarded by bisection.
+            size_t pa = std::min(j, k - 2);
+            size_t pb = pa + 1;
+            double t  = 0.5 * (lo + hi);
+            for (size_t iter = 0; iter < 100; iter++)
+            {
+                double psi  = 0.0;
+                double dpsi = 0.0;
+                double phi  = 0.0;
+                double dphi = 0.0;
+                for (size_t i = 0; i < k; i++)
+                {
+                    double r    = 1.0 / (delta[i] - t);
+                    double term = rho * zk[i] * zk[i] * r;
+                    if (i <= pa)
+                    {
+                        psi += term;
+                        dpsi += term * r;
+                    }
+                    else
+                    {
+                        phi += term;
+                        dphi += term * r;
+                    }
+                }
+
+                double f = 1.0 + psi + phi;
+                if (std::abs(f) <= eps * (1.0 + std::abs(psi) + std::abs(phi)))
+                    break;
+                if (f < 0.0)
+                    lo = t;
+                else
+                    hi = t;
+
+                double da = delta[pa] - t;
+                double db = delta[pb] - t;
+                double c  = f - dpsi * da - dphi * db;
+                double qa = c * (da + db) + dpsi * da * da + dphi * db * db;
+                double qb = da * db * f;
+
+                // c * eta^2 - qa * eta + qb = 0, take the root inside the bracket
+                double eta   = 0.0;
+                bool   found = false;
+                double cand[2];
+                size_t nbrCand = 0;
+                if (c == 0.0)
+                {
+                    if (qa != 0.0)
+                        cand[nbrCand++] = qb / qa;
+                }
+                else
+                {
+                    double h = 0.5 * (qa + std::copysign(std::sqrt(std::max(0.0, qa * qa - 4.0 * c * qb)), qa));
+                    if (h != 0.0)
+                    {
+                        cand[nbrCand++] = h / c;
+                        cand[nbrCand++] = qb / h;
+                    }
+                }
+                for (size_t ci = 0; ci < nbrCand; ci++)
+                {
+                    double tc = t + cand[ci];
+                    if (tc > lo && tc < hi && (!found || std::abs(cand[ci]) < std::abs(eta)))
+                    {
+                        eta   = cand[ci];
+                        found = true;
+                    }
+                }
+
+                double tNew = found ? t + eta : 0.5 * (lo + hi);
+                bool   done = std::abs(tNew - t) <= 2.0 * eps * std::max(std::abs(t), std::abs(tNew));
+                t           = tNew;
+                if (done)
+                    break;
+            }
+
+            origin[j] = o;
+            tau[j]    = t;
+        }
+    }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, 20 * k)));
+
+    // l_j - dk[i], computed without cancellation
+    auto rootMinusPole = [&](size_t j, size_t i) { return (dk[origin[j]] - dk[i]) + tau[j]; };
+
+    // Gu, Eisenstat: z is recomputed from the roots, which makes the Eigen vectors numerically orthogonal
+    std::vector<double> zHat(k);
+    Parallel::forRange(0, k, [&](size_t b, size_t en) {
+        for (size_t i = b; i < en; i++)
+        {
+            double prod = rootMinusPole(k - 1, i) / rho;
+            for (size_t j = 0; j < i; j++)
+                prod *= rootMinusPole(j, i) / (dk[j] - dk[i]);
+            for (size_t j = i; j + 1 < k; j++)
+                prod *= rootMinusPole(j, i) / (dk[j + 1] - dk[i]);
+            zHat[i] = std::copysign(std::sqrt(std::abs(prod)), zk[i]);
+        }
+    }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, 4 * k)));
+
+    // Eigen vectors of D + rho * z * z': u_j(i) = zHat_i / (d_i - l_j), the columns of u
+    Matrix<double> u(k, k);
+    Parallel::forRange(0, k, [&](size_t b, size_t en) {
+        for (size_t j = b; j < en; j++)
+        {
+            double norm = 0.0;
+            for (size_t i = 0; i < k; i++)
+            {
+                double x = zHat[i] / rootMinusPole(j, i);
+                norm += x * x;
+            }
+            norm = std::sqrt(norm);
+            for (size_t i = 0; i < k; i++)
+                u(i, j) = -zHat[i] / (rootMinusPole(j, i) * norm);
+        }
+    }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, 4 * k)));
+
+    // new Eigen vectors q * u_j and the deflated columns, sorted by Eigen value
+    std::vector<double> values(n);
+    std::vector<size_t> source(n); // < k: kept root, otherwise deflated index + k
+    for (size_t j = 0; j < k; j++)
+    {
+        values[j] = dk[origin[j]] + tau[j];
+        source[j] = j;
+    }
+    for (size_t i = 0; i < deflated.size(); i++)
+    {
+        values[k + i] = ds[deflated[i]];
+        source[k + i] = k + i;
+    }
+
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&values](size_t x, size_t y) { return values[x] < values[y]; });
+
+    Matrix<double> res(n, n);
+    Parallel::forRange(0, n, [&](size_t b, size_t en) {
+        std::vector<double> w(k);
+        for (size_t r = b; r < en; r++)
+        {
+            // w = q(r, kept) * U, rows of q are half zero before the merge
+            const double* qRow = qd + r * n;
+            std::fill(w.begin(), w.end(), 0.0);
+            for (size_t i = 0; i < k; i++)
+            {
+                double qi = qRow[col[kept[i]]];
+                if (qi != 0.0)
+                    Kernels::axpy(w.data(), u.data() + i * k, k, qi);
+            }
+
+            double* resRow = res.data() + r * n;
+            for (size_t p = 0; p < n; p++)
+            {
+                size_t src = source[order[p]];
+                resRow[p]  = src < k ? w[src] : qRow[col[deflated[src - k]]];
+            }
+        }
+    }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, n * k)));
+
+    for (size_t p = 0; p < n; p++)
+        d[p] = values[order[p]];
+    q = res;
+}
+
+inline bool Decomposition::symmetricTridiagonalQRInPlace(std::vector<double>& d, std::vector<double>& e, Matrix<double>* qt,
+                                                         size_t maxIteration, double precision, bool showProgress)
+{
+    // Golub, Van Loan: Matrix Computations, algorithm 8.3.3
+    size_t n = d.size();
+    precision = std::max(precision, std::numeric_limits<double>::epsilon());
+
+    // besides the relative test, entries below machine precision of the
+    // matrix norm are neglected, which stops graded matrices from stalling
+    double tNorm = 0.0;
+    for (size_t k = 0; k < n; k++)
+        tNorm = std::max(tNorm, std::abs(d[k]) + (k + 1 < n ? std::abs(e[k]) : 0.0) + (k > 0 ? std::abs(e[k - 1]) : 0.0));
+    double absTol = std::numeric_limits<double>::epsilon() * tNorm;
+
+    auto negligible = [&d, &e, precision, absTol](size_t k) {
+        return std::abs(e[k]) <= precision * (std::abs(d[k]) + std::abs(d[k + 1])) || std::abs(e[k]) <= absTol ||
+               std::abs(e[k]) < std::numeric_limits<double>::min();
+    };
+
+    size_t hi   = n > 0 ? n - 1 : 0;
+    size_t iter = 0;
+    while (hi > 0)
+    {
+        // deflate converged Eigen value at the bottom
+        if (negligible(hi - 1))
+        {
+            e[hi - 1] = 0.0;
+            hi--;
+            iter = 0;
+
+            if (showProgress)
+                std::cout << "qrAlgorithm progress = " << static_cast<double>(n - hi) / static_cast<double>(n) << std::endl;
+
+            continue;
+        }
+
+        // start of the unreduced block, which ends at hi
+        size_t lo = hi - 1;
+        while (lo > 0 && !negligible(lo - 1))
+            lo--;
+        if (lo > 0)
+            e[lo - 1] = 0.0;
+
+        if (++iter > maxIteration)
+            return false;
+
+        // Wilkinson shift: Eigen value of the trailing 2x2 block, which is closer to d[hi]
+        double dd = 0.5 * (d[hi - 1] - d[hi]);
+        double mu = d[hi] - e[hi - 1] * e[hi - 1] / (dd + std::copysign(std::hypot(dd, e[hi - 1]), dd));
+
+        // implicit QR sweep: the first rotation introduces a bulge, which is chased down
+        double x = d[lo] - mu;
+        double z = e[lo];
+        for (size_t k = lo; k < hi; k++)
+        {
+            double r = std::hypot(x, z);
+            double c = 1.0;
+            double s = 0.0;
+            if (r != 0.0)
+            {
+                c = x / r;
+                s = z / r;
+            }
+            if (k > lo)
+                e[k - 1] = r;
+
+            double a = d[k];
+            double b = e[k];
+            double f = d[k + 1];
+            d[k]     = c * c * a + 2.0 * c * s * b + s * s * f;
+            d[k + 1] = s * s * a - 2.0 * c * s * b + c * c * f;
+            e[k]     = c * s * (f - a) + (c * c - s * s) * b;
+
+            if (k + 1 < hi)
+            {
+                x = e[k];
+                z = s * e[k + 1];
+                e[k + 1] *= c;
+            }
+
+            if (qt != nullptr)
+            {
+                size_t cols = qt->cols();
+                Kernels::rot(qt->data() + k * cols, qt->data() + (k + 1) * cols, cols, c, -s);
+            }
+        }
+    }
+
+    return true;
+}
+
+inline bool Decomposition::schurInPlace(Matrix<double>& h, Matrix<double>* q, size_t maxIteration, double precision,
+                                        std::vector<double>& lReal, std::vector<double>& lImag, bool showProgress)
+{
+    // Golub, Van Loan: Matrix Computations, algorithms 7.5.1 and 7.5.2
+    size_t n  = h.rows();
+    size_t qn = q != nullptr ? q->rows() : 0;
+    precision = std::max(precision, std::numeric_limits<double>::epsilon());
+
+    lReal.resize(n);
+    lImag.assign(n, 0.0);
+    for (size_t k = 0; k < n; k++)
+        lReal[k] = h(k, k);
+
+    double norm = 0.0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = (i > 0 ? i - 1 : 0); j < n; j++)
+            norm += std::abs(h(i, j));
+
+    // applies the reflector I - tau * [1 v1 v2] * [1 v1 v2]' to the rows k:k+nv (left)
+    // or columns k:k+nv (right) of h, and to the columns of q. nv is 1 or 2.
+    auto reflectRows = [&h, n](size_t k, size_t nv, double tau, double v1, double v2, size_t colBegin) {
+        for (size_t j = colBegin; j < n; j++)
+        {
+            double sum = h(k, j) + v1 * h(k + 1, j);
+            if (nv == 2)
+                sum += v2 * h(k + 2, j);
+            sum *= tau;
+            h(k, j) -= sum;
+            h(k + 1, j) -= sum * v1;
+            if (nv == 2)
+                h(k + 2, j) -= sum * v2;
+        }
+    };
+    auto reflectColumns = [](Matrix<double>& m, size_t k, size_t nv, double tau, double v1, double v2, size_t rowEnd) {
+        for (size_t i = 0; i < rowEnd; i++)
+        {
+            double* row = m.data() + i * m.cols() + k;
+            double  sum = row[0] + v1 * row[1];
+            if (nv == 2)
+                sum += v2 * row[2];
+            sum *= tau;
+            row[0] -= sum;
+            row[1] -= sum * v1;
+            if (nv == 2)
+                row[2] -= sum * v2;
+        }
+    };
+
+    size_t end  = n; // active block ends at end - 1
+    size_t iter = 0;
+    while (end > 0)
+    {
+        size_t hi = end - 1;
+
+        // look for a negligible subdiagonal entry
+        size_t l = hi;
+        while (l > 0)
+        {
+            double s = std::abs(h(l - 1, l - 1)) + std::abs(h(l, l));
+            if (s == 0.0)
+                s = norm;
+            if (std::abs(h(l, l - 1)) <= precision * s || std::abs(h(l, l - 1)) < std::numeric_limits<double>::min())
+            {
+                h(l, l - 1) = 0.0;
+                break;
+            }
+            l--;
+        }
+
+        if (l + 1 >= hi)
+        {
+            if (l == hi)
+            {
+                // 1x1 block converged
+                lReal[hi] = h(hi, hi);
+                end -= 1;
+            }
+            else
+            {
+                // 2x2 block converged. A real pair is split by a rotation.
+                size_t p    = hi - 1;
+                double w    = h(hi, p) * h(p, hi);
+                double pp   = 0.5 * (h(p, p) - h(hi, hi));
+                double disc = pp * pp + w;
+                if (disc >= 0.0)
+                {
+                    double z = pp + std::copysign(std::sqrt(disc), pp);
+                    double r = std::hypot(h(hi, p), z);
+                    double c = z / r;
+                    double s = h(hi, p) / r;
+                    Kernels::rot(h.data() + p * n + p, h.data() + hi * n + p, n - p, c, -s);
+                    Kernels::rot(h.data() + p, h.data() + hi, hi + 1, c, -s, n);
+                    if (q != nullptr)
+                        Kernels::rot(q->data() + p, q->data() + hi, qn, c, -s, q->cols());
+                    h(hi, p) = 0.0;
+
+                    lReal[p]  = h(p, p);
+                    lReal[hi] = h(hi, hi);
+                }
+                else
+                {
+                    lReal[p]  = h(hi, hi) + pp;
+                    lReal[hi] = lReal[p];
+                    lImag[p]  = std::sqrt(-disc);
+                    lImag[hi] = -lImag[p];
+                }
+                end -= 2;
+            }
+            iter = 0;
+
+            if (showProgress)
+                std::cout << "qrAlgorithm progress = " << static_cast<double>(n - end) / static_cast<double>(n) << std::endl;
+
+            continue;
+        }
+
+        if (++iter > maxIteration)
+            return false;
+
+        // double shift by the Eigen values of the trailing 2x2 block. Exceptional
+        // shifts every 10 iterations break cycles.
+        double s;
+        double t;
+        if (iter % 10 == 0)
+        {
+            double w = std::abs(h(hi, hi - 1)) + std::abs(h(hi - 1, hi - 2));
+            s        = 1.5 * w;
+            t        = w * w;
+        }
+        else
+        {
+            s = h(hi - 1, hi - 1) + h(hi, hi);
+            t = h(hi - 1, hi - 1) * h(hi, hi) - h(hi - 1, hi) * h(hi, hi - 1);
+        }
+
+        // first column of (H - s1 * I) * (H - s2 * I)
+        double x = h(l, l) * h(l, l) + h(l, l + 1) * h(l + 1, l) - s * h(l, l) + t;
+        double y = h(l + 1, l) * (h(l, l) + h(l + 1, l + 1) - s);
+        double z = h(l + 1, l) * h(l + 2, l + 1);
+
+        // chase the bulge with 3x3 reflectors, the last one is 2x2
+        for (size_t k = l; k + 1 <= hi; k++)
+        {
+            size_t nv    = (k + 2 <= hi) ? 2 : 1;
+            double xnorm = (nv == 2) ? std::hypot(y, z) : std::abs(y);
+            if (xnorm != 0.0)
+            {
+                double beta = -std::copysign(std::hypot(x, xnorm), x);
+                double tau  = (beta - x) / beta;
+                double v1   = y / (x - beta);
+                double v2   = (nv == 2) ? z / (x - beta) : 0.0;
+
+                size_t r = (k > l) ? k - 1 : l;
+                reflectRows(k, nv, tau, v1, v2, r);
+                if (k > l)
+                {
+                    h(k, k - 1)     = beta;
+                    h(k + 1, k - 1) = 0.0;
+                    if (nv == 2)
+                        h(k + 2, k - 1) = 0.0;
+                }
+
+                reflectColumns(h, k, nv, tau, v1, v2, std::min(k + 3, hi) + 1);
+                if (q != nullptr)
+                    reflectColumns(*q, k, nv, tau, v1, v2, qn);
+            }
+
+            if (nv == 2)
+            {
+                x = h(k + 1, k);
+                y = h(k + 2, k);
+                if (k + 3 <= hi)
+                    z = h(k + 3, k);
+            }
+        }
+    }
+
+    return true;
+}
+
+inline Matrix<double> Decomposition::schurEigenVectors(const Matrix<double>& t, const Matrix<double>& q,
+                                                       const std::vector<double>& lReal, const std::vector<double>& lImag)
+{
+    // Back substitution (T - l * I) * x = 0 from the bottom up, as in EISPACK hqr2.
+    // The solutions overwrite the upper triangle of h.
+    size_t         n   = t.rows();
+    Matrix<double> h   = t;
+    const double   eps = std::numeric_limits<double>::epsilon();
+
+    double norm = 0.0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = (i > 0 ? i - 1 : 0); j < n; j++)
+            norm += std::abs(h(i, j));
+
+    if (norm == 0.0)
+        return q;
+
+    for (size_t c = n; c-- > 0;)
+    {
+        double p  = lReal[c];
+        double qi = lImag[c];
+
+        double z = 0.0;
+        double r = 0.0;
+        double s = 0.0;
+
+        if (qi == 0.0)
+        {
+            // real vector
+            size_t l = c;
+            h(c, c)  = 1.0;
+            for (size_t i = c; i-- > 0;)
+            {
+                double w = h(i, i) - p;
+                double ra = 0.0;
+                for (size_t j = l; j <= c; j++)
+                    ra += h(i, j) * h(j, c);
+
+                if (lImag[i] < 0.0)
+                {
+                    // second row of a complex 2x2 block: solved together with the first one
+                    z = w;
+                    r = ra;
+                }
+                else
+                {
+                    l = i;
+                    if (lImag[i] == 0.0)
+                    {
+                        h(i, c) = (w != 0.0) ? -ra / w : -ra / (eps * norm);
+                    }
+                    else
+                    {
+                        double x  = h(i, i + 1);
+                        double y  = h(i + 1, i);
+                        double qd = (lReal[i] - p) * (lReal[i] - p) + lImag[i] * lImag[i];
+                        double xi = (x * r - z * ra) / qd;
+                        h(i, c)   = xi;
+                        h(i + 1, c) = (std::abs(x) > std::abs(z)) ? (-ra - w * xi) / x : (-r - y * xi) / z;
+                    }
+
+                    // overflow control
+                    double mx = std::abs(h(i, c));
+                    if ((eps * mx) * mx > 1.0)
+                        for (size_t j = i; j <= c; j++)
+                            h(j, c) /= mx;
+                }
+            }
+        }
+        else if (qi < 0.0)
+        {
+            // complex vector of the pair (c-1, c): real part in column c-1, imaginary part in column c.
+            // The last component is chosen imaginary, which makes the 2x2 block triangular.
+            size_t l = c - 1;
+            if (std::abs(h(c, c - 1)) > std::abs(h(c - 1, c)))
+            {
+                h(c - 1, c - 1) = qi / h(c, c - 1);
+                h(c - 1, c)     = -(h(c, c) - p) / h(c, c - 1);
+            }
+            else
+            {
+                complexDivision(0.0, -h(c - 1, c), h(c - 1, c - 1) - p, qi, h(c - 1, c - 1), h(c - 1, c));
+            }
+            h(c, c - 1) = 0.0;
+            h(c, c)     = 1.0;
+
+            for (size_t i = c - 1; i-- > 0;)
+            {
+                double ra = 0.0;
+                double sa = 0.0;
+                for (size_t j = l; j <= c; j++)
+                {
+                    ra += h(i, j) * h(j, c - 1);
+                    sa += h(i, j) * h(j, c);
+                }
+                double w = h(i, i) - p;
+
+                if (lImag[i] < 0.0)
+                {
+                    z = w;
+                    r = ra;
+                    s = sa;
+                }
+                else
+                {
+                    l = i;
+                    if (lImag[i] == 0.0)
+                    {
+                        complexDivision(-ra, -sa, w, qi, h(i, c - 1), h(i, c));
+                    }
+                    else
+                    {
+                        double x  = h(i, i + 1);
+                        double y  = h(i + 1, i);
+                        double vr = (lReal[i] - p) * (lReal[i] - p) + lImag[i] * lImag[i] - qi * qi;
+                        double vi = (lReal[i] - p) * 2.0 * qi;
+                        if (vr == 0.0 && vi == 0.0)
+                            vr = eps * norm * (std::abs(w) + std::abs(qi) + std::abs(x) + std::abs(y) + std::abs(z));
+
+                        complexDivision(x * r - z * ra + qi * sa, x * s - z * sa - qi * ra, vr, vi, h(i, c - 1), h(i, c));
+                        if (std::abs(x) > std::abs(z) + std::abs(qi))
+                        {
+                            h(i + 1, c - 1) = (-ra - w * h(i, c - 1) + qi * h(i, c)) / x;
+                            h(i + 1, c)     = (-sa - w * h(i, c) - qi * h(i, c - 1)) / x;
+                        }
+                        else
+                        {
+                            complexDivision(-r - y * h(i, c - 1), -s - y * h(i, c), z, qi, h(i + 1, c - 1), h(i + 1, c));
+                        }
+                    }
+
+                    // overflow control
+                    double mx = std::max(std::abs(h(i, c - 1)), std::abs(h(i, c)));
+                    if ((eps * mx) * mx > 1.0)
+                    {
+                        for (size_t j = i; j <= c; j++)
+                        {
+                            h(j, c - 1) /= mx;
+                            h(j, c) /= mx;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // the Eigen vectors of T are in the upper triangle of h
+    for (size_t i = 1; i < n; i++)
+        std::fill(h.data() + i * n, h.data() + i * n + i, 0.0);
+
+    return q * h;
+}
+
+inline std::vector<Decomposition::ComplexEigenPair> Decomposition::eigenComplexInPlace(Matrix<double>& a, size_t maxIteration, double precision, bool showProgress)
+{
+    size_t              n = a.rows();
+    std::vector<double> tau;
+    hessenbergPackedInPlace(a, tau, false);
+    Matrix<double> q = hessenbergPackedQ(a, tau);
+    for (size_t i = 2; i < n; i++)
+        std::fill(a.data() + i * n, a.data() + i * n + i - 1, 0.0);
+
+    std::vector<double> lReal;
+    std::vector<double> lImag;
+    bool                converged = schurInPlace(a, &q, maxIteration, precision, lReal, lImag, showProgress);
+    Matrix<double>      v         = schurEigenVectors(a, q, lReal, lImag);
+
+    std::vector<ComplexEigenPair> pairs;
+    for (size_t j = 0; j < n; j++)
+    {
+        // the pair with positive imaginary part is stored as columns (re, im), its conjugate follows
+        Matrix<double> vr = v.column(j);
+        Matrix<double> vi(n, 1);
+        vi.fill(0.0);
+        if (lImag[j] > 0.0)
+        {
+            vi = v.column(j + 1);
+        }
+        else if (lImag[j] < 0.0)
+        {
+            vr = v.column(j - 1);
+            vi = v.column(j) * -1.0;
+        }
+
+        // normalize to length 1 and rotate the largest component onto the positive real axis
+        size_t kMax = 0;
+        double sum  = 0.0;
+        for (size_t k = 0; k < n; k++)
+        {
+            double abs2 = vr(k, 0) * vr(k, 0) + vi(k, 0) * vi(k, 0);
+            if (abs2 > vr(kMax, 0) * vr(kMax, 0) + vi(kMax, 0) * vi(kMax, 0))
+                kMax = k;
+            sum += abs2;
+        }
+
+        double len = std::sqrt(sum);
+        double mx  = std::hypot(vr(kMax, 0), vi(kMax, 0));
+        if (len > 0.0 && mx > 0.0)
+        {
+            double cr = vr(kMax, 0) / (mx * len);
+            double ci = vi(kMax, 0) / (mx * len);
+            for (size_t k = 0; k < n; k++)
+            {
+                double re = vr(k, 0);
+                double im = vi(k, 0);
+                vr(k, 0)  = re * cr + im * ci;
+                vi(k, 0)  = im * cr - re * ci;
+            }
+            vi(kMax, 0) = 0.0;
+        }
+
+        pairs.push_back(ComplexEigenPair(vr, vi, lReal[j], lImag[j], converged));
+    }
+
+    return pairs;
+}
+
+template <class T>
+Decomposition::EigenPair Decomposition::powerIteration(const Matrix<T>& mat, size_t maxIteration, double precision)
+{
+    // Power iteration : https://en.wikipedia.org/wiki/Power_iteration
+    // Finds most significant eigenvalue
+
+    Matrix<double> matD = mat;
+    Matrix<double> eVec(matD.rows(), 1);
+    eVec.fill(1.0);
+    double eVal       = 1;
+    double eValBefore = eVal;
+
+    bool   validEigenPair  = false;
+    size_t nbrOfIterations = 0;
+    bool   go              = true;
+
+    while (go)
+    {
+        eVec = (matD * eVec).normalizeColumns();
+        eVal = rayleighQuotient(matD, eVec);
+
+        // check stopping criteria of power iteration
+        if (std::abs(eVal - eValBefore) < precision * std::abs(eVal + eValBefore))
+        {
+            go             = false;
+            validEigenPair = true;
+        }
+        else if (nbrOfIterations >= maxIteration)
+        {
+            go             = false;
+            validEigenPair = false;
+        }
+
+        eValBefore = eVal;
+        nbrOfIterations++;
+    }
+
+    return EigenPair(eVec, eVal, validEigenPair);
+}
+
+template <class T>
+std::vector<Decomposition::EigenPair> Decomposition::subspaceIteration(const Matrix<T>& mat, size_t k, const std::vector<EigenPair>& initialPairs,
+                                                                       size_t maxIteration, double precision, size_t nbrOfThreads)
+{
+    if (!mat.isSquare())
+        throw SquareMatrixException();
+
+    size_t n = mat.rows();
+    if (k > n)
+        throw InvalidInputException();
+
+    std::vector<EigenPair> ret;
+    if (k == 0)
+        return ret;
+
+    if (nbrOfThreads == 0)
+        nbrOfThreads = Parallel::defaultNbrOfThreads();
+
+    // The block vectors are the rows of x, the rows of y are the products A * x_s
+    Matrix<double> a = mat;
+    size_t         p = std::min(n, k + std::max<size_t>(k / 2, 4));
+    Matrix<double> x(p, n);
+    Matrix<double> y(p, n);
+    Matrix<double> ritzX(p, n);
+    Matrix<double> ritzY(p, n);
+
+    std::mt19937                           gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    // Modified Gram-Schmidt with one reorthogonalization. Dependent rows are replaced by random ones.
+    auto orthonormalize = [&](Matrix<double>& b) {
+        for (size_t s = 0; s < p; s++)
+        {
+            double* row = b.data() + s * n;
+            for (size_t attempt = 0;; attempt++)
+            {
+                double norm0 = std::sqrt(Kernels::dot(row, row, n));
+                for (size_t pass = 0; pass < 2; pass++)
+                {
+                    for (size_t i = 0; i < s; i++)
+                        Kernels::axpy(row, b.data() + i * n, n, -Kernels::dot(b.data() + i * n, row, n));
+                }
+
+                double norm = std::sqrt(Kernels::dot(row, row, n));
+                if (norm > 1e3 * std::numeric_limits<double>::epsilon() * norm0 || attempt > 2)
+                {
+                    Kernels::scale(row, n, 1.0 / norm);
+                    break;
+                }
+
+                for (size_t c = 0; c < n; c++)
+                    row[c] = dist(gen);
+            }
+        }
+    };
+
+    for (size_t s = 0; s < p; s++)
+    {
+        if (s < initialPairs.size() && initialPairs[s].V.rows() == n && initialPairs[s].V.cols() == 1)
+            std::copy(initialPairs[s].V.data(), initialPairs[s].V.data() + n, x.data() + s * n);
+        else
+            for (size_t c = 0; c < n; c++)
+                x(s, c) = dist(gen);
+    }
+    orthonormalize(x);
+
+    // dst row s = sum_i w(i, order[s]) * src row i, over column tiles
+    const size_t tile     = 512;
+    size_t       minChunk = std::max<size_t>(1, Kernels::ParallelGrainSize / (p * p));
+    auto combine = [&](const Matrix<double>& src, const Matrix<double>& w, const std::vector<size_t>& order, Matrix<double>& dst) {
+        Parallel::forRange(0, n, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; c += tile)
+            {
+                size_t len = std::min(tile, e - c);
+                for (size_t s = 0; s < p; s++)
+                {
+                    double* d = dst.data() + s * n + c;
+                    std::fill(d, d + len, 0.0);
+                    for (size_t i = 0; i < p; i++)
+                        Kernels::axpy(d, src.data() + i * n + c, len, w(i, order[s]));
+                }
+            }
+        }, nbrOfThreads, minChunk);
+    };
+
+    for (size_t iteration = 1;; iteration++)
+    {
+        // Block product: each matrix row is read once for all p vectors
+        Parallel::forRange(0, n, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; i++)
+                for (size_t s = 0; s < p; s++)
+                    y(s, i) = Kernels::dot(a.data() + i * n, x.data() + s * n, n);
+        }, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / (n * p)));
+
+        // Rayleigh-Ritz on the projected matrix x * A * x'
+        Matrix<double> h(p, p);
+        for (size_t s = 0; s < p; s++)
+        {
+            for (size_t t = s; t < p; t++)
+            {
+                double hst = 0.5 * (Kernels::dot(x.data() + s * n, y.data() + t * n, n) + Kernels::dot(x.data() + t * n, y.data() + s * n, n));
+                h(s, t)    = hst;
+                h(t, s)    = hst;
+            }
+        }
+
+        SymmetricEigenResult ritz = symmetricEigen(h, true, 1);
+        std::vector<size_t>  order(p);
+        for (size_t s = 0; s < p; s++)
+            order[s] = s;
+        std::sort(order.begin(), order.end(), [&ritz](size_t i, size_t j) { return std::abs(ritz.Values[i]) > std::abs(ritz.Values[j]); });
+
+        combine(x, ritz.Vectors, order, ritzX);
+        combine(y, ritz.Vectors, order, ritzY);
+
+        double tol = precision * std::max(std::abs(ritz.Values[order[0]]), std::numeric_limits<double>::min());
+
+        std::vector<bool> converged(k);
+        bool              allConverged = true;
+        for (size_t s = 0; s < k; s++)
+        {
+            Matrix<double> r(n, 1, ritzY.data() + s * n);
+            Kernels::axpy(r.data(), ritzX.data() + s * n, n, -ritz.Values[order[s]]);
+            converged[s] = ritz.Valid && r.norm() <= tol;
+            allConverged = allConverged && converged[s];
+        }
+
+        if (allConverged || iteration >= maxIteration)
+        {
+            for (size_t s = 0; s < k; s++)
+                ret.push_back(EigenPair(Matrix<double>(n, 1, ritzX.data() + s * n), ritz.Values[order[s]], converged[s]));
+            return ret;
+        }
+
+        // power step: the next block spans A times the Ritz vectors
+        std::copy(ritzY.data(), ritzY.data() + p * n, x.data());
+        orthonormalize(x);
+    }
+}
+
+// info: https://www.mathematik.uni-wuerzburg.de/~borzi/RQGradient_Chapter_10.pdf
+template <class T>
+double Decomposition::rayleighQuotient(const Matrix<T>& m, const Matrix<T>& v)
+{
+    Matrix<T> vT = v.transpose();
+    return static_cast<double>((vT * m * v)(0, 0)) / static_cast<double>((vT * v)(0, 0));
+}
+
+template <class T>
+Decomposition::HouseholderResult Decomposition::householder(const Matrix<T>& x)
+{
+    // generate basis vector [1.0, 0, 0, ..]
+    Matrix<double> e(x.rows(), 1);
+    e.fill(0.0);
+    e(0, 0) = 1.0;
+
+    double sign = 1.0;
+    if (x(0, 0) > 0.0)
+        sign = -1.0;
+
+    // vh -> Householder vector
+    Matrix<double> v = x - (e * x.norm() * sign);
+
+    // scalar
+    double b = 2.0 / (v.transpose() * v)(0, 0);
+
+    return HouseholderResult(b, v);
+}
+
+template <class T>
+Matrix<double> Decomposition::householderMatrix(const Matrix<T>& v, double b)
+{
+    Matrix<double> p = Matrix<double>::identity(v.rows());
+
+    if (std::isfinite(b))
+        p = p - b * v * v.transpose();
+
+    return p;
+}
+
+// Sources:
+// Householder bidiagonalization, Matrix computation, 4th ed, Golub & Loan, p.284
+// documents/bidiagonalization.pdf -> Martin Plesinger
+// Blocked form: LAPACK xGEBRD / xLABRD
+template <class T>
+Decomposition::DiagonalizationResult Decomposition::bidiagonalization(const Matrix<T>& a_m, bool computeU, bool computeV)
+{
+    size_t m = a_m.rows();
+    size_t n = a_m.cols();
+
+    if (m < n)
+    {
+        std::cout << "bidiagonalization: Invalid matrix dimension";
+        std::exit(-1);
+    }
+
+    Matrix<double>      a = a_m;
+    std::vector<double> tauQ;
+    std::vector<double> tauP;
+    bidiagonalPackedInPlace(a, tauQ, tauP);
+
+    Matrix<double> u = computeU ? bidiagonalPackedQ(a, tauQ, false) : Matrix<double>();
+    Matrix<double> v = computeV ? bidiagonalPackedP(a, tauP) : Matrix<double>();
+
+    // clear the reflectors
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++)
+            if (j != i && j != i + 1)
+                a(i, j) = 0.0;
+
+    return DiagonalizationResult(u, a, v);
+}
+
+// QR decomposition by using Householder reflection -> see documents/qr_decomposition.pdf
+template <class T>
+Decomposition::QRResult Decomposition::qr(const Matrix<T>& mat, bool positive, QRMethod method)
+{
+    switch (method)
+    {
+        case Householder:
+            return qr_householder(mat, positive);
+
+        case Givens:
+            return qr_givens(mat, positive);
+
+        case TSQR:
+        {
+            QRResult res = tsqr(mat, true);
+            if (positive)
+                makeDiagonalPositive(res);
+            return res;
+        }
+    }
+}
+
+// QR decomposition by using Householder reflection -> see documents/qr_decomposition.pdf
+template <class T>
+Decomposition::QRResult Decomposition::qr_householder(const Matrix<T>& mat, bool positive)
+{
+    // blocked, in place Householder QR. Q is formed from its reflectors at the end.
+    QRPackedResult packed = qrPacked(mat);
+
+    QRResult retResult(qrPackedQ(packed.QR, packed.Tau, false), qrPackedR(packed.QR, false));
+
+    if (positive)
+        makeDiagonalPositive(retResult);
+
+    return retResult;
+}
+
+inline void Decomposition::makeDiagonalPositive(QRResult& res)
+{
+    // There exist multiple qr solutions. To get a unique result,
+    // the diagonal elements on r are chosen to be positive.
+    // See qrSignModifier, here done in place.
+    Matrix<double>& q = res.Q;
+    Matrix<double>& r = res.R;
+    for (size_t i = 0; i < std::min(r.rows(), r.cols()); i++)
+    {
+        if (r(i, i) < 0)
+        {
+            for (size_t k = 0; k < q.rows(); k++)
+                q(k, i) = -q(k, i);
+
+            Kernels::scale(r.data() + i * r.cols(), r.cols(), -1.0);
+        }
+    }
+}
+
+// QR decomposition by using Givens rotations -> see documents/qr_decomposition.pdf
+// Sameh and Kuck, On stable parallel linear system solvers, 1978.
+// Element (i, j) is zeroed by rotating the rows i-1 and i in time step
+// t = (m - 1 - i) + 2j. All rotations of one step work on distinct row
+// pairs and run concurrently. The result equals the sequential
+// column by column, bottom up order.
+template <class T>
+Decomposition::QRResult Decomposition::qr_givens(const Matrix<T>& mat, bool positive)
+{
+    Matrix<double> r = mat;
+    size_t         m = r.rows();
+    size_t         n = r.cols();
+
+    // Q' is accumulated, so that the rotations work on rows
+    Matrix<double> qt = Matrix<double>::identity(m);
+
+    size_t nbrOfCols = std::min(n, m > 0 ? m - 1 : 0);
+    if (nbrOfCols > 0)
+    {
+        // the last rotation zeros (nbrOfCols, nbrOfCols - 1)
+        size_t nbrOfSteps = m - 2 + nbrOfCols;
+        for (size_t t = 0; t < nbrOfSteps; t++)
+        {
+            // columns with a rotation in this step: i = m - 1 - t + 2j in [j + 1, m - 1]
+            size_t jBegin = t + 2 > m ? t + 2 - m : 0;
+            size_t jEnd   = std::min(nbrOfCols, t / 2 + 1);
+            if (jBegin >= jEnd)
+                continue;
+
+            auto rotate = [&](size_t j0, size_t j1) {
+                for (size_t j = j0; j < j1; j++)
+                {
+                    size_t         i = m - 1 - t + 2 * j;
+                    GivensRotation g = givensRotation(r(i - 1, j), r(i, j));
+                    if (g.S == 0.0 && g.C == 1.0)
+                        continue;
+
+                    applyGivensRotationToRows(r, g, i - 1, i, j);
+                    applyGivensRotationToRows(qt, g, i - 1, i);
+                }
+            };
+
+            size_t workPerRotation = 2 * (n + m);
+            Parallel::forRange(jBegin, jEnd, rotate, 0, std::max<size_t>(1, Kernels::ParallelGrainSize / workPerRotation));
+        }
+    }
+
+    QRResult res(qt.transpose(), r);
+
+    if (positive)
+        makeDiagonalPositive(res);
+
+    return res;
+}
+
+template <class T>
+Decomposition::QRResult Decomposition::rq(const Matrix<T>& mat, QRMethod method)
+{
+    // info: https://math.stackexchange.com/questions/1640695/rq-decomposition
+    size_t m = mat.rows();
+
+    Matrix<double> p = Matrix<double>(m, m);
+    p.fill(0.0);
+    for (size_t i = 0; i < m; i++)
+    {
+        p(i, m - 1 - i) = 1.0;
+    }
+
+    Matrix<double> ad = p * mat; // reverses the rows in mat
+
+    Decomposition::QRResult qrD = Decomposition::qr(ad.transpose(), method);
+
+    Matrix<double> q = p * qrD.Q.transpose();
+    Matrix<double> r = p * qrD.R.transpose() * p;
+
+    return QRResult(q, r);
+}
+
+template <class T>
+Decomposition::QRResult Decomposition::qrSignModifier(const Matrix<T>& q, const Matrix<T>& r, size_t row)
+{
     // https://math.stackexchange.com/questions/2237262/is-there-a-correct-qr-factorization-result
 
-    Matrix<double> Q = q;
-    Matrix<double> R = r;
+    Matrix<double> Q = q;
+    Matrix<double> R = r;
+
+    for (size_t i = 0; i < Q.rows(); i++)
+        Q(i, row) = -Q(i, row);
+
+    for (size_t i = 0; i < R.cols(); i++)
+        R(row, i) = -R(row, i);
+
+    return QRResult(std::move(Q), std::move(R));
+}
+
+template <class T>
+Matrix<double> Decomposition::cholesky(const Matrix<T>& mat)
+{
+    Matrix<double> l = mat;
+    if (!choleskyPackedInPlace(l))
+        throw NotPositiveDefiniteException();
+
+    return l;
+}
+
+template <class T>
+bool Decomposition::isPositiveDefinite(const Matrix<T>& mat)
+{
+    if (mat.rows() != mat.cols())
+        return false;
+
+    Matrix<double> l = mat;
+    return choleskyPackedInPlace(l);
+}
+
+inline bool Decomposition::choleskyPackedInPlace(Matrix<double>& a, size_t nbrOfThreads)
+{
+    return symmetricFactorInPlace(a, false, nbrOfThreads);
+}
+
+inline bool Decomposition::ldltPackedInPlace(Matrix<double>& a, size_t nbrOfThreads)
+{
+    return symmetricFactorInPlace(a, true, nbrOfThreads);
+}
+
+// Right looking blocked factorization. Per block column [k, kb):
+// factorize the diagonal block, solve the panel below it and
+// update the lower triangle of the trailing matrix. The panel
+// is copied into contiguous buffers L and W = L * D, so the
+// trailing update consists of short, cache resident dot products.
+inline bool Decomposition::symmetricFactorInPlace(Matrix<double>& a, bool ldlt, size_t nbrOfThreads)
+{
+    if (a.rows() != a.cols())
+        throw SquareMatrixException();
+
+    const size_t blockSize = 64;
+    const size_t n         = a.rows();
+    double*      d         = a.data();
+
+    std::vector<double> panelL;
+    std::vector<double> panelW;
+    std::vector<double> pivots(blockSize);
+
+    for (size_t k = 0; k < n; k += blockSize)
+    {
+        const size_t kb = std::min(n, k + blockSize);
+        const size_t b  = kb - k;
+
+        // diagonal block, unblocked. W of the block rows is kept in the
+        // strict upper triangle of the block, which is cleared later.
+        for (size_t j = k; j < kb; j++)
+        {
+            double* rowJ = d + j * n;
+
+            double s = rowJ[j];
+            for (size_t p = k; p < j; p++)
+                s -= rowJ[p] * d[p * n + j];
+
+            if (ldlt)
+            {
+                if (s == 0.0 || !std::isfinite(s))
+                    return false;
+                rowJ[j] = s;
+            }
+            else
+            {
+                if (!(s > 0.0) || !std::isfinite(s))
+                    return false;
+                rowJ[j] = std::sqrt(s);
+            }
+            pivots[j - k] = rowJ[j];
+
+            // W(j, p) = L(j, p) * D(p), stored transposed at (p, j)
+            for (size_t i = j + 1; i < kb; i++)
+            {
+                double* rowI = d + i * n;
+                double  t    = rowI[j];
+                for (size_t p = k; p < j; p++)
+                    t -= rowI[p] * d[p * n + j];
+
+                rowI[j]      = t / pivots[j - k];
+                d[j * n + i] = ldlt ? rowI[j] * pivots[j - k] : rowI[j];
+            }
+        }
+
+        const size_t nPanel = n - kb;
+        if (nPanel == 0)
+            break;
+
+        panelL.resize(nPanel * b);
+        panelW.resize(nPanel * b);
+
+        // panel: rows are independent
+        auto solvePanel = [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++)
+            {
+                double* rowR = d + (kb + r) * n;
+                double* lR   = panelL.data() + r * b;
+                double* wR   = panelW.data() + r * b;
+                for (size_t j = k; j < kb; j++)
+                {
+                    double t = rowR[j];
+                    for (size_t p = k; p < j; p++)
+                        t -= lR[p - k] * d[p * n + j];
+
+                    lR[j - k] = t / pivots[j - k];
+                    wR[j - k] = ldlt ? lR[j - k] * pivots[j - k] : lR[j - k];
+                    rowR[j]   = lR[j - k];
+                }
+            }
+        };
+        Parallel::forRange(0, nPanel, solvePanel, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / (b * b)));
+
+        // trailing update of the lower triangle: A22 = A22 - L21 * W21'.
+        // Row i costs i dot products, so chunks are balanced by the
+        // number of updated entries rather than by rows.
+        auto updateTrailing = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                double*       rowI = d + (kb + i) * n + kb;
+                const double* lI   = panelL.data() + i * b;
+                for (size_t j = 0; j <= i; j++)
+                    rowI[j] -= Kernels::dot(lI, panelW.data() + j * b, b);
+            }
+        };
+
+        size_t nbrOfChunks = nbrOfThreads == 0 ? Parallel::defaultNbrOfThreads() : nbrOfThreads;
+        if (nPanel * nPanel * b / 2 < Kernels::ParallelGrainSize)
+            nbrOfChunks = 1;
+
+        std::vector<size_t> chunkBounds(1, 0);
+        for (size_t c = 1; c < nbrOfChunks; c++)
+        {
+            // row where the cumulated work reaches c / nbrOfChunks
+            size_t bound = static_cast<size_t>(nPanel * std::sqrt(static_cast<double>(c) / nbrOfChunks));
+            if (bound > chunkBounds.back())
+                chunkBounds.push_back(bound);
+        }
+        chunkBounds.push_back(nPanel);
+
+        Parallel::forRange(0, chunkBounds.size() - 1, [&](size_t c0, size_t c1) {
+            for (size_t c = c0; c < c1; c++)
+                updateTrailing(chunkBounds[c], chunkBounds[c + 1]);
+        }, nbrOfThreads);
+    }
+
+    // clear upper triangle, which holds intermediate results
+    for (size_t i = 0; i < n; i++)
+        std::fill(d + i * n + i + 1, d + (i + 1) * n, 0.0);
 
-    for (size_t i = 0; i < Q.rows(); i++)
-        Q(i, row) = -Q(i, row);
+    return true;
+}
+
+inline void Decomposition::choleskyPackedSolveInPlace(const Matrix<double>& l, Matrix<double>& b)
+{
+    triangularSolveInPlace(l, b, true, false);
+    triangularSolveInPlace(l, b, true, true);
+}
+
+inline double Decomposition::choleskyLogDeterminant(const Matrix<double>& l)
+{
+    double logDet = 0.0;
+    for (size_t i = 0; i < l.rows(); i++)
+        logDet += std::log(l(i, i));
+
+    return 2.0 * logDet;
+}
+
+inline void Decomposition::ldltPackedSolveInPlace(const Matrix<double>& ld, Matrix<double>& b)
+{
+    triangularSolveInPlace(ld, b, true, false, true);
+
+    size_t nRhs = b.cols();
+    for (size_t i = 0; i < ld.rows(); i++)
+        Kernels::scale(b.data() + i * nRhs, nRhs, 1.0 / ld(i, i));
+
+    triangularSolveInPlace(ld, b, true, true, true);
+}
+
+inline double Decomposition::ldltLogDeterminant(const Matrix<double>& ld, double& sign)
+{
+    double logDet = 0.0;
+    sign          = 1.0;
+    for (size_t i = 0; i < ld.rows(); i++)
+    {
+        double dI = ld(i, i);
+        if (dI < 0.0)
+            sign = -sign;
+        logDet += std::log(std::abs(dI));
+    }
+
+    return logDet;
+}
+
+inline void Decomposition::triangularSolveInPlace(const Matrix<double>& t, Matrix<double>& b, bool lower, bool transposed, bool unitDiagonal)
+{
+    size_t n    = t.rows();
+    size_t nRhs = b.cols();
+
+    if (t.cols() != n || b.rows() != n)
+        throw InvalidInputException();
+
+    const double* td = t.data();
+    double*       x  = b.data();
+
+    // T' of a lower triangle is an upper triangle and vice versa
+    bool forward = lower != transposed;
+
+    auto substitute = [=](size_t c0, size_t c1) {
+        size_t width = c1 - c0;
+        for (size_t step = 0; step < n; step++)
+        {
+            size_t  i  = forward ? step : n - 1 - step;
+            double* xi = x + i * nRhs + c0;
+
+            size_t jBegin = forward ? 0 : i + 1;
+            size_t jEnd   = forward ? i : n;
+            for (size_t j = jBegin; j < jEnd; j++)
+            {
+                double f = transposed ? td[j * n + i] : td[i * n + j];
+                if (f != 0.0)
+                    Kernels::axpy(xi, x + j * nRhs + c0, width, -f);
+            }
+
+            if (!unitDiagonal)
+                Kernels::scale(xi, width, 1.0 / td[i * n + i]);
+        }
+    };
+
+    size_t minChunk = std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, n * n / 2));
+    Parallel::forRange(0, nRhs, substitute, 0, minChunk);
+}
+
+template <class T>
+Decomposition::QRPackedResult Decomposition::qrPacked(const Matrix<T>& mat)
+{
+    Matrix<double>      qr = mat;
+    std::vector<double> tau;
+    qrPackedInPlace(qr, tau);
+
+    return QRPackedResult(qr, tau);
+}
+
+inline double Decomposition::householderInColumn(Matrix<double>& a, size_t row, size_t col)
+{
+    return householderStrided(a.data() + row * a.cols() + col, a.rows() - row, a.cols());
+}
+
+inline double Decomposition::householderInRow(Matrix<double>& a, size_t row, size_t col)
+{
+    return householderStrided(a.data() + row * a.cols() + col, a.cols() - col, 1);
+}
+
+inline double Decomposition::householderStrided(double* x, size_t n, size_t stride)
+{
+    double alpha = x[0];
+    double xnorm = 0.0;
+    for (size_t i = 1; i < n; i++)
+        xnorm = std::hypot(xnorm, x[i * stride]);
+
+    if (xnorm == 0.0)
+        return 0.0;
+
+    double beta = -std::copysign(std::hypot(alpha, xnorm), alpha);
+
+    // A vector near underflow is scaled up, otherwise v and tau do not match and H
+    // is not orthogonal (as LAPACK xLARFG). Happens in the reduction of rank deficient matrices.
+    const double safeMin = std::numeric_limits<double>::min() / std::numeric_limits<double>::epsilon();
+    size_t       nbrOfScalings = 0;
+    while (std::abs(beta) < safeMin && nbrOfScalings < 20)
+    {
+        for (size_t i = 0; i < n; i++)
+            x[i * stride] /= safeMin;
+        nbrOfScalings++;
+
+        alpha = x[0];
+        xnorm = 0.0;
+        for (size_t i = 1; i < n; i++)
+            xnorm = std::hypot(xnorm, x[i * stride]);
+        beta = -std::copysign(std::hypot(alpha, xnorm), alpha);
+    }
+
+    double sc = 1.0 / (alpha - beta);
+    for (size_t i = 1; i < n; i++)
+        x[i * stride] *= sc;
+
+    double tau = (beta - alpha) / beta;
+    for (size_t k = 0; k < nbrOfScalings; k++)
+        beta *= safeMin;
+    x[0] = beta;
+
+    return tau;
+}
+
+inline void Decomposition::applyColumnHouseholderLeft(const Matrix<double>& v, size_t row, size_t col, double tau,
+                                                      Matrix<double>& b, size_t colBegin, size_t colEnd, std::vector<double>& w)
+{
+    if (tau == 0.0 || colEnd <= colBegin)
+        return;
+
+    // b = b - tau * v * (v' * b), accumulated row by row
+    size_t m      = b.rows();
+    size_t n      = b.cols();
+    size_t length = colEnd - colBegin;
+    w.assign(length, 0.0);
+
+    for (size_t i = row; i < m; i++)
+    {
+        double vi = (i == row) ? 1.0 : v(i, col);
+        if (vi != 0.0)
+            Kernels::axpy(w.data(), b.data() + i * n + colBegin, length, vi);
+    }
+
+    for (size_t i = row; i < m; i++)
+    {
+        double vi = (i == row) ? 1.0 : v(i, col);
+        if (vi != 0.0)
+            Kernels::axpy(b.data() + i * n + colBegin, w.data(), length, -tau * vi);
+    }
+}
+
+// Blocked Householder QR (LAPACK xGEQRF). Each panel of householderBlockSize()
+// columns is factorized column by column, then its reflectors are combined
+// to I - V * T * V' and applied to the trailing columns at once.
+inline void Decomposition::qrPackedInPlace(Matrix<double>& a, std::vector<double>& tau, size_t nbrOfThreads)
+{
+    size_t n = a.cols();
+    size_t k = std::min(a.rows(), n);
+    tau.assign(k, 0.0);
+
+    std::vector<double> w;
+    std::vector<double> t;
+    for (size_t c0 = 0; c0 < k; c0 += householderBlockSize())
+    {
+        size_t nb = std::min(householderBlockSize(), k - c0);
+
+        // panel
+        for (size_t c = c0; c < c0 + nb; c++)
+        {
+            tau[c] = householderInColumn(a, c, c);
+            applyColumnHouseholderLeft(a, c, c, tau[c], a, c + 1, c0 + nb, w);
+        }
+
+        // trailing columns
+        if (c0 + nb < n)
+        {
+            householderBlockFactor(a, c0, nb, tau.data() + c0, t);
+            applyBlockHouseholderLeft(a, c0, nb, t, true, a, c0 + nb, n, nbrOfThreads);
+        }
+    }
+}
+
+inline void Decomposition::qrPackedApplyQTransposedInPlace(const Matrix<double>& qr, const std::vector<double>& tau, Matrix<double>& b, size_t nbrOfThreads)
+{
+    if (b.rows() != qr.rows() || tau.size() != std::min(qr.rows(), qr.cols()))
+        throw InvalidInputException();
+
+    // Q' = ... * Q_1' * Q_0', with the blocks Q_i = I - V * T * V'
+    std::vector<double> t;
+    for (size_t c0 = 0; c0 < tau.size(); c0 += householderBlockSize())
+    {
+        size_t nb = std::min(householderBlockSize(), tau.size() - c0);
+        householderBlockFactor(qr, c0, nb, tau.data() + c0, t);
+        applyBlockHouseholderLeft(qr, c0, nb, t, true, b, 0, b.cols(), nbrOfThreads);
+    }
+}
+
+inline void Decomposition::qrPackedApplyQInPlace(const Matrix<double>& qr, const std::vector<double>& tau, Matrix<double>& b, size_t nbrOfThreads)
+{
+    if (b.rows() != qr.rows() || tau.size() != std::min(qr.rows(), qr.cols()))
+        throw InvalidInputException();
+
+    // Q = Q_0 * Q_1 * ..., applied backwards
+    std::vector<double> t;
+    size_t              nbrOfBlocks = (tau.size() + householderBlockSize() - 1) / householderBlockSize();
+    for (size_t bb = nbrOfBlocks; bb > 0; bb--)
+    {
+        size_t c0 = (bb - 1) * householderBlockSize();
+        size_t nb = std::min(householderBlockSize(), tau.size() - c0);
+        householderBlockFactor(qr, c0, nb, tau.data() + c0, t);
+        applyBlockHouseholderLeft(qr, c0, nb, t, false, b, 0, b.cols(), nbrOfThreads);
+    }
+}
+
+inline void Decomposition::householderBlockFactor(const Matrix<double>& v, size_t c0, size_t nb, const double* tau, std::vector<double>& t)
+{
+    size_t m = v.rows();
+    t.assign(nb * nb, 0.0);
+
+    std::vector<double> z(nb);
+    for (size_t i = 0; i < nb; i++)
+    {
+        t[i * nb + i] = tau[i];
+        if (tau[i] == 0.0)
+            continue;
+
+        // z = -tau_i * V(:, 0:i)' * v_i, where v_i starts at row c0 + i
+        std::fill(z.begin(), z.begin() + i, 0.0);
+        for (size_t r = c0 + i; r < m; r++)
+        {
+            double vri = (r == c0 + i) ? 1.0 : v(r, c0 + i);
+            if (vri != 0.0)
+                Kernels::axpy(z.data(), v.data() + r * v.cols() + c0, i, vri);
+        }
+
+        // T(0:i, i) = T(0:i, 0:i) * z
+        for (size_t p = 0; p < i; p++)
+        {
+            double sum = 0.0;
+            for (size_t q = p; q < i; q++)
+                sum += t[p * nb + q] * z[q];
+            t[p * nb + i] = -tau[i] * sum;
+        }
+    }
+}
+
+inline void Decomposition::applyBlockHouseholderLeft(const Matrix<double>& v, size_t c0, size_t nb, const std::vector<double>& t, bool transposed,
+                                                     Matrix<double>& b, size_t colBegin, size_t colEnd, size_t nbrOfThreads)
+{
+    size_t m     = b.rows();
+    size_t n     = b.cols();
+    size_t vCols = v.cols();
+
+    if (colEnd <= colBegin || c0 >= m)
+        return;
+
+    const double* vd = v.data();
+    double*       bd = b.data();
+
+    auto update = [=, &t](size_t x0, size_t x1) {
+        size_t              width = x1 - x0;
+        std::vector<double> w(nb * width, 0.0);
+
+        // W = V' * B. Row r of V has the explicit entries V(r, 0:r-c0),
+        // then the implied 1 and zeros.
+        for (size_t r = c0; r < m; r++)
+        {
+            const double* bRow = bd + r * n + x0;
+            const double* vRow = vd + r * vCols + c0;
+            size_t        pEnd = std::min(nb, r - c0 + 1);
+            for (size_t p = 0; p < pEnd; p++)
+            {
+                double vrp = (p == r - c0) ? 1.0 : vRow[p];
+                if (vrp != 0.0)
+                    Kernels::axpy(w.data() + p * width, bRow, width, vrp);
+            }
+        }
+
+        // W = T * W or T' * W, T upper triangle
+        std::vector<double> tw(nb * width, 0.0);
+        for (size_t p = 0; p < nb; p++)
+        {
+            for (size_t q = 0; q < nb; q++)
+            {
+                double tpq = transposed ? t[q * nb + p] : t[p * nb + q];
+                if (tpq != 0.0)
+                    Kernels::axpy(tw.data() + p * width, w.data() + q * width, width, tpq);
+            }
+        }
+
+        // B = B - V * W
+        for (size_t r = c0; r < m; r++)
+        {
+            double*       bRow = bd + r * n + x0;
+            const double* vRow = vd + r * vCols + c0;
+            size_t        pEnd = std::min(nb, r - c0 + 1);
+            for (size_t p = 0; p < pEnd; p++)
+            {
+                double vrp = (p == r - c0) ? 1.0 : vRow[p];
+                if (vrp != 0.0)
+                    Kernels::axpy(bRow, tw.data() + p * width, width, -vrp);
+            }
+        }
+    };
+
+    size_t workPerColumn = std::max<size_t>(1, (m - c0) * nb);
+    size_t minChunk      = std::max<size_t>(1, Kernels::ParallelGrainSize / workPerColumn);
+    Parallel::forRange(colBegin, colEnd, update, nbrOfThreads, minChunk);
+}
+
+inline void Decomposition::applyHouseholderLeft(Matrix<double>& a, const Matrix<double>& v, double b, size_t row, size_t col)
+{
+    size_t k = v.rows();
+    size_t n = a.cols();
+
+    if (v.cols() != 1 || row + k > a.rows() || col > n)
+        throw InvalidInputException();
+
+    if (!std::isfinite(b) || b == 0.0)
+        return;
+
+    // A = A - b * v * (v' * A)
+    size_t              length = n - col;
+    std::vector<double> w(length, 0.0);
+    for (size_t i = 0; i < k; i++)
+        Kernels::axpy(w.data(), a.data() + (row + i) * n + col, length, v(i, 0));
+
+    for (size_t i = 0; i < k; i++)
+        Kernels::axpy(a.data() + (row + i) * n + col, w.data(), length, -b * v(i, 0));
+}
+
+inline void Decomposition::applyHouseholderRight(Matrix<double>& a, const Matrix<double>& v, double b, size_t row, size_t col)
+{
+    size_t k = v.rows();
+    size_t n = a.cols();
+
+    if (v.cols() != 1 || col + k > n || row > a.rows())
+        throw InvalidInputException();
+
+    if (!std::isfinite(b) || b == 0.0)
+        return;
+
+    // A = A - (A * v) * b * v'
+    for (size_t i = row; i < a.rows(); i++)
+    {
+        double* aRow = a.data() + i * n + col;
+        double  s    = Kernels::dot(aRow, v.data(), k);
+        Kernels::axpy(aRow, v.data(), k, -b * s);
+    }
+}
+
+inline Matrix<double> Decomposition::qrPackedQ(const Matrix<double>& qr, const std::vector<double>& tau, bool economy, size_t nbrOfThreads)
+{
+    size_t m = qr.rows();
+    size_t k = economy ? std::min(m, qr.cols()) : m;
+
+    // first k columns of the identity
+    Matrix<double> q(m, k);
+    q.fill(0.0);
+    for (size_t i = 0; i < k; i++)
+        q(i, i) = 1.0;
+
+    // Q = Q_0 * Q_1 * ... * I, applied backwards. The product of the blocks from
+    // c0 on differs from the identity only in the rows and columns c0:m (xORGQR).
+    std::vector<double> t;
+    size_t              nbrOfBlocks = (tau.size() + householderBlockSize() - 1) / householderBlockSize();
+    for (size_t bb = nbrOfBlocks; bb > 0; bb--)
+    {
+        size_t c0 = (bb - 1) * householderBlockSize();
+        size_t nb = std::min(householderBlockSize(), tau.size() - c0);
+        householderBlockFactor(qr, c0, nb, tau.data() + c0, t);
+        applyBlockHouseholderLeft(qr, c0, nb, t, false, q, std::min(c0, k), k, nbrOfThreads);
+    }
+
+    return q;
+}
+
+inline Matrix<double> Decomposition::qrPackedR(const Matrix<double>& qr, bool economy)
+{
+    size_t m = qr.rows();
+    size_t n = qr.cols();
+    size_t k = economy ? std::min(m, n) : m;
+
+    Matrix<double> r(k, n);
+    r.fill(0.0);
+    for (size_t i = 0; i < std::min(k, n); i++)
+        std::copy(qr.data() + i * n + i, qr.data() + (i + 1) * n, r.data() + i * n + i);
+
+    return r;
+}
+
+inline Matrix<double> Decomposition::stackedQR(const Matrix<double>& top, const Matrix<double>& bottom, Matrix<double>& packed, std::vector<double>& tau,
+                                               size_t nbrOfThreads)
+{
+    packed = Matrix<double>(top.rows() + bottom.rows(), top.cols());
+    std::copy(top.data(), top.data() + top.getNbrOfElements(), packed.data());
+    std::copy(bottom.data(), bottom.data() + bottom.getNbrOfElements(), packed.data() + top.getNbrOfElements());
+
+    qrPackedInPlace(packed, tau, nbrOfThreads);
+    return qrPackedR(packed, true);
+}
+
+// TSQR, Demmel et al., Communication-optimal parallel and sequential QR and LU factorizations, 2012.
+template <class T>
+Decomposition::QRResult Decomposition::tsqr(const Matrix<T>& mat, bool computeQ, size_t rowBlockSize, size_t nbrOfThreads)
+{
+    size_t m = mat.rows();
+    size_t n = mat.cols();
+
+    if (nbrOfThreads == 0)
+        nbrOfThreads = Parallel::defaultNbrOfThreads();
+
+    if (rowBlockSize == 0)
+        rowBlockSize = (m + nbrOfThreads - 1) / nbrOfThreads;
+
+    // every block needs at least 2n rows to reduce work
+    rowBlockSize       = std::max(rowBlockSize, 2 * n);
+    size_t nbrOfBlocks = std::max<size_t>(1, m / std::max<size_t>(1, rowBlockSize));
+
+    // One node per block and per combination. A node holds its packed
+    // decomposition and R. Level 0 are the row blocks.
+    struct Node
+    {
+        Matrix<double>      Packed;
+        std::vector<double> Tau;
+        Matrix<double>      R;
+    };
+
+    std::vector<std::vector<Node>> levels(1, std::vector<Node>(nbrOfBlocks));
+    std::vector<size_t>            blockBegin(nbrOfBlocks + 1);
+    for (size_t b = 0; b <= nbrOfBlocks; b++)
+        blockBegin[b] = b * m / nbrOfBlocks;
+
+    // The nodes of a level are processed on up to nbrOfThreads threads. Each of
+    // them passes its share of the budget on to the QR kernels, so the nested
+    // calls never start more than nbrOfThreads threads in total.
+    auto kernelThreads = [nbrOfThreads](size_t nbrOfNodes) {
+        return std::max<size_t>(1, nbrOfThreads / std::max<size_t>(1, std::min(nbrOfThreads, nbrOfNodes)));
+    };
+
+    size_t blockThreads = kernelThreads(nbrOfBlocks);
+    Parallel::forRange(0, nbrOfBlocks, [&](size_t b0, size_t b1) {
+        for (size_t b = b0; b < b1; b++)
+        {
+            Node& node  = levels[0][b];
+            node.Packed = mat.subMatrix(blockBegin[b], 0, blockBegin[b + 1] - blockBegin[b], n);
+            qrPackedInPlace(node.Packed, node.Tau, blockThreads);
+            node.R = qrPackedR(node.Packed, true);
+            if (!computeQ)
+                node.Packed = Matrix<double>(0, 0);
+        }
+    }, nbrOfThreads);
+
+    // reduction tree: node i of a level combines the nodes 2i and 2i+1 below.
+    // An unpaired last node is passed through without factorization.
+    while (levels.back().size() > 1)
+    {
+        const std::vector<Node>& below = levels.back();
+        std::vector<Node>        level((below.size() + 1) / 2);
+        size_t                   nodeThreads = kernelThreads(level.size());
+
+        Parallel::forRange(0, level.size(), [&](size_t i0, size_t i1) {
+            for (size_t i = i0; i < i1; i++)
+            {
+                if (2 * i + 1 < below.size())
+                    level[i].R = stackedQR(below[2 * i].R, below[2 * i + 1].R, level[i].Packed, level[i].Tau, nodeThreads);
+                else
+                    level[i].R = below[2 * i].R;
+            }
+        }, nbrOfThreads);
+
+        levels.push_back(std::move(level));
+    }
+
+    Matrix<double> r = levels.back()[0].R;
+    if (!computeQ)
+        return QRResult(Matrix<double>(0, 0), r);
+
+    // Q from top to bottom: each node gets a k x k' coefficient block C and
+    // passes Q_node * [C; 0] split by rows on to its children.
+    size_t                      k = r.rows();
+    std::vector<Matrix<double>> coeff(1, Matrix<double>::identity(k));
+    for (size_t l = levels.size() - 1; l > 0; l--)
+    {
+        const std::vector<Node>&    level = levels[l];
+        const std::vector<Node>&    below = levels[l - 1];
+        std::vector<Matrix<double>> coeffBelow(below.size());
+        size_t                      nodeThreads = kernelThreads(level.size());
+
+        Parallel::forRange(0, level.size(), [&](size_t i0, size_t i1) {
+            for (size_t i = i0; i < i1; i++)
+            {
+                if (2 * i + 1 >= below.size())
+                {
+                    coeffBelow[2 * i] = coeff[i];
+                    continue;
+                }
+
+                const Node&    node = level[i];
+                Matrix<double> y(node.Packed.rows(), k);
+                y.fill(0.0);
+                y.setSubMatrix(0, 0, coeff[i]);
+                qrPackedApplyQInPlace(node.Packed, node.Tau, y, nodeThreads);
+
+                size_t rowsA          = below[2 * i].R.rows();
+                coeffBelow[2 * i]     = y.subMatrix(0, 0, rowsA, k);
+                coeffBelow[2 * i + 1] = y.subMatrix(rowsA, 0, y.rows() - rowsA, k);
+            }
+        }, nbrOfThreads);
+
+        coeff = std::move(coeffBelow);
+    }
+
+    Matrix<double> q(m, k);
+    Parallel::forRange(0, nbrOfBlocks, [&](size_t b0, size_t b1) {
+        for (size_t b = b0; b < b1; b++)
+        {
+            const Node&    node = levels[0][b];
+            Matrix<double> y(node.Packed.rows(), k);
+            y.fill(0.0);
+            y.setSubMatrix(0, 0, coeff[b]);
+            qrPackedApplyQInPlace(node.Packed, node.Tau, y, blockThreads);
+            q.setSubMatrix(blockBegin[b], 0, y);
+        }
+    }, nbrOfThreads);
+
+    return QRResult(std::move(q), std::move(r));
+}
+
+template <class T>
+void Decomposition::StreamingQR::addRows(const Matrix<T>& rows)
+{
+    if (rows.cols() != m_cols)
+        throw InvalidInputException();
+
+    if (rows.rows() == 0)
+        return;
+
+    // reduce a large chunk to its R first
+    Matrix<double> chunkR = rows.rows() > 4 * m_cols ? tsqr(rows).R : Matrix<double>(rows);
+
+    Matrix<double>      packed;
+    std::vector<double> tau;
+    m_r = stackedQR(m_r, chunkR, packed, tau, 0);
+    m_rows += rows.rows();
+}
+
+// QR with column pivoting, Matrix Computations, 4th ed, Golub & Van Loan, p.278
+// The column norm downdating follows LAPACK's xLAQP2.
+template <class T>
+Decomposition::QRCPResult Decomposition::qrColumnPivoting(const Matrix<T>& mat, double tolerance, bool computeQ)
+{
+    Matrix<double> a = mat;
+    size_t         m = a.rows();
+    size_t         n = a.cols();
+    size_t         k = std::min(m, n);
+
+    std::vector<size_t> perm(n);
+    for (size_t j = 0; j < n; j++)
+        perm[j] = j;
+
+    // partial column norms and the norms at the time of their last recomputation
+    std::vector<double> vn1(n, 0.0);
+    std::vector<double> vn2(n, 0.0);
+    for (size_t i = 0; i < m; i++)
+    {
+        const double* aRow = a.data() + i * n;
+        for (size_t j = 0; j < n; j++)
+            vn1[j] += aRow[j] * aRow[j];
+    }
+    for (size_t j = 0; j < n; j++)
+    {
+        vn1[j] = std::sqrt(vn1[j]);
+        vn2[j] = vn1[j];
+    }
+
+    std::vector<double> tau(k, 0.0);
+    std::vector<double> w;
+    double              tol3z = std::sqrt(std::numeric_limits<double>::epsilon());
+
+    for (size_t c = 0; c < k; c++)
+    {
+        // pivot: remaining column with largest norm
+        size_t pvt = c;
+        for (size_t j = c + 1; j < n; j++)
+        {
+            if (vn1[j] > vn1[pvt])
+                pvt = j;
+        }
+
+        if (pvt != c)
+        {
+            a.swapCols(c, pvt);
+            std::swap(perm[c], perm[pvt]);
+            std::swap(vn1[c], vn1[pvt]);
+            std::swap(vn2[c], vn2[pvt]);
+        }
+
+        // Householder vector of column c. v(c) = 1 is implicit, the
+        // remaining part is stored below the diagonal.
+        tau[c] = householderInColumn(a, c, c);
+        applyColumnHouseholderLeft(a, c, c, tau[c], a, c + 1, n, w);
+
+        // downdate the column norms
+        for (size_t j = c + 1; j < n; j++)
+        {
+            if (vn1[j] != 0.0)
+            {
+                double temp  = std::max(0.0, 1.0 - std::pow(std::abs(a(c, j)) / vn1[j], 2.0));
+                double temp2 = temp * std::pow(vn1[j] / vn2[j], 2.0);
+                if (temp2 <= tol3z)
+                {
+                    // cancellation: recompute the norm
+                    double nrm = 0.0;
+                    for (size_t i = c + 1; i < m; i++)
+                        nrm = std::hypot(nrm, a(i, j));
+                    vn1[j] = nrm;
+                    vn2[j] = nrm;
+                }
+                else
+                {
+                    vn1[j] *= std::sqrt(temp);
+                }
+            }
+        }
+    }
+
+    // numerical rank
+    if (tolerance < 0.0)
+        tolerance = k > 0 ? std::max(m, n) * std::numeric_limits<double>::epsilon() * std::abs(a(0, 0)) : 0.0;
+
+    size_t rank = 0;
+    while (rank < k && std::abs(a(rank, rank)) > tolerance)
+        rank++;
+
+    // accumulate Q = H_0 * H_1 * ... backwards, so that
+    // reflector j only touches the trailing rows and columns
+    Matrix<double> q;
+    if (computeQ)
+    {
+        q = Matrix<double>::identity(m);
+        for (size_t cc = k; cc > 0; cc--)
+            applyColumnHouseholderLeft(a, cc - 1, cc - 1, tau[cc - 1], q, cc - 1, m, w);
+    }
+
+    // clear the stored reflectors to get R
+    for (size_t j = 0; j < k; j++)
+        for (size_t i = j + 1; i < m; i++)
+            a(i, j) = 0.0;
+
+    return QRCPResult(q, a, perm, rank);
+}
 
-    for (size_t i = 0; i < R.cols(); i++)
-        R(row, i) = -R(row, i);
+template <class T>
+Matrix<double> Decomposition::rangeSpace(const Matrix<T>& mat, double tolerance)
+{
+    QRCPResult qrcp = qrColumnPivoting(mat, tolerance, true);
+    return qrcp.Q.subMatrix(0, 0, qrcp.Q.rows(), qrcp.Rank);
+}
 
-    return QRResult(std::move(Q), std::move(R));
+template <class T>
+Matrix<double> Decomposition::nullSpace(const Matrix<T>& mat, double tolerance)
+{
+    // The null space of A is the orthogonal complement of the range of A'.
+    QRCPResult qrcp = qrColumnPivoting(mat.transpose(), tolerance, true);
+
+    size_t n = qrcp.Q.rows();
+    return qrcp.Q.subMatrix(0, qrcp.Rank, n, n - qrcp.Rank);
 }
 
 #include "solve.hpp"
 
 template <class T>
-Decomposition::SVDResult Decomposition::svd(const Matrix<T>& mat)
+Decomposition::SVDResult Decomposition::svd(const Matrix<T>& mat, SVDMode mode)
+{
+    return Decomposition::svdGolubKahan(mat, mode);
+}
+
+template <class T>
+std::vector<double> Decomposition::singularValues(const Matrix<T>& mat)
 {
-    return Decomposition::svdGolubKahan(mat);
+    SVDResult           res = svdGolubKahan(mat, SingularValuesOnly);
+    std::vector<double> values(res.S.rows());
+    for (size_t k = 0; k < values.size(); k++)
+        values[k] = res.S(k, k);
+
+    return values;
 }
 
 template <class T>
@@ -1610,45 +4862,841 @@ Matrix<double> Decomposition::givensRotationRowDirection(const Matrix<T> &mat, s
     return givensRotationRowDirection(a, b, mat.cols(), mat.rows(), a_col, b_col);;
 }
 
+inline void Decomposition::singularValues2x2(double f, double g, double h, double& ssmin, double& ssmax)
+{
+    double fa   = std::abs(f);
+    double ga   = std::abs(g);
+    double ha   = std::abs(h);
+    double fhmn = std::min(fa, ha);
+    double fhmx = std::max(fa, ha);
+
+    if (fhmn == 0.0)
+    {
+        ssmin = 0.0;
+        if (fhmx == 0.0)
+            ssmax = ga;
+        else
+            ssmax = std::max(fhmx, ga) * std::sqrt(1.0 + std::pow(std::min(fhmx, ga) / std::max(fhmx, ga), 2.0));
+    }
+    else if (ga < fhmx)
+    {
+        double as = 1.0 + fhmn / fhmx;
+        double at = (fhmx - fhmn) / fhmx;
+        double au = (ga / fhmx) * (ga / fhmx);
+        double c  = 2.0 / (std::sqrt(as * as + au) + std::sqrt(at * at + au));
+        ssmin     = fhmn * c;
+        ssmax     = fhmx / c;
+    }
+    else
+    {
+        double au = fhmx / ga;
+        if (au == 0.0)
+        {
+            ssmin = (fhmn * fhmx) / ga;
+            ssmax = ga;
+        }
+        else
+        {
+            double as = 1.0 + fhmn / fhmx;
+            double at = (fhmx - fhmn) / fhmx;
+            double c  = 1.0 / (std::sqrt(1.0 + (as * au) * (as * au)) + std::sqrt(1.0 + (at * au) * (at * au)));
+            ssmin     = 2.0 * (fhmn * c) * au;
+            ssmax     = ga / (c + c);
+        }
+    }
+}
+
+inline bool Decomposition::bidiagonalQRInPlace(std::vector<double>& d, std::vector<double>& e, Matrix<double>* ut, Matrix<double>* vt)
+{
+    size_t n = d.size();
+    if (n == 0)
+        return true;
+
+    const double eps    = std::numeric_limits<double>::epsilon();
+    const double unfl   = std::numeric_limits<double>::min();
+    const double tol    = std::max(10.0, std::min(100.0, std::pow(eps, -0.125))) * eps;
+    const size_t maxItr = 6;
+
+    // rows i and i+1: x' = c * x + s * y, y' = -s * x + c * y
+    auto rotate = [](Matrix<double>* mat, size_t i, double c, double s) {
+        if (mat != nullptr && mat->cols() > 0)
+            Kernels::rot(mat->data() + i * mat->cols(), mat->data() + (i + 1) * mat->cols(), mat->cols(), c, -s);
+    };
+
+    // Threshold for negligible superdiagonal entries, relative to an estimate of the smallest singular value
+    double sminoa = std::abs(d[0]);
+    double mu     = sminoa;
+    for (size_t i = 1; i < n && sminoa != 0.0; i++)
+    {
+        mu     = std::abs(d[i]) * (mu / (mu + std::abs(e[i - 1])));
+        sminoa = std::min(sminoa, mu);
+    }
+    sminoa /= std::sqrt(static_cast<double>(n));
+    double thresh = std::max(tol * sminoa, maxItr * (n * (n * unfl)));
+
+    size_t maxIteration = maxItr * n * n;
+    size_t iteration    = 0;
+    size_t oldll        = n;
+    size_t oldm         = n;
+    bool   forward      = true; // chase the bulge from top to bottom
+    size_t m            = n - 1;
+
+    while (m > 0)
+    {
+        if (iteration > maxIteration)
+            return false;
+
+        // find the unreduced block ll:m
+        double smax = std::abs(d[m]);
+        size_t ll   = 0;
+        bool   split = false;
+        for (size_t k = m; k > 0; k--)
+        {
+            double abse = std::abs(e[k - 1]);
+            if (abse <= thresh)
+            {
+                e[k - 1] = 0.0;
+                ll       = k;
+                split    = true;
+                break;
+            }
+            smax = std::max(smax, std::max(std::abs(d[k - 1]), abse));
+        }
+
+        if (split && ll == m)
+        {
+            // d[m] is a singular value
+            m--;
+            continue;
+        }
+
+        // the direction follows the grading of a new block
+        if (ll >= oldm + 1 || m < oldll || oldm == n)
+            forward = std::abs(d[ll]) >= std::abs(d[m]);
+
+        // convergence tests, mu runs over the estimate of the smallest singular value
+        double sminl     = 0.0;
+        bool   converged = false;
+        if (forward)
+        {
+            if (std::abs(e[m - 1]) <= tol * std::abs(d[m]))
+            {
+                e[m - 1] = 0.0;
+                continue;
+            }
+
+            mu    = std::abs(d[ll]);
+            sminl = mu;
+            for (size_t k = ll; k < m && !converged; k++)
+            {
+                if (std::abs(e[k]) <= tol * mu)
+                {
+                    e[k]      = 0.0;
+                    converged = true;
+                }
+                mu    = std::abs(d[k + 1]) * (mu / (mu + std::abs(e[k])));
+                sminl = std::min(sminl, mu);
+            }
+        }
+        else
+        {
+            if (std::abs(e[ll]) <= tol * std::abs(d[ll]))
+            {
+                e[ll] = 0.0;
+                continue;
+            }
+
+            mu    = std::abs(d[m]);
+            sminl = mu;
+            for (size_t k = m; k > ll && !converged; k--)
+            {
+                if (std::abs(e[k - 1]) <= tol * mu)
+                {
+                    e[k - 1]  = 0.0;
+                    converged = true;
+                }
+                mu    = std::abs(d[k - 1]) * (mu / (mu + std::abs(e[k - 1])));
+                sminl = std::min(sminl, mu);
+            }
+        }
+
+        if (converged)
+            continue;
+
+        oldll = ll;
+        oldm  = m;
+
+        // closed form shift: the smaller singular value of the trailing (leading) 2x2 block.
+        // If it is negligible compared to the smallest singular value, a zero shift keeps
+        // the high relative accuracy.
+        double shift = 0.0;
+        if (n * tol * (sminl / smax) > std::max(eps, 0.01 * tol))
+        {
+            double r;
+            double sll;
+            if (forward)
+            {
+                sll = std::abs(d[ll]);
+                singularValues2x2(d[m - 1], e[m - 1], d[m], shift, r);
+            }
+            else
+            {
+                sll = std::abs(d[m]);
+                singularValues2x2(d[ll], e[ll], d[ll + 1], shift, r);
+            }
+
+            if (sll > 0.0 && (shift / sll) * (shift / sll) < eps)
+                shift = 0.0;
+        }
+
+        iteration += m - ll;
+
+        double cs, sn, r, oldcs, oldsn, f, g, cosr, sinr, cosl, sinl;
+        if (shift == 0.0)
+        {
+            // Demmel-Kahan zero shift QR sweep
+            cs    = 1.0;
+            oldcs = 1.0;
+            oldsn = 0.0;
+            if (forward)
+            {
+                for (size_t i = ll; i < m; i++)
+                {
+                    planeRotation(d[i] * cs, e[i], cs, sn, r);
+                    if (i > ll)
+                        e[i - 1] = oldsn * r;
+                    planeRotation(oldcs * r, d[i + 1] * sn, oldcs, oldsn, d[i]);
+                    rotate(vt, i, cs, sn);
+                    rotate(ut, i, oldcs, oldsn);
+                }
+                double h = d[m] * cs;
+                d[m]     = h * oldcs;
+                e[m - 1] = h * oldsn;
+                if (std::abs(e[m - 1]) <= thresh)
+                    e[m - 1] = 0.0;
+            }
+            else
+            {
+                for (size_t i = m; i > ll; i--)
+                {
+                    planeRotation(d[i] * cs, e[i - 1], cs, sn, r);
+                    if (i < m)
+                        e[i] = oldsn * r;
+                    planeRotation(oldcs * r, d[i - 1] * sn, oldcs, oldsn, d[i]);
+                    rotate(vt, i - 1, oldcs, -oldsn);
+                    rotate(ut, i - 1, cs, -sn);
+                }
+                double h = d[ll] * cs;
+                d[ll]    = h * oldcs;
+                e[ll]    = h * oldsn;
+                if (std::abs(e[ll]) <= thresh)
+                    e[ll] = 0.0;
+            }
+        }
+        else if (forward)
+        {
+            // shifted QR sweep, chasing the bulge down
+            f = (std::abs(d[ll]) - shift) * (std::copysign(1.0, d[ll]) + shift / d[ll]);
+            g = e[ll];
+            for (size_t i = ll; i < m; i++)
+            {
+                planeRotation(f, g, cosr, sinr, r);
+                if (i > ll)
+                    e[i - 1] = r;
+                f        = cosr * d[i] + sinr * e[i];
+                e[i]     = cosr * e[i] - sinr * d[i];
+                g        = sinr * d[i + 1];
+                d[i + 1] = cosr * d[i + 1];
+                planeRotation(f, g, cosl, sinl, r);
+                d[i]     = r;
+                f        = cosl * e[i] + sinl * d[i + 1];
+                d[i + 1] = cosl * d[i + 1] - sinl * e[i];
+                if (i + 1 < m)
+                {
+                    g        = sinl * e[i + 1];
+                    e[i + 1] = cosl * e[i + 1];
+                }
+                rotate(vt, i, cosr, sinr);
+                rotate(ut, i, cosl, sinl);
+            }
+            e[m - 1] = f;
+            if (std::abs(e[m - 1]) <= thresh)
+                e[m - 1] = 0.0;
+        }
+        else
+        {
+            // shifted QR sweep, chasing the bulge up
+            f = (std::abs(d[m]) - shift) * (std::copysign(1.0, d[m]) + shift / d[m]);
+            g = e[m - 1];
+            for (size_t i = m; i > ll; i--)
+            {
+                planeRotation(f, g, cosr, sinr, r);
+                if (i < m)
+                    e[i] = r;
+                f        = cosr * d[i] + sinr * e[i - 1];
+                e[i - 1] = cosr * e[i - 1] - sinr * d[i];
+                g        = sinr * d[i - 1];
+                d[i - 1] = cosr * d[i - 1];
+                planeRotation(f, g, cosl, sinl, r);
+                d[i]     = r;
+                f        = cosl * e[i - 1] + sinl * d[i - 1];
+                d[i - 1] = cosl * d[i - 1] - sinl * e[i - 1];
+                if (i > ll + 1)
+                {
+                    g        = sinl * e[i - 2];
+                    e[i - 2] = cosl * e[i - 2];
+                }
+                rotate(vt, i - 1, cosl, -sinl);
+                rotate(ut, i - 1, cosr, -sinr);
+            }
+            e[ll] = f;
+            if (std::abs(e[ll]) <= thresh)
+                e[ll] = 0.0;
+        }
+    }
+
+    // positive singular values in descending order
+    for (size_t i = 0; i < n; i++)
+    {
+        if (d[i] < 0.0)
+        {
+            d[i] = -d[i];
+            if (vt != nullptr && vt->cols() > 0)
+                Kernels::scale(vt->data() + i * vt->cols(), vt->cols(), -1.0);
+        }
+    }
+
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        size_t maxIdx = std::max_element(d.begin() + i, d.end()) - d.begin();
+        if (maxIdx != i)
+        {
+            std::swap(d[i], d[maxIdx]);
+            if (ut != nullptr && ut->cols() > 0)
+                Kernels::swap(ut->data() + i * ut->cols(), ut->data() + maxIdx * ut->cols(), ut->cols());
+            if (vt != nullptr && vt->cols() > 0)
+                Kernels::swap(vt->data() + i * vt->cols(), vt->data() + maxIdx * vt->cols(), vt->cols());
+        }
+    }
+
+    return true;
+}
+
 // Described in Matrix Computations, 4th edition, Golub & van Loan, p.
+// Bidiagonalization followed by the implicit bidiagonal QR of LAPACK xBDSQR.
 template <class T>
-Decomposition::SVDResult Decomposition::svdGolubKahan(const Matrix<T>& mat)
+Decomposition::SVDResult Decomposition::svdGolubKahan(const Matrix<T>& mat, SVDMode mode, size_t nbrOfThreads)
 {
     // U*S*V
+    size_t m = mat.rows();
+    size_t n = mat.cols();
+
+    if (m < n)
+    {
+        // A' = U * S * V'
+        SVDMode transposedMode = mode;
+        if (mode == LeftSingularVectorsOnly)
+            transposedMode = RightSingularVectorsOnly;
+        else if (mode == RightSingularVectorsOnly)
+            transposedMode = LeftSingularVectorsOnly;
+
+        SVDResult transposed = svdGolubKahan(mat.transpose(), transposedMode, nbrOfThreads);
+        return SVDResult(transposed.V, transposed.S.transpose(), transposed.U);
+    }
+
+    bool full  = (mode == FullSVD);
+    bool needU = (mode == FullSVD || mode == ThinSVD || mode == LeftSingularVectorsOnly);
+    bool needV = (mode == FullSVD || mode == ThinSVD || mode == RightSingularVectorsOnly);
+
+    // Tall matrices: A = Q * R, and the SVD of the n x n matrix R (LAPACK xGESVD)
+    bool                qrFirst = m >= 2 * n && n > 0;
+    Matrix<double>      qr;
+    std::vector<double> tauQR;
+    Matrix<double>      a;
+    if (qrFirst)
+    {
+        qr = mat;
+        qrPackedInPlace(qr, tauQR, nbrOfThreads);
+        a = qrPackedR(qr, true);
+    }
+    else
+    {
+        a = mat;
+    }
+
+    std::vector<double> tauQ;
+    std::vector<double> tauP;
+    bidiagonalPackedInPlace(a, tauQ, tauP, nbrOfThreads);
+
+    std::vector<double> d(n);
+    std::vector<double> e(n > 0 ? n - 1 : 0);
+    for (size_t k = 0; k < n; k++)
+        d[k] = a(k, k);
+    for (size_t k = 0; k + 1 < n; k++)
+        e[k] = a(k, k + 1);
+
+    // The singular vectors are rotated as rows of the transposed matrices
+    Matrix<double> ut;
+    Matrix<double> vt;
+    if (needU)
+        ut = bidiagonalPackedQ(a, tauQ, !full || qrFirst, nbrOfThreads).transpose();
+    if (needV)
+        vt = bidiagonalPackedP(a, tauP, nbrOfThreads).transpose();
+
+    if (!bidiagonalQRInPlace(d, e, needU ? &ut : nullptr, needV ? &vt : nullptr))
+        throw SVDFailedException();
+
+    Matrix<double> u;
+    if (needU)
+    {
+        u = ut.transpose();
+        if (qrFirst)
+        {
+            // U = Q * [U_R 0; 0 I] (full) or Q * [U_R; 0] (thin)
+            Matrix<double> uR = u;
+            u                 = Matrix<double>(m, full ? m : n);
+            u.fill(0.0);
+            u.setSubMatrix(0, 0, uR);
+            for (size_t k = n; k < u.cols(); k++)
+                u(k, k) = 1.0;
+            qrPackedApplyQInPlace(qr, tauQR, u, nbrOfThreads);
+        }
+    }
+
+    Matrix<double> sing(full ? m : n, n);
+    sing.fill(0.0);
+    for (size_t k = 0; k < n; k++)
+        sing(k, k) = d[k];
+
+    return SVDResult(u, sing, needV ? vt.transpose() : Matrix<double>());
+}
+
+inline bool Decomposition::jacobiOrthogonalizeRowsInPlace(Matrix<double>& at, Matrix<double>* vt, size_t nbrOfThreads)
+{
+    const size_t n   = at.rows();
+    const size_t len = at.cols();
+    if (n < 2)
+        return true;
+
+    // a pair is rotated as long as |ai' * aj| > tol * |ai| * |aj|
+    const double tol       = std::sqrt(static_cast<double>(len)) * std::numeric_limits<double>::epsilon();
+    const size_t maxSweeps = 60;
+
+    // round-robin schedule: player p - 1 is fixed, the others move by one place each
+    // round. For n odd, the pair with the dummy player n is skipped.
+    const size_t p        = n + (n % 2);
+    const size_t nbrPairs = p / 2;
+
+    std::vector<char> rotated(nbrPairs);
+    auto rotatePairs = [&](size_t round, size_t k0, size_t k1) {
+        for (size_t k = k0; k < k1; k++)
+        {
+            size_t i = (k == 0) ? p - 1 : (round + k) % (p - 1);
+            size_t j = (k == 0) ? round % (p - 1) : (round + p - 1 - k) % (p - 1);
+            if (i >= n || j >= n)
+                continue;
+
+            double* ai    = at.data() + i * len;
+            double* aj    = at.data() + j * len;
+            double  alpha = Kernels::dot(ai, ai, len);
+            double  beta  = Kernels::dot(aj, aj, len);
+            double  gamma = Kernels::dot(ai, aj, len);
+            if (gamma == 0.0 || std::abs(gamma) <= tol * std::sqrt(alpha) * std::sqrt(beta))
+                continue;
+
+            // rotation, which makes the rows i and j orthogonal
+            double zeta = (beta - alpha) / (2.0 * gamma);
+            double t    = (zeta >= 0.0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1.0 + zeta * zeta));
+            double c    = 1.0 / std::sqrt(1.0 + t * t);
+            double s    = c * t;
+
+            Kernels::rot(ai, aj, len, c, s);
+            if (vt != nullptr)
+                Kernels::rot(vt->data() + i * vt->cols(), vt->data() + j * vt->cols(), vt->cols(), c, s);
+            rotated[k] = 1;
+        }
+    };
+
+    size_t work     = 3 * len + (vt != nullptr ? vt->cols() : 0);
+    size_t minChunk = std::max<size_t>(1, Kernels::ParallelGrainSize / std::max<size_t>(1, work));
+    for (size_t sweep = 0; sweep < maxSweeps; sweep++)
+    {
+        bool anyRotation = false;
+        for (size_t round = 0; round < p - 1; round++)
+        {
+            std::fill(rotated.begin(), rotated.end(), 0);
+            Parallel::forRange(0, nbrPairs, [&](size_t k0, size_t k1) { rotatePairs(round, k0, k1); }, nbrOfThreads, minChunk);
+            anyRotation = anyRotation || std::find(rotated.begin(), rotated.end(), 1) != rotated.end();
+        }
+
+        if (!anyRotation)
+            return true;
+    }
+
+    return false;
+}
+
+inline void Decomposition::completeOrthonormalRows(Matrix<double>& q, size_t nbrOfValid)
+{
+    const size_t n         = q.cols();
+    size_t       candidate = 0;
+    for (size_t r = nbrOfValid; r < q.rows(); r++)
+    {
+        double* qr = q.data() + r * n;
+        while (true)
+        {
+            // unit vector, orthogonalized twice against the rows above
+            std::fill(qr, qr + n, 0.0);
+            qr[candidate++ % n] = 1.0;
+            for (size_t pass = 0; pass < 2; pass++)
+            {
+                for (size_t k = 0; k < r; k++)
+                {
+                    const double* qk = q.data() + k * n;
+                    Kernels::axpy(qr, qk, n, -Kernels::dot(qk, qr, n));
+                }
+            }
+
+            // among n consecutive candidates, one keeps at least the norm 1 / sqrt(n)
+            double norm = std::sqrt(Kernels::dot(qr, qr, n));
+            if (norm > 0.5 / std::sqrt(static_cast<double>(n)))
+            {
+                Kernels::scale(qr, n, 1.0 / norm);
+                break;
+            }
+        }
+    }
+}
+
+template <class T>
+Decomposition::SVDResult Decomposition::svdJacobi(const Matrix<T>& mat, SVDMode mode, size_t nbrOfThreads)
+{
+    size_t m = mat.rows();
+    size_t n = mat.cols();
 
-    Decomposition::DiagonalizationResult diag = Decomposition::bidiagonalization(mat);
-    Matrix<double> b = diag.D;
+    if (m < n)
+    {
+        // A' = U * S * V'
+        SVDMode transposedMode = mode;
+        if (mode == LeftSingularVectorsOnly)
+            transposedMode = RightSingularVectorsOnly;
+        else if (mode == RightSingularVectorsOnly)
+            transposedMode = LeftSingularVectorsOnly;
+
+        SVDResult transposed = svdJacobi(mat.transpose(), transposedMode, nbrOfThreads);
+        return SVDResult(transposed.V, transposed.S.transpose(), transposed.U);
+    }
+
+    bool full  = (mode == FullSVD);
+    bool needU = (mode == FullSVD || mode == ThinSVD || mode == LeftSingularVectorsOnly);
+    bool needV = (mode == FullSVD || mode == ThinSVD || mode == RightSingularVectorsOnly);
+
+    // Tall matrices: A = Q * R, and the SVD of the n x n matrix R
+    bool                qrFirst = m >= 2 * n && n > 0;
+    Matrix<double>      qr;
+    std::vector<double> tauQR;
+    Matrix<double>      at;
+    if (qrFirst)
+    {
+        qr = mat;
+        qrPackedInPlace(qr, tauQR, nbrOfThreads);
+        at = qrPackedR(qr, true).transpose();
+    }
+    else
+    {
+        at = mat.transpose();
+    }
 
-    size_t m = b.rows();
-    size_t n = b.cols();
+    // The columns of A are rotated as rows of A', until A * V = U * S
+    Matrix<double> vt;
+    if (needV)
+        vt = Matrix<double>::identity(n);
 
-    SVDResult resBiDiag = Decomposition::svdGolubKahanBidiagonal(b);
+    if (!jacobiOrthogonalizeRowsInPlace(at, needV ? &vt : nullptr, nbrOfThreads))
+        throw SVDFailedException();
 
-    Matrix<double> u = diag.U * resBiDiag.U;
-    Matrix<double> v = diag.V * resBiDiag.V;
+    // singular values are the norms of the rows, sorted descending
+    const size_t        len = at.cols();
+    std::vector<double> d(n);
+    std::vector<size_t> order(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        d[k]     = std::sqrt(Kernels::dot(at.data() + k * len, at.data() + k * len, len));
+        order[k] = k;
+    }
+    std::stable_sort(order.begin(), order.end(), [&d](size_t x, size_t y) { return d[x] > d[y]; });
 
-    // Make singular values positive
-    Matrix<double> sing(b.rows(), b.cols());
+    Matrix<double> sing(full ? m : n, n);
     sing.fill(0.0);
+    for (size_t k = 0; k < n; k++)
+        sing(k, k) = d[order[k]];
+
+    Matrix<double> v;
+    if (needV)
+    {
+        v = Matrix<double>(n, n);
+        for (size_t k = 0; k < n; k++)
+            for (size_t r = 0; r < n; r++)
+                v(r, k) = vt(order[k], r);
+    }
+
+    Matrix<double> u;
+    if (needU)
+    {
+        // the rows of ut are the normalized rows of A', completed for zero singular values
+        Matrix<double> ut((full && !qrFirst) ? m : n, len);
+        ut.fill(0.0);
+        size_t nbrOfValid = 0;
+        while (nbrOfValid < n && d[order[nbrOfValid]] > 0.0)
+        {
+            const double* src = at.data() + order[nbrOfValid] * len;
+            std::copy(src, src + len, ut.data() + nbrOfValid * len);
+            Kernels::scale(ut.data() + nbrOfValid * len, len, 1.0 / d[order[nbrOfValid]]);
+            nbrOfValid++;
+        }
+        completeOrthonormalRows(ut, nbrOfValid);
+
+        u = ut.transpose();
+        if (qrFirst)
+        {
+            // U = Q * [U_R 0; 0 I] (full) or Q * [U_R; 0] (thin)
+            Matrix<double> uR = u;
+            u                 = Matrix<double>(m, full ? m : n);
+            u.fill(0.0);
+            u.setSubMatrix(0, 0, uR);
+            for (size_t k = n; k < u.cols(); k++)
+                u(k, k) = 1.0;
+            qrPackedApplyQInPlace(qr, tauQR, u, nbrOfThreads);
+        }
+    }
+
+    return SVDResult(u, sing, v);
+}
+
+inline void Decomposition::checkThinSVD(const SVDResult& svd)
+{
+    size_t k = svd.S.rows();
+    if (svd.S.cols() != k || svd.U.cols() != k || svd.V.cols() != k)
+        throw InvalidInputException();
+}
+
+inline Decomposition::SVDResult Decomposition::truncatedSVD(const Matrix<double>& small, size_t rank)
+{
+    SVDResult res = svdGolubKahan(small, ThinSVD);
+    size_t    r   = std::max<size_t>(1, std::min(rank, res.S.rows()));
+    return SVDResult(res.U.subMatrix(0, 0, res.U.rows(), r), res.S.subMatrix(0, 0, r, r), res.V.subMatrix(0, 0, res.V.rows(), r));
+}
+
+inline Decomposition::SVDResult Decomposition::svdAppendColumns(const SVDResult& svd, const Matrix<double>& columns, size_t rank,
+                                                                size_t nbrOfThreads)
+{
+    checkThinSVD(svd);
+    const Matrix<double>& u = svd.U;
+    const size_t          m = u.rows();
+    const size_t          k = u.cols();
+    const size_t          n = svd.V.rows();
+    const size_t          p = columns.cols();
+    if (columns.rows() != m || k > m)
+        throw InvalidInputException();
+
+    // L = U' * C and H = C - U * L, projected twice against U for orthogonality
+    Matrix<double> l(k, p);
+    l.fill(0.0);
+    Matrix<double> h = columns;
+    for (size_t pass = 0; pass < 2; pass++)
+    {
+        Matrix<double> lPass(k, p);
+        lPass.fill(0.0);
+        Kernels::gemmTN(u, h, lPass, 1.0, nbrOfThreads);
+        Kernels::gemmNT(u, lPass.transpose(), h, -1.0, nbrOfThreads);
+        l = l + lPass;
+    }
+
+    // H = J * K, where J (m x j) is orthonormal and orthogonal to U. If H has more
+    // columns than the complement of U has dimensions, J is a basis of that complement.
+    Matrix<double> j;
+    Matrix<double> kMat;
+    if (p <= m - k)
+    {
+        QRResult qrH = tsqr(h, true, 0, nbrOfThreads);
+        j            = qrH.Q;
+        kMat         = qrH.R;
+    }
+    else
+    {
+        Matrix<double> basisT(m, m);
+        basisT.fill(0.0);
+        basisT.setSubMatrix(0, 0, u.transpose());
+        completeOrthonormalRows(basisT, k);
+        j    = basisT.subMatrix(k, 0, m - k, m).transpose();
+        kMat = Matrix<double>(m - k, p);
+        kMat.fill(0.0);
+        Kernels::gemmTN(j, h, kMat, 1.0, nbrOfThreads);
+    }
+    const size_t jCols = j.cols();
+
+    // [A C] = [U J] * [S L; 0 K] * [V 0; 0 I]'
+    Matrix<double> middle(k + jCols, k + p);
+    middle.fill(0.0);
+    middle.setSubMatrix(0, 0, svd.S);
+    middle.setSubMatrix(0, k, l);
+    middle.setSubMatrix(k, k, kMat);
+
+    SVDResult      small = truncatedSVD(middle, rank > 0 ? rank : k);
+    const size_t   r     = small.S.rows();
+    Matrix<double> uj(m, k + jCols);
+    uj.setSubMatrix(0, 0, u);
+    uj.setSubMatrix(0, k, j);
+    Matrix<double> newU(m, r);
+    newU.fill(0.0);
+    Kernels::gemmNT(uj, small.U.transpose(), newU, 1.0, nbrOfThreads);
+
+    Matrix<double> newV(n + p, r);
+    newV.fill(0.0);
+    Matrix<double> top(n, r);
+    top.fill(0.0);
+    Kernels::gemmNT(svd.V, small.V.subMatrix(0, 0, k, r).transpose(), top, 1.0, nbrOfThreads);
+    newV.setSubMatrix(0, 0, top);
+    newV.setSubMatrix(n, 0, small.V.subMatrix(k, 0, p, r));
+
+    return SVDResult(newU, small.S, newV);
+}
+
+inline Decomposition::SVDResult Decomposition::svdAppendRows(const SVDResult& svd, const Matrix<double>& rows, size_t rank,
+                                                             size_t nbrOfThreads)
+{
+    // A' = V * S * U'
+    checkThinSVD(svd);
+    SVDResult transposed = svdAppendColumns(SVDResult(svd.V, svd.S, svd.U), rows.transpose(), rank, nbrOfThreads);
+    return SVDResult(transposed.V, transposed.S, transposed.U);
+}
+
+inline Decomposition::SVDResult Decomposition::svdRemoveColumns(const SVDResult& svd, size_t firstColumn, size_t nbrOfColumns,
+                                                                size_t rank, size_t nbrOfThreads)
+{
+    checkThinSVD(svd);
+    const size_t m = svd.U.rows();
+    const size_t k = svd.U.cols();
+    const size_t n = svd.V.rows();
+    if (nbrOfColumns == 0 || firstColumn + nbrOfColumns > n || nbrOfColumns == n)
+        throw InvalidInputException();
 
-    // negative singular values to positive
-    for( size_t k = 0; k < b.cols(); k++ )
+    // remaining rows of V
+    const size_t   nKeep = n - nbrOfColumns;
+    Matrix<double> vKeep(nKeep, k);
+    if (firstColumn > 0)
+        vKeep.setSubMatrix(0, 0, svd.V.subMatrix(0, 0, firstColumn, k));
+    if (firstColumn < nKeep)
+        vKeep.setSubMatrix(firstColumn, 0, svd.V.subMatrix(firstColumn + nbrOfColumns, 0, nKeep - firstColumn, k));
+
+    // A_keep = U * S * V_keep' = U * (S * R') * Q' with V_keep = Q * R
+    Matrix<double> q;
+    Matrix<double> small;
+    if (nKeep >= k)
+    {
+        QRResult qrV = tsqr(vKeep, true, 0, nbrOfThreads);
+        q            = qrV.Q;
+        small        = svd.S * qrV.R.transpose();
+    }
+    else
     {
-        double s = b(k,k);
+        q     = Matrix<double>::identity(nKeep);
+        small = svd.S * vKeep.transpose();
+    }
+
+    SVDResult      smallSVD = truncatedSVD(small, rank > 0 ? rank : k);
+    const size_t   r        = smallSVD.S.rows();
+    Matrix<double> newU(m, r);
+    newU.fill(0.0);
+    Kernels::gemmNT(svd.U, smallSVD.U.transpose(), newU, 1.0, nbrOfThreads);
+    Matrix<double> newV(nKeep, r);
+    newV.fill(0.0);
+    Kernels::gemmNT(q, smallSVD.V.transpose(), newV, 1.0, nbrOfThreads);
+
+    return SVDResult(newU, smallSVD.S, newV);
+}
+
+template <class T>
+Decomposition::SVDResult Decomposition::svdRandomized(const Matrix<T>& mat, size_t rank, size_t oversampling,
+                                                      size_t nbrOfPowerIterations, size_t nbrOfThreads)
+{
+    const Matrix<double> a = mat;
+    const size_t         n = a.cols();
+    auto rowBlock = [&a, n](size_t firstRow, Matrix<double>& block) {
+        std::copy(a.data() + firstRow * n, a.data() + (firstRow + block.rows()) * n, block.data());
+    };
 
-        if( s < 0.0 )
+    return svdRandomizedStreamed(rowBlock, a.rows(), n, rank, oversampling, nbrOfPowerIterations, 0, nbrOfThreads);
+}
+
+template <class F>
+Decomposition::SVDResult Decomposition::svdRandomizedStreamed(F rowBlock, size_t m, size_t n, size_t rank,
+                                                              size_t oversampling, size_t nbrOfPowerIterations,
+                                                              size_t rowBlockSize, size_t nbrOfThreads)
+{
+    if (rank == 0 || rank > std::min(m, n))
+        throw InvalidInputException();
+
+    const size_t l  = std::min(rank + oversampling, std::min(m, n));
+    const size_t bs = rowBlockSize > 0 ? rowBlockSize : std::max<size_t>(l, (size_t(1) << 20) / n);
+
+    // Y = A * W, where W is passed transposed (l x n)
+    auto sample = [&](const Matrix<double>& wt) {
+        Matrix<double> y(m, l);
+        for (size_t r0 = 0; r0 < m; r0 += bs)
+        {
+            size_t         nr = std::min(bs, m - r0);
+            Matrix<double> block(nr, n);
+            rowBlock(r0, block);
+
+            Matrix<double> yBlock(nr, l);
+            yBlock.fill(0.0);
+            Kernels::gemmNT(block, wt, yBlock, 1.0, nbrOfThreads);
+            std::copy(yBlock.data(), yBlock.data() + nr * l, y.data() + r0 * l);
+        }
+        return y;
+    };
+
+    // Q' * A (l x n) for Q with orthonormal columns (m x l)
+    auto project = [&](const Matrix<double>& q) {
+        Matrix<double> zt(l, n);
+        zt.fill(0.0);
+        for (size_t r0 = 0; r0 < m; r0 += bs)
         {
-            // invert s and row k in u
-            s = -s;
-            for( size_t r = 0; r < u.rows(); r++ )
-                u(r,k) = -u(r,k);
+            size_t         nr = std::min(bs, m - r0);
+            Matrix<double> block(nr, n);
+            rowBlock(r0, block);
+            Kernels::gemmTN(Matrix<double>(nr, l, q.data() + r0 * l), block, zt, 1.0, nbrOfThreads);
         }
+        return zt;
+    };
+
+    auto orthonormalize = [nbrOfThreads](const Matrix<double>& y) {
+        return tsqr(y, true, 0, nbrOfThreads).Q;
+    };
+
+    // Gaussian test matrix, transposed
+    std::mt19937                     gen(42);
+    std::normal_distribution<double> dist(0.0, 1.0);
+    Matrix<double>                   omegaT(l, n);
+    for (size_t k = 0; k < l * n; k++)
+        omegaT.data()[k] = dist(gen);
 
-        sing(k,k) = s;
+    Matrix<double> q = orthonormalize(sample(omegaT));
+    for (size_t it = 0; it < nbrOfPowerIterations; it++)
+    {
+        // Re-orthonormalizing both sides keeps the small singular values from drowning in rounding errors
+        Matrix<double> z = orthonormalize(project(q).transpose());
+        q                = orthonormalize(sample(z.transpose()));
     }
 
-    Decomposition::SVDResult sorted = Decomposition::sortSingularValues(SVDResult(u,sing,v));
-    return sorted;
+    // B = Q' * A = Ub * S * V', and A ~ (Q * Ub) * S * V'
+    SVDResult      small = svdGolubKahan(project(q), ThinSVD, nbrOfThreads);
+    Matrix<double> u(m, l);
+    u.fill(0.0);
+    Kernels::gemmNT(q, small.U.transpose(), u, 1.0, nbrOfThreads);
+
+    return SVDResult(u.subMatrix(0, 0, m, rank), small.S.subMatrix(0, 0, rank, rank), small.V.subMatrix(0, 0, n, rank));
 }
 
 #endif //MY_DECOMPOSITION_H
@@ -0,0 +1,420 @@
+/****************************************************************************
+** Copyright (c) 2019 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef MY_ESTIMATION_H
+#define MY_ESTIMATION_H
+
+#include "matrix.hpp"
+#include "decomposition.hpp"
+
+/**
+ * Iterative estimators for matrix norms and condition numbers,
+ * which avoid computing a full SVD or an inverse.
+ */
+class Estimation
+{
+public:
+    struct NormEstimate
+    {
+        NormEstimate()
+        : Value(0.0), LowerBound(0.0), UpperBound(0.0), NbrIterations(0), Converged(true)
+        {
+        }
+
+        NormEstimate(double value, double lower, double upper, size_t nbrIterations, bool converged)
+        : Value(value), LowerBound(lower), UpperBound(upper), NbrIterations(nbrIterations), Converged(converged)
+        {
+        }
+
+        double ErrorBound() const
+        {
+            return UpperBound - LowerBound;
+        }
+
+        double Value;         // Estimated norm
+        double LowerBound;    // The true value is at least this value
+        double UpperBound;    // Upper bound of the true value (infinity if unknown), see the estimators
+        size_t NbrIterations; // Number of performed iterations
+        bool   Converged;     // Requested accuracy was reached
+    };
+
+    /**
+     * Estimates the spectral norm (largest singular value) of the matrix by
+     * power iteration on A'*A. Each iteration costs two matrix-vector products.
+     * The start vector is the column sums of |A| with a random perturbation,
+     * so it is not orthogonal to the dominant singular vector. Both bounds are
+     * always valid. The lower bound is the Rayleigh quotient. The upper bound
+     * combines the residual r of the Rayleigh quotient theta of A'*A with its
+     * trace ||A||_F^2: some eigenvalue lies within r of theta, so the largest
+     * one is at most max(theta + r, ||A||_F^2 - theta + r). This is sharp if the
+     * largest singular value carries more than half of ||A||_F^2. Otherwise
+     * ErrorBound() is only a worst-case spread, not the accuracy of the estimate,
+     * and Converged tells whether the iteration settled.
+     * @param mat Matrix A.
+     * @param relTolerance Iteration stops when the residual of the iteration vector
+     *                     changes the estimate by at most relTolerance.
+     * @param maxIteration Maximum number of iterations.
+     * @return Norm estimate.
+     */
+    template <class T>
+    static NormEstimate normL2(const Matrix<T>& mat, double relTolerance = 1e-10, size_t maxIteration = 1000);
+
+    /**
+     * Estimates the L1 norm of the inverse of A, given a packed LU decomposition
+     * of A. The Hager / Higham estimator (LAPACK xLACN2) is used, which needs only
+     * a few solves with A and A'. The result is a lower bound, which is exact in
+     * most cases.
+     * @param lu Packed LU decomposition of A.
+     * @param transposed If true, the L1 norm of inverse(A') is estimated, which is equal
+     *                   to the infinity norm of inverse(A).
+     * @param maxIteration Maximum number of estimator iterations.
+     * @param upperBoundTolerance If larger than 0, an upper bound is estimated by
+     *                   ||inv(A)||_1 <= sqrt(n) * ||inv(A)||_2, where the 2-norm is estimated by power
+     *                   iteration with this relative tolerance. This is not a guaranteed bound, since
+     *                   the iteration may settle on a smaller singular value. Otherwise the upper
+     *                   bound is infinity.
+     * @return Norm estimate.
+     */
+    static NormEstimate inverseNormL1(const Decomposition::LUPackedResult& lu, bool transposed = false, size_t maxIteration = 5, double upperBoundTolerance = 0.0);
+
+    /**
+     * Estimates the L1 norm condition number ||A||_1 * ||inv(A)||_1 by
+     * a LU decomposition and inverseNormL1.
+     * @param mat Square matrix A.
+     * @param maxIteration Maximum number of estimator iterations.
+     * @param upperBoundTolerance See inverseNormL1.
+     * @return Condition number estimate.
+     */
+    template <class T>
+    static NormEstimate conditionNumberL1(const Matrix<T>& mat, size_t maxIteration = 5, double upperBoundTolerance = 0.0);
+
+    /**
+     * Estimates the infinity norm condition number ||A||_inf * ||inv(A)||_inf by
+     * a LU decomposition and inverseNormL1.
+     * @param mat Square matrix A.
+     * @param maxIteration Maximum number of estimator iterations.
+     * @param upperBoundTolerance See inverseNormL1.
+     * @return Condition number estimate.
+     */
+    template <class T>
+    static NormEstimate conditionNumberInf(const Matrix<T>& mat, size_t maxIteration = 5, double upperBoundTolerance = 0.0);
+
+private:
+    template <class F, class G>
+    static NormEstimate powerIterationL2(F apply, G applyTransposed, Matrix<double> x, double trivialUpperBound, double traceBtB,
+                                         double relTolerance, size_t maxIteration, double& residualEstimate);
+
+    static void perturbStartVector(Matrix<double>& x);
+
+    template <class T>
+    static NormEstimate conditionNumber(const Matrix<T>& mat, bool infinityNorm, size_t maxIteration, double upperBoundTolerance);
+};
+
+// x is the normalized start vector. apply computes y = B * x, applyTransposed z = B' * y.
+// traceBtB is the trace of B'B, or infinity if unknown. residualEstimate is set to
+// sqrt(theta + r) of the last iteration, which bounds the singular value the iteration
+// settled on. It is no guaranteed bound of the norm, since that may be a smaller one.
+template <class F, class G>
+Estimation::NormEstimate Estimation::powerIterationL2(F apply, G applyTransposed, Matrix<double> x, double trivialUpperBound, double traceBtB,
+                                                      double relTolerance, size_t maxIteration, double& residualEstimate)
+{
+    size_t n = x.rows();
+
+    Matrix<double> y;
+    Matrix<double> z;
+
+    double lower = 0.0;
+    double upper = trivialUpperBound;
+    size_t iter  = 0;
+    bool   conv  = false;
+
+    residualEstimate = std::numeric_limits<double>::infinity();
+
+    while (iter < maxIteration && !conv)
+    {
+        iter++;
+
+        apply(x, y);
+        applyTransposed(y, z);
+
+        // Rayleigh quotient of B'B and residual
+        double theta = y.normSquare();
+        double res   = 0.0;
+        for (size_t i = 0; i < n; i++)
+            res += std::pow(z(i, 0) - theta * x(i, 0), 2.0);
+        res = std::sqrt(res);
+
+        lower = std::max(lower, std::sqrt(theta));
+
+        // There is an eigenvalue of B'B in [theta - res, theta + res]. Either it is the
+        // largest one, or the largest one is at most the trace minus this eigenvalue.
+        residualEstimate = std::sqrt(theta + res);
+        upper            = std::min(upper, std::sqrt(std::max(theta, traceBtB - theta) + res));
+        upper            = std::max(upper, lower);
+
+        if (residualEstimate - std::sqrt(theta) <= relTolerance * std::sqrt(theta))
+        {
+            conv = true;
+        }
+        else
+        {
+            double zNorm = z.norm();
+            if (!(zNorm > 0.0) || !std::isfinite(zNorm))
+                break;
+
+            x = z * (1.0 / zNorm);
+        }
+    }
+
+    return NormEstimate(lower, lower, upper, iter, conv);
+}
+
+template <class T>
+Estimation::NormEstimate Estimation::normL2(const Matrix<T>& mat, double relTolerance, size_t maxIteration)
+{
+    Matrix<double> a = mat;
+    size_t         m = a.rows();
+    size_t         n = a.cols();
+
+    // start with the column sums of |a|. The column with the
+    // largest entries is likely to point to the dominant direction.
+    Matrix<double> x(n, 1);
+    x.fill(0.0);
+    double frob    = 0.0;
+    double normInf = 0.0;
+    for (size_t i = 0; i < m; i++)
+    {
+        const double* aRow   = a.data() + i * n;
+        double        rowSum = 0.0;
+        for (size_t j = 0; j < n; j++)
+        {
+            x(j, 0) += std::abs(aRow[j]);
+            rowSum += std::abs(aRow[j]);
+            frob += aRow[j] * aRow[j];
+        }
+        normInf = std::max(normInf, rowSum);
+    }
+    frob = std::sqrt(frob);
+
+    double norm1 = 0.0;
+    for (size_t j = 0; j < n; j++)
+        norm1 = std::max(norm1, x(j, 0));
+
+    double xNorm = x.norm();
+    if (!(xNorm > 0.0))
+        return NormEstimate(); // zero matrix
+
+    // The column sums can be exactly orthogonal to the dominant right
+    // singular vector, e.g. for [1 -1; 0.1 0.1].
+    x = x * (1.0 / xNorm);
+    perturbStartVector(x);
+
+    auto apply = [&a, m, n](const Matrix<double>& v, Matrix<double>& res) {
+        if (res.rows() != m || res.cols() != 1)
+            res = Matrix<double>(m, 1);
+
+        for (size_t i = 0; i < m; i++)
+        {
+            const double* aRow = a.data() + i * n;
+            double        s    = 0.0;
+            for (size_t j = 0; j < n; j++)
+                s += aRow[j] * v(j, 0);
+            res(i, 0) = s;
+        }
+    };
+
+    auto applyTransposed = [&a, m, n](const Matrix<double>& v, Matrix<double>& res) {
+        if (res.rows() != n || res.cols() != 1)
+            res = Matrix<double>(n, 1);
+
+        res.fill(0.0);
+        for (size_t i = 0; i < m; i++)
+        {
+            const double* aRow = a.data() + i * n;
+            double        vi   = v(i, 0);
+            for (size_t j = 0; j < n; j++)
+                res(j, 0) += aRow[j] * vi;
+        }
+    };
+
+    double residualEstimate;
+    return powerIterationL2(apply, applyTransposed, x, std::min(frob, std::sqrt(norm1 * normInf)), frob * frob, relTolerance, maxIteration,
+                            residualEstimate);
+}
+
+// Adds a random vector of half the length to the normalized vector x and normalizes
+// the result. A fixed seed keeps the estimators deterministic.
+inline void Estimation::perturbStartVector(Matrix<double>& x)
+{
+    size_t n = x.rows();
+
+    std::mt19937                           gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    Matrix<double> r(n, 1);
+    for (size_t i = 0; i < n; i++)
+        r(i, 0) = dist(gen);
+
+    double rNorm = r.norm();
+    if (rNorm > 0.0)
+        x = x + r * (0.5 / rNorm);
+
+    double xNorm = x.norm();
+    if (xNorm > 0.0)
+        x = x * (1.0 / xNorm);
+}
+
+// Algorithm: N. J. Higham, "FORTRAN codes for estimating the one-norm of a real
+// or complex matrix, with applications to condition estimation", 1988.
+inline Estimation::NormEstimate Estimation::inverseNormL1(const Decomposition::LUPackedResult& lu, bool transposed, size_t maxIteration, double upperBoundTolerance)
+{
+    size_t n = lu.LU.rows();
+    if (n == 0)
+        return NormEstimate();
+
+    // B = inv(A) or inv(A')
+    auto applyB = [&lu, transposed](Matrix<double>& v) {
+        if (transposed)
+            Decomposition::luPackedSolveTransposedInPlace(lu.LU, lu.Pivots, v);
+        else
+            Decomposition::luPackedSolveInPlace(lu.LU, lu.Pivots, v);
+    };
+
+    auto applyBT = [&lu, transposed](Matrix<double>& v) {
+        if (transposed)
+            Decomposition::luPackedSolveInPlace(lu.LU, lu.Pivots, v);
+        else
+            Decomposition::luPackedSolveTransposedInPlace(lu.LU, lu.Pivots, v);
+    };
+
+    auto l1 = [](const Matrix<double>& v) {
+        double s = 0.0;
+        for (size_t i = 0; i < v.rows(); i++)
+            s += std::abs(v(i, 0));
+        return s;
+    };
+
+    Matrix<double> x(n, 1);
+    x.fill(1.0 / n);
+
+    double est  = 0.0;
+    size_t iter = 0;
+
+    while (iter < std::max<size_t>(maxIteration, 1))
+    {
+        Matrix<double> y = x;
+        applyB(y);
+        double estNew = l1(y);
+
+        if (iter > 0 && estNew <= est)
+            break;
+
+        est = estNew;
+        iter++;
+
+        // sign vector
+        Matrix<double> z(n, 1);
+        for (size_t i = 0; i < n; i++)
+            z(i, 0) = y(i, 0) >= 0.0 ? 1.0 : -1.0;
+
+        applyBT(z);
+
+        size_t jMax = 0;
+        double zx   = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (std::abs(z(i, 0)) > std::abs(z(jMax, 0)))
+                jMax = i;
+            zx += z(i, 0) * x(i, 0);
+        }
+
+        if (iter > 1 && std::abs(z(jMax, 0)) <= zx)
+            break;
+
+        x.fill(0.0);
+        x(jMax, 0) = 1.0;
+    }
+
+    // alternative estimate, which catches the rare cases where the above fails
+    Matrix<double> b(n, 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        double sign = (i % 2 == 0) ? 1.0 : -1.0;
+        b(i, 0)     = sign * (1.0 + (n > 1 ? static_cast<double>(i) / (n - 1) : 0.0));
+    }
+    applyB(b);
+    est = std::max(est, 2.0 * l1(b) / (3.0 * n));
+
+    double upper = std::numeric_limits<double>::infinity();
+    if (upperBoundTolerance > 0.0)
+    {
+        auto apply = [&applyB](const Matrix<double>& v, Matrix<double>& res) {
+            res = v;
+            applyB(res);
+        };
+        auto applyT = [&applyBT](const Matrix<double>& v, Matrix<double>& res) {
+            res = v;
+            applyBT(res);
+        };
+
+        Matrix<double> x0(n, 1);
+        x0.fill(1.0 / std::sqrt(static_cast<double>(n)));
+        perturbStartVector(x0);
+
+        double       l2Estimate;
+        NormEstimate l2 = powerIterationL2(apply, applyT, x0, std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(),
+                                           upperBoundTolerance, 1000, l2Estimate);
+        if (l2.Converged)
+            upper = std::max(est, std::sqrt(static_cast<double>(n)) * l2Estimate);
+    }
+
+    return NormEstimate(est, est, upper, iter, true);
+}
+
+template <class T>
+Estimation::NormEstimate Estimation::conditionNumberL1(const Matrix<T>& mat, size_t maxIteration, double upperBoundTolerance)
+{
+    return conditionNumber(mat, false, maxIteration, upperBoundTolerance);
+}
+
+template <class T>
+Estimation::NormEstimate Estimation::conditionNumberInf(const Matrix<T>& mat, size_t maxIteration, double upperBoundTolerance)
+{
+    return conditionNumber(mat, true, maxIteration, upperBoundTolerance);
+}
+
+template <class T>
+Estimation::NormEstimate Estimation::conditionNumber(const Matrix<T>& mat, bool infinityNorm, size_t maxIteration, double upperBoundTolerance)
+{
+    Decomposition::LUPackedResult lu = Decomposition::luPacked(mat);
+    if (lu.Singular)
+        throw ZeroDeterminantException();
+
+    // ||inv(A)||_inf = ||inv(A')||_1
+    double       normA   = infinityNorm ? static_cast<double>(mat.normInf()) : static_cast<double>(mat.normL1());
+    NormEstimate invNorm = inverseNormL1(lu, infinityNorm, maxIteration, upperBoundTolerance);
+
+    return NormEstimate(normA * invNorm.Value, normA * invNorm.LowerBound, normA * invNorm.UpperBound, invNorm.NbrIterations, invNorm.Converged);
+}
+
+#endif //MY_ESTIMATION_H
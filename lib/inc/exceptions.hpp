@@ -90,6 +90,14 @@ class OutOfRangeException : public std::exception
     }
 };
 
+class NotPositiveDefiniteException : public std::exception
+{
+    virtual const char* what() const throw() override
+    {
+        return "Positive definite matrix expected";
+    }
+};
+
 
 
 #endif //MY_EXCEPTIONS_H
@@ -0,0 +1,390 @@
+/****************************************************************************
+** Copyright (c) 2019 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef MY_KERNELS_H
+#define MY_KERNELS_H
+
+#include "matrix.hpp"
+#include "parallel.hpp"
+
+#include <smmintrin.h> // SSE4
+#include <numeric>
+
+/**
+ * In-place level-1 kernels on contiguous arrays, e.g. matrix rows.
+ * They work without temporary allocations. The double versions are
+ * vectorized with SSE. The matrix products are built on them.
+ */
+class Kernels
+{
+public:
+    /**
+     * x = alpha * x
+     * @param x Array of length n.
+     * @param n Length.
+     * @param alpha Factor.
+     */
+    template <class T>
+    static void scale(T* x, size_t n, T alpha);
+
+    /**
+     * y = y + alpha * x
+     * @param y Array of length n, modified.
+     * @param x Array of length n.
+     * @param n Length.
+     * @param alpha Factor.
+     */
+    template <class T>
+    static void axpy(T* y, const T* x, size_t n, T alpha);
+
+    /**
+     * Inner product of x and y.
+     * @param x Array of length n.
+     * @param y Array of length n.
+     * @param n Length.
+     * @return Sum of x[i] * y[i].
+     */
+    template <class T>
+    static T dot(const T* x, const T* y, size_t n);
+
+    /**
+     * Plane rotation of the two arrays x and y:
+     * x = c * x - s * y and y = s * x + c * y.
+     * @param x Array of n elements with distance stride, modified.
+     * @param y Array of n elements with distance stride, modified.
+     * @param n Number of elements.
+     * @param c Cosine.
+     * @param s Sine.
+     * @param stride Distance between two elements, e.g. the number of columns to rotate matrix columns.
+     */
+    static void rot(double* x, double* y, size_t n, double c, double s, size_t stride = 1);
+
+    /**
+     * Exchanges the content of x and y.
+     * @param x Array of length n.
+     * @param y Array of length n.
+     * @param n Length.
+     */
+    template <class T>
+    static void swap(T* x, T* y, size_t n);
+
+    /**
+     * Row r1 = row r1 + alpha * row r0, restricted to the columns [colBegin, cols).
+     * @param mat Matrix.
+     * @param alpha Factor.
+     * @param r0 Source row.
+     * @param r1 Destination row.
+     * @param colBegin First column.
+     */
+    template <class T>
+    static void addProductOfRow(Matrix<T>& mat, T alpha, size_t r0, size_t r1, size_t colBegin = 0);
+
+    /**
+     * Row r = alpha * row r, restricted to the columns [colBegin, cols).
+     * @param mat Matrix.
+     * @param alpha Factor.
+     * @param r Row.
+     * @param colBegin First column.
+     */
+    template <class T>
+    static void scaleRow(Matrix<T>& mat, T alpha, size_t r, size_t colBegin = 0);
+
+    /**
+     * Eliminates with the pivot row: Each row r in rows gets row r = row r + factors[i] * row pivotRow,
+     * restricted to the columns [colBegin, cols). The rows are independent and
+     * are processed in parallel if the matrix is large enough.
+     * @param mat Matrix.
+     * @param pivotRow Pivot row. It must not be within rows.
+     * @param rows Rows to update.
+     * @param factors Factor per row to update.
+     * @param colBegin First column.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    template <class T>
+    static void eliminateRows(Matrix<T>& mat, size_t pivotRow, const std::vector<size_t>& rows, const std::vector<T>& factors,
+                              size_t colBegin = 0, size_t nbrOfThreads = 0);
+
+    /**
+     * C = C + alpha * A * B', where A is m x k, B is n x k and C is m x n.
+     * Each entry is a dot product of two contiguous rows. The rows of C are
+     * split onto threads and k is processed in tiles, so that a tile of B
+     * stays in the cache while it is used for many rows of A.
+     * @param a Matrix A.
+     * @param b Matrix B.
+     * @param c Matrix C, modified.
+     * @param alpha Factor.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void gemmNT(const Matrix<double>& a, const Matrix<double>& b, Matrix<double>& c, double alpha = 1.0, size_t nbrOfThreads = 0);
+
+    /**
+     * C = C + alpha * A' * B, where A is k x m, B is k x n and C is m x n.
+     * The product is a sum of k rank one updates of contiguous rows. The
+     * columns of C are split onto threads, in tiles which stay in the cache.
+     * @param a Matrix A.
+     * @param b Matrix B.
+     * @param c Matrix C, modified.
+     * @param alpha Factor.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void gemmTN(const Matrix<double>& a, const Matrix<double>& b, Matrix<double>& c, double alpha = 1.0, size_t nbrOfThreads = 0);
+
+    /**
+     * Number of elements a thread should at least process
+     * in one parallel chunk. Below, threading does not pay off.
+     */
+    static const size_t ParallelGrainSize = 1 << 16;
+
+    /**
+     * Number of elements a thread should at least process in a parallel
+     * loop, which is run once per column of a factorization. forRange starts
+     * new threads on every call, so such loops need more work per thread
+     * to pay off the start of the threads.
+     */
+    static const size_t ColumnStepGrainSize = 1 << 19;
+};
+
+template <class T>
+void Kernels::scale(T* x, size_t n, T alpha)
+{
+    for (size_t i = 0; i < n; i++)
+        x[i] *= alpha;
+}
+
+template <>
+inline void Kernels::scale(double* x, size_t n, double alpha)
+{
+    const __m128d a = _mm_set1_pd(alpha);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_pd(x + i, _mm_mul_pd(a, _mm_loadu_pd(x + i)));
+        _mm_storeu_pd(x + i + 2, _mm_mul_pd(a, _mm_loadu_pd(x + i + 2)));
+    }
+
+    for (; i < n; i++)
+        x[i] *= alpha;
+}
+
+template <class T>
+void Kernels::axpy(T* y, const T* x, size_t n, T alpha)
+{
+    for (size_t i = 0; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+template <>
+inline void Kernels::axpy(double* y, const double* x, size_t n, double alpha)
+{
+    const __m128d a = _mm_set1_pd(alpha);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128d y0 = _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(a, _mm_loadu_pd(x + i)));
+        __m128d y1 = _mm_add_pd(_mm_loadu_pd(y + i + 2), _mm_mul_pd(a, _mm_loadu_pd(x + i + 2)));
+        _mm_storeu_pd(y + i, y0);
+        _mm_storeu_pd(y + i + 2, y1);
+    }
+
+    for (; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+template <class T>
+T Kernels::dot(const T* x, const T* y, size_t n)
+{
+    return std::inner_product(x, x + n, y, static_cast<T>(0));
+}
+
+template <>
+inline double Kernels::dot(const double* x, const double* y, size_t n)
+{
+    // two independent accumulators hide the add latency
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+    }
+
+    double acc[2];
+    _mm_storeu_pd(acc, _mm_add_pd(acc0, acc1));
+    double sum = acc[0] + acc[1];
+
+    for (; i < n; i++)
+        sum += x[i] * y[i];
+
+    return sum;
+}
+
+inline void Kernels::rot(double* x, double* y, size_t n, double c, double s, size_t stride)
+{
+    size_t i = 0;
+    if (stride == 1)
+    {
+        const __m128d cv = _mm_set1_pd(c);
+        const __m128d sv = _mm_set1_pd(s);
+        for (; i + 2 <= n; i += 2)
+        {
+            __m128d xv = _mm_loadu_pd(x + i);
+            __m128d yv = _mm_loadu_pd(y + i);
+            _mm_storeu_pd(x + i, _mm_sub_pd(_mm_mul_pd(cv, xv), _mm_mul_pd(sv, yv)));
+            _mm_storeu_pd(y + i, _mm_add_pd(_mm_mul_pd(sv, xv), _mm_mul_pd(cv, yv)));
+        }
+    }
+
+    for (; i < n; i++)
+    {
+        double xi     = x[i * stride];
+        double yi     = y[i * stride];
+        x[i * stride] = c * xi - s * yi;
+        y[i * stride] = s * xi + c * yi;
+    }
+}
+
+template <class T>
+void Kernels::swap(T* x, T* y, size_t n)
+{
+    std::swap_ranges(x, x + n, y);
+}
+
+template <>
+inline void Kernels::swap(double* x, double* y, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d xv = _mm_loadu_pd(x + i);
+        __m128d yv = _mm_loadu_pd(y + i);
+        _mm_storeu_pd(x + i, yv);
+        _mm_storeu_pd(y + i, xv);
+    }
+
+    for (; i < n; i++)
+        std::swap(x[i], y[i]);
+}
+
+template <class T>
+void Kernels::addProductOfRow(Matrix<T>& mat, T alpha, size_t r0, size_t r1, size_t colBegin)
+{
+    if (std::max(r0, r1) >= mat.rows() || colBegin > mat.cols())
+        throw InvalidInputException();
+
+    const size_t n = mat.cols();
+    axpy(mat.data() + r1 * n + colBegin, mat.data() + r0 * n + colBegin, n - colBegin, alpha);
+}
+
+template <class T>
+void Kernels::scaleRow(Matrix<T>& mat, T alpha, size_t r, size_t colBegin)
+{
+    if (r >= mat.rows() || colBegin > mat.cols())
+        throw InvalidInputException();
+
+    const size_t n = mat.cols();
+    scale(mat.data() + r * n + colBegin, n - colBegin, alpha);
+}
+
+inline void Kernels::gemmNT(const Matrix<double>& a, const Matrix<double>& b, Matrix<double>& c, double alpha, size_t nbrOfThreads)
+{
+    const size_t m = a.rows();
+    const size_t k = a.cols();
+    const size_t n = b.rows();
+    if (b.cols() != k || c.rows() != m || c.cols() != n)
+        throw InvalidInputException();
+
+    const size_t tile = 256;
+    auto worker = [&](size_t r0, size_t r1) {
+        for (size_t t0 = 0; t0 < k; t0 += tile)
+        {
+            size_t len = std::min(tile, k - t0);
+            for (size_t i = r0; i < r1; i++)
+            {
+                const double* ai = a.data() + i * k + t0;
+                double*       ci = c.data() + i * n;
+                for (size_t j = 0; j < n; j++)
+                    ci[j] += alpha * dot(ai, b.data() + j * k + t0, len);
+            }
+        }
+    };
+
+    size_t minChunk = std::max<size_t>(1, ParallelGrainSize / std::max<size_t>(1, n * k));
+    Parallel::forRange(0, m, worker, nbrOfThreads, minChunk);
+}
+
+inline void Kernels::gemmTN(const Matrix<double>& a, const Matrix<double>& b, Matrix<double>& c, double alpha, size_t nbrOfThreads)
+{
+    const size_t k = a.rows();
+    const size_t m = a.cols();
+    const size_t n = b.cols();
+    if (b.rows() != k || c.rows() != m || c.cols() != n)
+        throw InvalidInputException();
+
+    const size_t tile = 512;
+    auto worker = [&](size_t c0, size_t c1) {
+        for (size_t t0 = c0; t0 < c1; t0 += tile)
+        {
+            size_t len = std::min(tile, c1 - t0);
+            for (size_t r = 0; r < k; r++)
+            {
+                const double* ar = a.data() + r * m;
+                const double* br = b.data() + r * n + t0;
+                for (size_t i = 0; i < m; i++)
+                {
+                    if (ar[i] != 0.0)
+                        axpy(c.data() + i * n + t0, br, len, alpha * ar[i]);
+                }
+            }
+        }
+    };
+
+    size_t minChunk = std::max<size_t>(1, ParallelGrainSize / std::max<size_t>(1, m * k));
+    Parallel::forRange(0, n, worker, nbrOfThreads, minChunk);
+}
+
+template <class T>
+void Kernels::eliminateRows(Matrix<T>& mat, size_t pivotRow, const std::vector<size_t>& rows, const std::vector<T>& factors,
+                            size_t colBegin, size_t nbrOfThreads)
+{
+    if (rows.size() != factors.size() || pivotRow >= mat.rows() || colBegin > mat.cols())
+        throw InvalidInputException();
+
+    const size_t n      = mat.cols();
+    const size_t length = n - colBegin;
+    T*           base   = mat.data();
+    const T*     pivot  = base + pivotRow * n + colBegin;
+
+    auto worker = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            axpy(base + rows[i] * n + colBegin, pivot, length, factors[i]);
+    };
+
+    size_t minChunk = std::max<size_t>(1, ParallelGrainSize / std::max<size_t>(1, length));
+    Parallel::forRange(0, rows.size(), worker, nbrOfThreads, minChunk);
+}
+
+#endif //MY_KERNELS_H
@@ -361,12 +361,14 @@ public:
     void setColumn(size_t colIdx, const Matrix<T>& col);
 
     /**
-     * Compute the rank of the matrix, the number of
-     * linearly independant rows.
-     * http://stattrek.com/matrix-algebra/matrix-rank.aspx
+     * Compute the numerical rank of the matrix, the number of
+     * linearly independant rows. A rank revealing QR decomposition
+     * is used, see Decomposition::qrColumnPivoting.
+     * @param tolerance Magnitude below which a diagonal element of R counts as zero.
+     *                  A negative value selects max(m,n) * eps * |R(0,0)|.
      * @return Rank.
      */
-    size_t getRank() const;
+    size_t getRank(double tolerance = -1.0) const;
 
     /**
      * Returns the inverse of this matrix.
@@ -504,23 +506,37 @@ public:
 
     /**
      * Computes the Euclidean length of a vector. If this
-     * is a matrix, it computes the maximum of the matrix.
-     * @return Infinity norm
+     * is a matrix, it computes the largest singular value,
+     * see Decomposition::singularValues. Estimation::normL2
+     * is a cheaper estimate for large matrices.
+     * @return L2 norm
      */
     double normL2() const;
 
     /**
-     * Computes the L1 norm condition number.
+     * Computes the L1 norm condition number. The norm of the
+     * inverse is estimated from a LU decomposition, see
+     * Estimation::conditionNumberL1.
      * @return L1 condition number
      */
     double conditionNumberL1() const;
 
     /**
-     * Computes the infinity norm condition number.
+     * Computes the infinity norm condition number. The norm of the
+     * inverse is estimated from a LU decomposition, see
+     * Estimation::conditionNumberInf.
      * @return Infinity condition number
      */
     double conditionNumberInf() const;
 
+    /**
+     * Computes the L2 norm condition number, the ratio of the largest
+     * and the smallest singular value. Only the singular values are
+     * computed, see Decomposition::singularValues.
+     * @return L2 condition number, infinity if the matrix is singular.
+     */
+    double conditionNumberL2() const;
+
     /**
      * Returns a matrix with absolute
      * values (all values are positive).
@@ -1412,27 +1428,6 @@ typedef std::shared_ptr<Matrix<double>> MatrixDSP;
 
 #include "transformation.hpp"
 
-template <class T>
-size_t Matrix<T>::getRank() const
-{
-    Matrix<double> echelonMat = Transformation::echelon(*this);
-
-    // count numbers of non zero rows
-    Matrix<double> zeroRow(1, cols());
-    zeroRow.fill(0.0);
-
-    size_t rank = 0;
-    for (size_t i = 0; i < rows(); i++)
-    {
-        Matrix<double> cRow = echelonMat.row(i);
-        if (cRow.compare(zeroRow))
-            break;
-        else
-            rank++;
-    }
-
-    return rank;
-}
 template <class T>
 Matrix<double> Matrix<T>::inverted() const
 {
@@ -1447,24 +1442,28 @@ Matrix<double> Matrix<T>::inverted() const
         throw ZeroDeterminantException();
     }
 
-    std::vector<Matrix<double>> ops;
-    Transformation::reduced_echelon(*this, ops);
+    // abs-max pivoting avoids dividing by tiny pivots, e.g. cos(pi/2) in rotations
+    std::vector<Multiplier::RowOperation> ops;
+    Transformation::reduced_echelon(*this, ops, true);
 
+    // The product of all Echelon operators is the inverse. It is built
+    // by applying the operators one after the other to the identity.
+    // http://stattrek.com/matrix-algebra/how-to-find-inverse.aspx
     Matrix<double> inv = Matrix<double>(m_rows, m_cols);
     inv.setToIdentity();
-
-    // multiply Echelon operators in reverse order
-    // http://stattrek.com/matrix-algebra/how-to-find-inverse.aspx
-    while (!ops.empty())
-    {
-        inv = inv * ops.back();
-        ops.pop_back();
-    }
+    Multiplier::apply(ops, inv);
 
     return inv;
 }
 
 #include "decomposition.hpp"
+#include "estimation.hpp"
+
+template <class T>
+size_t Matrix<T>::getRank(double tolerance) const
+{
+    return Decomposition::qrColumnPivoting(*this, tolerance, false).Rank;
+}
 
 template <class T>
 double Matrix<T>::determinant() const
@@ -1913,11 +1912,10 @@ double Matrix<T>::normL2() const
     }
     else
     {
-        // if matrix -> max singular value
-        Decomposition::SVDResult svdR = Decomposition::svd(*this);
-
-        auto max = svdR.S.max();
-        normRet  = std::get<2>(max);
+        // if matrix -> max singular value, without computing U and V
+        std::vector<double> s = Decomposition::singularValues(*this);
+        if (!s.empty())
+            normRet = s.front();
     }
 
     return normRet;
@@ -1951,25 +1949,32 @@ Matrix<T> Matrix<T>::repMat(size_t rowDirection, size_t columnDirection) const
 template <class T>
 double Matrix<T>::conditionNumberL1() const
 {
-    Matrix<T> invMat = this->inverted();
+    if (m_rows != m_cols)
+        throw SquareMatrixException();
 
-    double n  = normL1();
-    double ni = invMat.normL1();
-    return n * ni;
+    return Estimation::conditionNumberL1(*this).Value;
 }
 
-/**
- * Computes the infinity norm condition number.
- * @return Infinity condition number
- */
 template <class T>
 double Matrix<T>::conditionNumberInf() const
 {
-    Matrix<T> invMat = this->inverted();
+    if (m_rows != m_cols)
+        throw SquareMatrixException();
+
+    return Estimation::conditionNumberInf(*this).Value;
+}
+
+template <class T>
+double Matrix<T>::conditionNumberL2() const
+{
+    std::vector<double> s = Decomposition::singularValues(*this);
+    if (s.empty())
+        return 0.0;
+
+    if (s.back() == 0.0)
+        return std::numeric_limits<double>::infinity();
 
-    double n  = normInf();
-    double ni = invMat.normInf();
-    return n * ni;
+    return s.front() / s.back();
 }
 
 
@@ -26,6 +26,7 @@
 
 #include "matrix.hpp"
 #include "exceptions.hpp"
+#include "smalldecomposition.hpp"
 
 /**
  * This class represents a 4x4 double matrix. This kind
@@ -283,6 +284,41 @@ public:
      */
     template <typename R, typename Q>
     static double computeTransformationError(const Matrix<R>& setA, const Matrix<Q>& setB, const Matrix4x4& t);
+
+    /**
+     * Finds the rigid transformations between many pairs of corresponding
+     * point sets, see findRigidTransformation. The cross-covariance matrices
+     * of a chunk of pairs are decomposed together by SmallDecomposition::svd3x3Batch
+     * and the chunks are split onto threads.
+     * @param setsA Point sets A (3 x n_i matrices)
+     * @param setsB Point sets B, corresponding to setsA
+     * @param errors On return, this holds the registration error of each pair.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Rigid transformations
+     */
+    template <typename R, typename Q>
+    static std::vector<Matrix4x4> findRigidTransformations(const std::vector<Matrix<R>>& setsA, const std::vector<Matrix<Q>>& setsB,
+                                                           std::vector<double>& errors, size_t nbrOfThreads = 0);
+
+    /**
+     * Writes the rigid transformation with rotation V * U' and translation
+     * centerB - V * U' * centerA into the upper 3 x 4 part of t. U and V are the
+     * rotations of the SVD H = U * S * V' of the cross-covariance of two point
+     * sets, see findRigidTransformation.
+     * @param u Rotation U (3 x 3, row major)
+     * @param v Rotation V (3 x 3, row major)
+     * @param centerA Centroid of point set A
+     * @param centerB Centroid of point set B
+     * @param t Row major output with 4 columns and at least 3 rows, e.g. Matrix4x4::data()
+     */
+    static void composeRigidTransformation(const double* u, const double* v, const double* centerA, const double* centerB, double* t);
+
+private:
+    // Centroids and cross-covariance H (row major) of the point sets a and b, given by
+    // 3 rows of length n. One sweep over the points: the sums are taken relative to the
+    // first points, which avoids cancellation of points far from the origin.
+    template <typename R, typename Q>
+    static void crossCovariance(const Matrix<R>& a, const Matrix<Q>& b, double* h, double* centerA, double* centerB);
 };
 
 template <class R>
@@ -303,68 +339,77 @@ Matrix4x4::Matrix4x4(const Matrix<R>& mat)
 }
 
 template <typename R, typename Q>
-Matrix4x4 Matrix4x4::findRigidTransformation(const Matrix<R>& setA, const Matrix<Q>& setB, double& error)
+void Matrix4x4::crossCovariance(const Matrix<R>& a, const Matrix<Q>& b, double* h, double* centerA, double* centerB)
 {
-    // input to double
-    Matrix<double> dA(setA);
-    Matrix<double> dB(setB);
-
-    // at least 3 point correspondences
-    if (dA.cols() != dB.cols() || dA.cols() < 3 || dA.rows() != 3 || dB.rows() != 3)
-        throw InvalidInputException();
-
-    size_t n = dA.cols();
-
-    // compute centers
-    Matrix<double> cA = dA.sumC() * (1.0 / n);
-    Matrix<double> cB = dB.sumC() * (1.0 / n);
-
-    // centered point sets
-    Matrix<double> qA = dA - cA.repMat(1, n);
-    Matrix<double> qB = dB - cB.repMat(1, n);
-
-    // compute rotation
-    Matrix<double> h = Matrix<double>(3, 3);
-    h.fill(0.0);
-
+    const size_t n  = a.cols();
+    const R*     ax = a.data();
+    const R*     ay = ax + a.cols();
+    const R*     az = ay + a.cols();
+    const Q*     bx = b.data();
+    const Q*     by = bx + b.cols();
+    const Q*     bz = by + b.cols();
+
+    double shiftA[3] = {static_cast<double>(ax[0]), static_cast<double>(ay[0]), static_cast<double>(az[0])};
+    double shiftB[3] = {static_cast<double>(bx[0]), static_cast<double>(by[0]), static_cast<double>(bz[0])};
+
+    double sumA[3] = {0.0, 0.0, 0.0};
+    double sumB[3] = {0.0, 0.0, 0.0};
+    std::fill(h, h + 9, 0.0);
     for (size_t k = 0; k < n; k++)
-        h = h + (qA.column(k) * qB.column(k).transpose());
-
-    Decomposition::SVDResult dec = Decomposition::svdGolubKahan(h);
-
-    Matrix<double> rotation = dec.V * dec.U.transpose();
-
-    // If necessary, fix rotation matrix -> reflection
-    double det = rotation.determinant();
+    {
+        double pa[3] = {ax[k] - shiftA[0], ay[k] - shiftA[1], az[k] - shiftA[2]};
+        double pb[3] = {bx[k] - shiftB[0], by[k] - shiftB[1], bz[k] - shiftB[2]};
+        for (size_t i = 0; i < 3; i++)
+        {
+            sumA[i] += pa[i];
+            sumB[i] += pb[i];
+            h[i * 3 + 0] += pa[i] * pb[0];
+            h[i * 3 + 1] += pa[i] * pb[1];
+            h[i * 3 + 2] += pa[i] * pb[2];
+        }
+    }
 
-    if (std::abs(1.0 - std::abs(det)) > 0.001)
+    // H = sum (a - cA) * (b - cB)' = sum a * b' - n * cA * cB'
+    for (size_t i = 0; i < 3; i++)
     {
-        h.save("failingsvd.mat");
-        throw NoRotationMatrixException();
+        for (size_t j = 0; j < 3; j++)
+            h[i * 3 + j] -= sumA[i] * sumB[j] / n;
+
+        centerA[i] = shiftA[i] + sumA[i] / n;
+        centerB[i] = shiftB[i] + sumB[i] / n;
     }
+}
 
-    if (det < 0.0)
+inline void Matrix4x4::composeRigidTransformation(const double* u, const double* v, const double* centerA, const double* centerB, double* t)
+{
+    for (size_t i = 0; i < 3; i++)
     {
-        //std::cout << "Rotation is a reflection (determinant = " << det << "). Let's fix it!" << std::endl;
+        for (size_t j = 0; j < 3; j++)
+            t[i * 4 + j] = v[i * 3 + 0] * u[j * 3 + 0] + v[i * 3 + 1] * u[j * 3 + 1] + v[i * 3 + 2] * u[j * 3 + 2];
+    }
 
-        Matrix<double> vModified = dec.V;
-        vModified.setColumn(2, vModified.column(2) * (-1.0));
+    for (size_t i = 0; i < 3; i++)
+        t[i * 4 + 3] = centerB[i] - (t[i * 4] * centerA[0] + t[i * 4 + 1] * centerA[1] + t[i * 4 + 2] * centerA[2]);
+}
 
-        rotation = vModified * dec.U.transpose();
+template <typename R, typename Q>
+Matrix4x4 Matrix4x4::findRigidTransformation(const Matrix<R>& setA, const Matrix<Q>& setB, double& error)
+{
+    // at least 3 point correspondences
+    if (setA.cols() != setB.cols() || setA.cols() < 3 || setA.rows() != 3 || setB.rows() != 3)
+        throw InvalidInputException();
 
-        // Modified rotation determinant should be positive... actually 1
-        double detFixed = rotation.determinant();
-        if (detFixed < 0.0)
-            throw NoRotationMatrixException();
-    }
+    double h[9], centerA[3], centerB[3];
+    crossCovariance(setA, setB, h, centerA, centerB);
 
-    // compose resulting transformation
-    Matrix4x4 res = Matrix4x4();
-    res.setRotation(rotation);
-    Matrix<double> translation = cB - (rotation * cA);
-    res.setTranslation(translation);
+    // H = U * S * V' with rotations U and V: V * U' is the rotation, which
+    // maximizes the correlation, and no reflection needs to be fixed
+    double u[9], s[3], v[9];
+    SmallDecomposition::svd3x3(h, u, s, v, true);
 
-    error = computeTransformationError(dA, dB, res);
+    Matrix4x4 res;
+    composeRigidTransformation(u, v, centerA, centerB, res.data());
+    error = computeTransformationError(setA, setB, res);
 
     return res;
 }
@@ -379,24 +424,74 @@ double Matrix4x4::computeTransformationError(const Matrix<R>& setA, const Matrix
     if (setA.rows() < 3)
         throw InvalidInputException();
 
-    size_t n = setA.cols();
-
-    // works for homogene and non-homogene coordinates
-    Matrix<double> setA_h(4, n);
-    setA_h.fill(1.0);
-    setA_h.setSubMatrix(0, 0, setA);
-
-    // transform setA and compute difference to setB
-    Matrix<double> tDiff = setB - (t * setA_h).subMatrix(0, 0, 3, n);
+    // works for homogene and non-homogene coordinates: only the first 3 rows are used
+    const size_t  n  = setA.cols();
+    const R*      ax = setA.data();
+    const R*      ay = ax + n;
+    const R*      az = ay + n;
+    const Q*      bx = setB.data();
+    const Q*      by = bx + n;
+    const Q*      bz = by + n;
+    const double* m  = t.data();
 
     // compute average L2 error
     double error = 0.0;
     for (size_t k = 0; k < n; k++)
-        error += tDiff.column(k).norm();
+    {
+        double x  = static_cast<double>(ax[k]);
+        double y  = static_cast<double>(ay[k]);
+        double z  = static_cast<double>(az[k]);
+        double dx = bx[k] - (m[0] * x + m[1] * y + m[2] * z + m[3]);
+        double dy = by[k] - (m[4] * x + m[5] * y + m[6] * z + m[7]);
+        double dz = bz[k] - (m[8] * x + m[9] * y + m[10] * z + m[11]);
+        error += std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
 
     error = error / n;
 
     return error;
 }
 
+template <typename R, typename Q>
+std::vector<Matrix4x4> Matrix4x4::findRigidTransformations(const std::vector<Matrix<R>>& setsA, const std::vector<Matrix<Q>>& setsB,
+                                                           std::vector<double>& errors, size_t nbrOfThreads)
+{
+    const size_t count = setsA.size();
+    if (setsB.size() != count)
+        throw InvalidInputException();
+
+    for (size_t p = 0; p < count; p++)
+    {
+        const Matrix<R>& a = setsA[p];
+        const Matrix<Q>& b = setsB[p];
+        if (a.cols() != b.cols() || a.cols() < 3 || a.rows() != 3 || b.rows() != 3)
+            throw InvalidInputException();
+    }
+
+    std::vector<Matrix4x4> res(count);
+    errors.assign(count, 0.0);
+
+    auto worker = [&](size_t p0, size_t p1) {
+        size_t              len = p1 - p0;
+        std::vector<double> h(9 * len), centerA(3 * len), centerB(3 * len);
+        std::vector<double> u(9 * len), s(3 * len), v(9 * len);
+
+        for (size_t p = p0; p < p1; p++)
+            crossCovariance(setsA[p], setsB[p], &h[9 * (p - p0)], &centerA[3 * (p - p0)], &centerB[3 * (p - p0)]);
+
+        SmallDecomposition::svd3x3Batch(h.data(), u.data(), s.data(), v.data(), len, true, 1);
+
+        for (size_t p = p0; p < p1; p++)
+        {
+            size_t q = p - p0;
+            composeRigidTransformation(&u[9 * q], &v[9 * q], &centerA[3 * q], &centerB[3 * q], res[p].data());
+            errors[p] = computeTransformationError(setsA[p], setsB[p], res[p]);
+        }
+    };
+
+    Parallel::forRange(0, count, worker, nbrOfThreads, 256);
+
+    return res;
+}
+
 #endif //MY_AFFINE_H
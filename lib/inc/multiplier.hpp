@@ -31,6 +31,57 @@
 class Multiplier
 {
 public:
+    /**
+     * Compact record of one elementary row operation. Instead of
+     * a dense n x n multiplier matrix, only the type, the involved
+     * rows and the factor are stored.
+     */
+    struct RowOperation
+    {
+        enum Type
+        {
+            SwapRows,     // swap rows R0 and R1
+            MultiplyRow,  // multiply row R0 by Factor
+            AddProductRow // add Factor * row R0 to row R1
+        };
+
+        RowOperation(Type type, size_t r0, size_t r1, double factor)
+        : OpType(type), R0(r0), R1(r1), Factor(factor)
+        {
+        }
+
+        Type   OpType;
+        size_t R0;
+        size_t R1;
+        double Factor;
+    };
+
+    /**
+     * Applies the row operation to the matrix mat. This is
+     * equivalent to mat = toMatrix(op, mat.rows()) * mat, but
+     * costs only O(n) for n columns.
+     * @param op Row operation.
+     * @param mat Matrix to modify.
+     */
+    template <class T>
+    static void apply(const RowOperation& op, Matrix<T>& mat);
+
+    /**
+     * Applies a sequence of row operations, first to last, to the matrix mat.
+     * @param ops Row operations.
+     * @param mat Matrix to modify.
+     */
+    template <class T>
+    static void apply(const std::vector<RowOperation>& ops, Matrix<T>& mat);
+
+    /**
+     * Expands the row operation to its m x m L-multiplier matrix.
+     * @param op Row operation.
+     * @param m Number of rows of the matrix the operation is applied to.
+     * @return Multiplier matrix.
+     */
+    static Matrix<double> toMatrix(const RowOperation& op, size_t m);
+
     /**
      * Get the matrix L-multiplier, which swaps the rows r0 and r1.
      * @param mat
@@ -122,4 +173,56 @@ Matrix<T> Multiplier::multiplyRow(const Matrix<T>& mat, T factor, size_t r)
     return mulOp;
 }
 
+template <class T>
+void Multiplier::apply(const RowOperation& op, Matrix<T>& mat)
+{
+    if (std::max(op.R0, op.R1) >= mat.rows())
+    {
+        std::cout << "row index exceeds matrix size";
+        std::exit(-1);
+    }
+
+    switch (op.OpType)
+    {
+        case RowOperation::SwapRows:
+            mat.swapRows(op.R0, op.R1);
+            break;
+
+        case RowOperation::MultiplyRow:
+            for (size_t n = 0; n < mat.cols(); n++)
+                mat(op.R0, n) = static_cast<T>(mat(op.R0, n) * op.Factor);
+            break;
+
+        case RowOperation::AddProductRow:
+            for (size_t n = 0; n < mat.cols(); n++)
+                mat(op.R1, n) = static_cast<T>(mat(op.R1, n) + mat(op.R0, n) * op.Factor);
+            break;
+    }
+}
+
+template <class T>
+void Multiplier::apply(const std::vector<RowOperation>& ops, Matrix<T>& mat)
+{
+    for (const RowOperation& op : ops)
+        apply(op, mat);
+}
+
+inline Matrix<double> Multiplier::toMatrix(const RowOperation& op, size_t m)
+{
+    Matrix<double> dummy(m, 0); // only the number of rows matters
+
+    switch (op.OpType)
+    {
+        case RowOperation::SwapRows:
+            return swapRow(dummy, op.R0, op.R1);
+
+        case RowOperation::MultiplyRow:
+            return multiplyRow(dummy, op.Factor, op.R0);
+
+        case RowOperation::AddProductRow:
+        default:
+            return addProductOfRow(dummy, op.Factor, op.R0, op.R1);
+    }
+}
+
 #endif //MY_MULTIPLIER_H
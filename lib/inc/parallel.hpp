@@ -0,0 +1,276 @@
+/****************************************************************************
+** Copyright (c) 2019 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef MY_PARALLEL_H
+#define MY_PARALLEL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+#ifdef THREADSTATISTICSEIDLA
+#include <mutex>
+#endif
+
+/**
+ * Small helper to distribute independent work onto std::threads.
+ */
+class Parallel
+{
+public:
+    /**
+     * Number of threads used if the caller does not specify it.
+     * @return Number of hardware threads, at least 1.
+     */
+    static size_t defaultNbrOfThreads()
+    {
+        size_t n = defaultOverride().load();
+        if (n > 0)
+            return n;
+
+        n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    /**
+     * Overrides defaultNbrOfThreads() while the object lives and restores the
+     * previous value when it is destroyed. This lets tests run the parallel
+     * paths of functions without a thread parameter on machines with few cores.
+     * The value is shared by all threads, so a scope should only be opened
+     * while no other thread runs parallel functions.
+     */
+    class DefaultNbrOfThreadsScope
+    {
+    public:
+        /**
+         * @param nbrOfThreads Number of threads. 0 means hardware threads.
+         */
+        explicit DefaultNbrOfThreadsScope(size_t nbrOfThreads)
+        : m_previous(defaultOverride().exchange(nbrOfThreads))
+        {
+        }
+
+        ~DefaultNbrOfThreadsScope()
+        {
+            defaultOverride().store(m_previous);
+        }
+
+        DefaultNbrOfThreadsScope(const DefaultNbrOfThreadsScope&) = delete;
+        DefaultNbrOfThreadsScope& operator=(const DefaultNbrOfThreadsScope&) = delete;
+
+    private:
+        size_t m_previous;
+    };
+
+#ifdef THREADSTATISTICSEIDLA
+    /**
+     * Observes the worker threads started by forRange while the object lives.
+     * Tests use it to check that nested parallel calls stay within their
+     * thread budget. Only compiled with THREADSTATISTICSEIDLA, so programs
+     * do not pay for the bookkeeping. Each scope counts the workers started
+     * after its construction, so several scopes may be alive at once.
+     */
+    class ThreadStatisticScope
+    {
+    public:
+        ThreadStatisticScope()
+        : m_started(0), m_running(0), m_peak(0)
+        {
+            std::lock_guard<std::mutex> guard(statisticLock());
+            scopes().push_back(this);
+        }
+
+        ~ThreadStatisticScope()
+        {
+            std::lock_guard<std::mutex> guard(statisticLock());
+            scopes().erase(std::find(scopes().begin(), scopes().end(), this));
+        }
+
+        /**
+         * @return Number of worker threads started since construction.
+         */
+        size_t startedThreads() const
+        {
+            std::lock_guard<std::mutex> guard(statisticLock());
+            return m_started;
+        }
+
+        /**
+         * @return Maximum number of threads started since construction that
+         *         ran at the same time, plus the calling thread.
+         */
+        size_t peakThreads() const
+        {
+            std::lock_guard<std::mutex> guard(statisticLock());
+            return m_peak + 1;
+        }
+
+        ThreadStatisticScope(const ThreadStatisticScope&) = delete;
+        ThreadStatisticScope& operator=(const ThreadStatisticScope&) = delete;
+
+    private:
+        friend class Parallel;
+
+        size_t m_started;
+        size_t m_running;
+        size_t m_peak;
+    };
+#endif
+
+    /**
+     * Splits the index range [begin, end) into contiguous chunks and calls
+     * func(chunkBegin, chunkEnd) once per chunk. The chunks are processed
+     * concurrently, the last one by the calling thread. An exception thrown
+     * in any chunk is rethrown after all threads have joined.
+     * @param begin First index.
+     * @param end One past the last index.
+     * @param func Functor with signature void(size_t, size_t).
+     * @param nbrOfThreads Maximum number of threads. 0 means defaultNbrOfThreads().
+     * @param minChunk Minimum number of indices per chunk.
+     */
+    template <class F>
+    static void forRange(size_t begin, size_t end, F func, size_t nbrOfThreads = 0, size_t minChunk = 1)
+    {
+        if (end <= begin)
+            return;
+
+        if (nbrOfThreads == 0)
+            nbrOfThreads = defaultNbrOfThreads();
+
+        size_t length  = end - begin;
+        size_t nChunks = std::max<size_t>(1, std::min(nbrOfThreads, length / std::max<size_t>(1, minChunk)));
+
+        if (nChunks == 1)
+        {
+            func(begin, end);
+            return;
+        }
+
+        // rounding the chunk size up can leave trailing chunks empty,
+        // e.g. 9 indices on 8 threads. Drop them so every chunk is non-empty.
+        size_t chunkSize = (length + nChunks - 1) / nChunks;
+        nChunks          = (length + chunkSize - 1) / chunkSize;
+
+        std::vector<std::thread>        workers;
+        std::vector<std::exception_ptr> errors(nChunks);
+        workers.reserve(nChunks - 1);
+
+        for (size_t c = 0; c + 1 < nChunks; c++)
+        {
+            size_t cBegin = begin + c * chunkSize;
+            size_t cEnd   = std::min(end, cBegin + chunkSize);
+            workers.push_back(std::thread([&func, &errors, c, cBegin, cEnd]() {
+                WorkerStatistic statistic;
+                try
+                {
+                    func(cBegin, cEnd);
+                }
+                catch (...)
+                {
+                    errors[c] = std::current_exception();
+                }
+            }));
+        }
+
+        // the calling thread does the last chunk
+        try
+        {
+            func(begin + (nChunks - 1) * chunkSize, end);
+        }
+        catch (...)
+        {
+            errors[nChunks - 1] = std::current_exception();
+        }
+
+        for (std::thread& t : workers)
+            t.join();
+
+        for (const std::exception_ptr& e : errors)
+        {
+            if (e)
+                std::rethrow_exception(e);
+        }
+    }
+
+private:
+#ifdef THREADSTATISTICSEIDLA
+    static std::mutex& statisticLock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::vector<ThreadStatisticScope*>& scopes()
+    {
+        static std::vector<ThreadStatisticScope*> s;
+        return s;
+    }
+
+    // Registers a worker with the scopes alive at its start.
+    class WorkerStatistic
+    {
+    public:
+        WorkerStatistic()
+        {
+            std::lock_guard<std::mutex> guard(statisticLock());
+            m_observers = scopes();
+            for (ThreadStatisticScope* s : m_observers)
+            {
+                s->m_started++;
+                s->m_running++;
+                s->m_peak = std::max(s->m_peak, s->m_running);
+            }
+        }
+
+        ~WorkerStatistic()
+        {
+            std::lock_guard<std::mutex> guard(statisticLock());
+            for (ThreadStatisticScope* s : m_observers)
+            {
+                if (std::find(scopes().begin(), scopes().end(), s) != scopes().end())
+                    s->m_running--;
+            }
+        }
+
+    private:
+        std::vector<ThreadStatisticScope*> m_observers;
+    };
+#else
+    struct WorkerStatistic
+    {
+        WorkerStatistic()
+        {
+        }
+    };
+#endif
+
+    static std::atomic<size_t>& defaultOverride()
+    {
+        static std::atomic<size_t> nbrOfThreads(0);
+        return nbrOfThreads;
+    }
+};
+
+#endif //MY_PARALLEL_H
@@ -26,9 +26,11 @@
 
 #include "matrix.hpp"
 #include "exceptions.hpp"
+#include "sample.hpp"
 
 #include <vector>
 #include <algorithm>
+#include <cmath>
 
 
 /**
@@ -57,6 +59,104 @@ public:
         return accum * (1.0 / n);
     }
 
+    /**
+     * Compute the unbiased sample covariance.
+     * @param samples Vector of samples, at least two.
+     * @return Sample covariance (d x d).
+     */
+    static Matrix<double> covariance(const std::vector<SamplePtr>& samples)
+    {
+        size_t n = samples.size();
+        if(n < 2)
+            throw EmptyContainerException();
+
+        Matrix<double> mu = mean(samples);
+
+        // centered samples as columns
+        Matrix<double> centered = centeredColumns(samples, mu);
+
+        Matrix<double> cov = centered * centered.transpose();
+        return cov * (1.0 / (n - 1));
+    }
+
+    /**
+     * Compute the Mahalanobis distance of each sample to a normal distribution.
+     * The covariance is Cholesky decomposed once and all samples are
+     * solved together.
+     * @param samples Vector of samples.
+     * @param mean Distribution mean (d x 1).
+     * @param covariance Symmetric positive definite distribution covariance (d x d).
+     * @return Mahalanobis distance per sample.
+     */
+    static std::vector<double> mahalanobisDistances(const std::vector<SamplePtr>& samples, const Matrix<double>& mean, const Matrix<double>& covariance)
+    {
+        Matrix<double> l = Decomposition::cholesky(covariance);
+
+        std::vector<double> dist;
+        std::vector<double> squared = whitenedSquaredNorms(samples, mean, l);
+        for(double sq: squared)
+            dist.push_back(std::sqrt(sq));
+
+        return dist;
+    }
+
+    /**
+     * Compute the log-likelihood of the samples under a normal distribution.
+     * @param samples Vector of samples.
+     * @param mean Distribution mean (d x 1).
+     * @param covariance Symmetric positive definite distribution covariance (d x d).
+     * @return Sum of the log-densities of all samples.
+     */
+    static double logLikelihoodNormal(const std::vector<SamplePtr>& samples, const Matrix<double>& mean, const Matrix<double>& covariance)
+    {
+        Matrix<double> l = Decomposition::cholesky(covariance);
+
+        double d = static_cast<double>(mean.rows());
+        double logNormalization = d * std::log(2.0 * M_PI) + Decomposition::choleskyLogDeterminant(l);
+
+        double logLikelihood = 0.0;
+        std::vector<double> squared = whitenedSquaredNorms(samples, mean, l);
+        for(double sq: squared)
+            logLikelihood -= 0.5 * (logNormalization + sq);
+
+        return logLikelihood;
+    }
+
+private:
+
+    static Matrix<double> centeredColumns(const std::vector<SamplePtr>& samples, const Matrix<double>& mean)
+    {
+        size_t d = mean.rows();
+        Matrix<double> centered(d, samples.size());
+        for(size_t k = 0; k < samples.size(); k++)
+        {
+            const Matrix<double>& x = samples.at(k)->m_data;
+            if(x.rows() != d || x.cols() != 1)
+                throw InvalidInputException();
+
+            for(size_t i = 0; i < d; i++)
+                centered(i, k) = x(i, 0) - mean(i, 0);
+        }
+
+        return centered;
+    }
+
+    // ||L^-1 (x - mean)||^2 per sample
+    static std::vector<double> whitenedSquaredNorms(const std::vector<SamplePtr>& samples, const Matrix<double>& mean, const Matrix<double>& l)
+    {
+        if(samples.empty())
+            throw EmptyContainerException();
+
+        Matrix<double> z = centeredColumns(samples, mean);
+        Decomposition::triangularSolveInPlace(l, z, true);
+
+        std::vector<double> squared(samples.size(), 0.0);
+        for(size_t i = 0; i < z.rows(); i++)
+            for(size_t k = 0; k < z.cols(); k++)
+                squared[k] += z(i, k) * z(i, k);
+
+        return squared;
+    }
 
 };
 
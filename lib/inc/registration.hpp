@@ -0,0 +1,745 @@
+/****************************************************************************
+** Copyright (c) 2019 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef MY_REGISTRATION_H
+#define MY_REGISTRATION_H
+
+#include "matrix4x4.hpp"
+#include "smalldecomposition.hpp"
+#include "datastructures.hpp"
+#include "parallel.hpp"
+
+#include <smmintrin.h> // SSE4
+#include <random>
+#include <numeric>
+#include <limits>
+
+/**
+ * Registration of 3D point sets by rigid transformations: robust against
+ * wrong correspondences, or without correspondences by iterative closest
+ * points.
+ */
+class Registration
+{
+public:
+    struct RansacResult
+    {
+        RansacResult(Matrix4x4 transformation, std::vector<size_t> inliers, double error, size_t nbrOfHypotheses)
+        : Transformation(transformation), Inliers(inliers), Error(error), NbrOfHypotheses(nbrOfHypotheses)
+        {
+        }
+        Matrix4x4           Transformation;  // Maps set A onto set B, refined on the inliers
+        std::vector<size_t> Inliers;         // Indices of the inlier correspondences in ascending order, empty if none was found
+        double              Error;           // Average error of the inliers, see Matrix4x4::computeTransformationError
+        size_t              NbrOfHypotheses; // Number of evaluated minimal hypotheses
+    };
+
+    /**
+     * Finds the rigid transformation between two corresponding 3D point sets,
+     * of which some correspondences are wrong (RANSAC). Hypotheses of three
+     * random correspondences are solved in batches by SmallDecomposition::svd3x3Batch
+     * and scored in parallel by counting the correspondences, which they map
+     * closer than inlierThreshold. The search ends as soon as an all inlier
+     * sample was drawn with the probability confidence. The transformation
+     * of the best hypothesis is refined by a least squares fit to its inliers.
+     * @param setA Point set A (3 x n matrix)
+     * @param setB Point set B (3 x n matrix)
+     * @param inlierThreshold Maximum distance of an inlier.
+     * @param confidence Probability to find the best transformation.
+     * @param maxHypotheses Maximum number of hypotheses.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Transformation and inliers
+     */
+    template <typename R, typename Q>
+    static RansacResult ransac(const Matrix<R>& setA, const Matrix<Q>& setB, double inlierThreshold, double confidence = 0.99,
+                               size_t maxHypotheses = 10000, size_t nbrOfThreads = 0);
+
+    /**
+     * As ransac, but the samples are drawn progressively from the
+     * correspondences of highest quality first (PROSAC, Chum and Matas).
+     * If the quality ranks the inliers well, e.g. by a descriptor distance,
+     * far fewer hypotheses are needed.
+     * @param setA Point set A (3 x n matrix)
+     * @param setB Point set B (3 x n matrix)
+     * @param quality Quality of each correspondence, higher is better.
+     * @param inlierThreshold Maximum distance of an inlier.
+     * @param confidence Probability to find the best transformation.
+     * @param maxHypotheses Maximum number of hypotheses.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Transformation and inliers
+     */
+    template <typename R, typename Q>
+    static RansacResult prosac(const Matrix<R>& setA, const Matrix<Q>& setB, const std::vector<double>& quality, double inlierThreshold,
+                               double confidence = 0.99, size_t maxHypotheses = 10000, size_t nbrOfThreads = 0);
+
+    enum IcpMetric
+    {
+        PointToPoint, // Distances between corresponding points, solved by Matrix4x4::findRigidTransformation
+        PointToPlane  // Distances to the tangent planes at the target points, linearized for small rotations
+    };
+
+    struct IcpParameters
+    {
+        IcpParameters()
+        : Metric(PointToPoint), MaxDistance(std::numeric_limits<double>::infinity()), MaxIterations(30), Tolerance(1e-6),
+          NbrOfLevels(3), MaxNbrOfPoints(20000), NbrOfThreads(0)
+        {
+        }
+        IcpMetric Metric;         // Error metric
+        double    MaxDistance;    // Correspondences further apart are rejected
+        size_t    MaxIterations;  // Maximum number of iterations per level
+        double    Tolerance;      // A level ends if the transformation or, relatively, the average distance changes less than this
+        size_t    NbrOfLevels;    // Resolution levels, each with four times the source points of the one before
+        size_t    MaxNbrOfPoints; // Source points of the finest level, evenly subsampled
+        size_t    NbrOfThreads;   // Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+    };
+
+    struct IcpResult
+    {
+        IcpResult(Matrix4x4 transformation, double error, size_t nbrOfCorrespondences, size_t nbrOfIterations, bool converged)
+        : Transformation(transformation), Error(error), NbrOfCorrespondences(nbrOfCorrespondences), NbrOfIterations(nbrOfIterations),
+          Converged(converged)
+        {
+        }
+        Matrix4x4 Transformation;       // Maps the source onto the target
+        double    Error;                // Average distance of the correspondences of the last iteration
+        size_t    NbrOfCorrespondences; // Number of correspondences of the last iteration
+        size_t    NbrOfIterations;      // Iterations of all levels
+        bool      Converged;            // True if the finest level reached the tolerance
+    };
+
+    /**
+     * Aligns the source point set to the target point set by iterative
+     * closest points. Each iteration matches the source points to their
+     * nearest target points in parallel and solves the rigid transformation
+     * of these correspondences. Coarse levels use fewer source points.
+     * The tree of the target can be reused, e.g. for consecutive scans.
+     * @param source Source point set (3 x n matrix)
+     * @param target k-d tree of the target point set
+     * @param targetNormals Normals of the target points (3 x m matrix), see estimateNormals. Only needed for PointToPlane.
+     * @param initial Initial transformation of the source.
+     * @param parameters Metric, convergence and subsampling, see IcpParameters.
+     * @return Transformation, which maps the source onto the target.
+     */
+    static IcpResult icp(const Matrix<double>& source, const KdTree& target, const Matrix<double>& targetNormals, const Matrix4x4& initial,
+                         const IcpParameters& parameters = IcpParameters());
+
+    /**
+     * See icp, but the tree of the target and, for PointToPlane, its normals are computed.
+     * @param source Source point set (3 x n matrix)
+     * @param target Target point set (3 x m matrix)
+     * @param initial Initial transformation of the source.
+     * @param parameters Metric, convergence and subsampling, see IcpParameters.
+     * @return Transformation, which maps the source onto the target.
+     */
+    static IcpResult icp(const Matrix<double>& source, const Matrix<double>& target, const Matrix4x4& initial = Matrix4x4(),
+                         const IcpParameters& parameters = IcpParameters());
+
+    /**
+     * Normals of a point set: the Eigen vector of the smallest Eigen value of
+     * the covariance of the k nearest neighbours. The signs are arbitrary.
+     * @param tree k-d tree of the point set
+     * @param k Number of neighbours.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     * @return Normals (3 x n matrix)
+     */
+    static Matrix<double> estimateNormals(const KdTree& tree, size_t k = 8, size_t nbrOfThreads = 0);
+
+    /**
+     * Number of correspondences, which the transformation t maps closer
+     * than threshold: |setB - t * setA| < threshold. Vectorized with SSE.
+     * @param setA Point set A (3 x n matrix)
+     * @param setB Point set B (3 x n matrix)
+     * @param t Rigid transformation
+     * @param threshold Maximum distance of an inlier.
+     * @return Number of inliers
+     */
+    static size_t countInliers(const Matrix<double>& setA, const Matrix<double>& setB, const Matrix4x4& t, double threshold);
+
+private:
+    // Hypotheses, which are solved and scored together
+    static size_t hypothesisBatchSize()
+    {
+        return 64;
+    }
+
+    // See countInliers: a and b have 3 rows of length n, t is the row major 3 x 4 transformation.
+    static size_t countInliers(const double* a, const double* b, size_t n, const double* t, double threshold2);
+
+    // Indices of the correspondences with an error below threshold2 (squared), same arithmetic as countInliers.
+    static std::vector<size_t> collectInliers(const double* a, const double* b, size_t n, const double* t, double threshold2);
+
+    // Centroids and cross-covariance H (row major) of the three correspondences sample.
+    // Returns false if the points of A are nearly collinear.
+    static bool minimalCrossCovariance(const double* a, const double* b, size_t n, const size_t* sample, double* h, double* centerA,
+                                       double* centerB);
+
+    // Solves the symmetric positive semi-definite system a * x = b (6 x 6) by Cholesky,
+    // with a small regularization for directions, which the data does not constrain.
+    static void solveSymmetric6x6(double* a, double* b);
+
+    // Rotation by the angle |w| around the axis w (Rodrigues), row major.
+    static void rotationFromVector(const double* w, double* r);
+
+    // RANSAC core: the samples are drawn from the correspondences in order. If progressive,
+    // order is sorted by quality and the samples grow from the top (PROSAC).
+    static RansacResult robustRegistration(const Matrix<double>& a, const Matrix<double>& b, const std::vector<size_t>& order,
+                                           bool progressive, double inlierThreshold, double confidence, size_t maxHypotheses,
+                                           size_t nbrOfThreads);
+};
+
+inline size_t Registration::countInliers(const double* a, const double* b, size_t n, const double* t, double threshold2)
+{
+    const double* ax = a;
+    const double* ay = a + n;
+    const double* az = a + 2 * n;
+    const double* bx = b;
+    const double* by = b + n;
+    const double* bz = b + 2 * n;
+
+    __m128d m[12];
+    for (size_t e = 0; e < 12; e++)
+        m[e] = _mm_set1_pd(t[e]);
+    __m128d thr = _mm_set1_pd(threshold2);
+
+    size_t count = 0;
+    size_t k     = 0;
+    for (; k + 2 <= n; k += 2)
+    {
+        __m128d x  = _mm_loadu_pd(ax + k);
+        __m128d y  = _mm_loadu_pd(ay + k);
+        __m128d z  = _mm_loadu_pd(az + k);
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(bx + k), _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m[0], x), _mm_mul_pd(m[1], y)), _mm_mul_pd(m[2], z)), m[3]));
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(by + k), _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m[4], x), _mm_mul_pd(m[5], y)), _mm_mul_pd(m[6], z)), m[7]));
+        __m128d dz = _mm_sub_pd(_mm_loadu_pd(bz + k), _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m[8], x), _mm_mul_pd(m[9], y)), _mm_mul_pd(m[10], z)), m[11]));
+        __m128d d2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+        int     in = _mm_movemask_pd(_mm_cmplt_pd(d2, thr));
+        count += (in & 1) + (in >> 1);
+    }
+
+    for (; k < n; k++)
+    {
+        double dx = bx[k] - (((t[0] * ax[k] + t[1] * ay[k]) + t[2] * az[k]) + t[3]);
+        double dy = by[k] - (((t[4] * ax[k] + t[5] * ay[k]) + t[6] * az[k]) + t[7]);
+        double dz = bz[k] - (((t[8] * ax[k] + t[9] * ay[k]) + t[10] * az[k]) + t[11]);
+        count += ((dx * dx + dy * dy) + dz * dz) < threshold2 ? 1 : 0;
+    }
+
+    return count;
+}
+
+inline std::vector<size_t> Registration::collectInliers(const double* a, const double* b, size_t n, const double* t, double threshold2)
+{
+    std::vector<size_t> inliers;
+    for (size_t k = 0; k < n; k++)
+    {
+        double dx = b[k] - (((t[0] * a[k] + t[1] * a[n + k]) + t[2] * a[2 * n + k]) + t[3]);
+        double dy = b[n + k] - (((t[4] * a[k] + t[5] * a[n + k]) + t[6] * a[2 * n + k]) + t[7]);
+        double dz = b[2 * n + k] - (((t[8] * a[k] + t[9] * a[n + k]) + t[10] * a[2 * n + k]) + t[11]);
+        if (((dx * dx + dy * dy) + dz * dz) < threshold2)
+            inliers.push_back(k);
+    }
+
+    return inliers;
+}
+
+inline size_t Registration::countInliers(const Matrix<double>& setA, const Matrix<double>& setB, const Matrix4x4& t, double threshold)
+{
+    if (!Matrix<double>::equalDimension(setA, setB) || setA.rows() != 3)
+        throw InvalidInputException();
+
+    return countInliers(setA.data(), setB.data(), setA.cols(), t.data(), threshold * threshold);
+}
+
+inline bool Registration::minimalCrossCovariance(const double* a, const double* b, size_t n, const size_t* sample, double* h,
+                                                 double* centerA, double* centerB)
+{
+    double pa[3][3], pb[3][3];
+    for (size_t i = 0; i < 3; i++)
+    {
+        centerA[i] = 0.0;
+        centerB[i] = 0.0;
+        for (size_t s = 0; s < 3; s++)
+        {
+            pa[s][i] = a[i * n + sample[s]];
+            pb[s][i] = b[i * n + sample[s]];
+            centerA[i] += pa[s][i] / 3.0;
+            centerB[i] += pb[s][i] / 3.0;
+        }
+    }
+
+    for (size_t s = 0; s < 3; s++)
+    {
+        for (size_t i = 0; i < 3; i++)
+        {
+            pa[s][i] -= centerA[i];
+            pb[s][i] -= centerB[i];
+        }
+    }
+
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 3; j++)
+            h[i * 3 + j] = pa[0][i] * pb[0][j] + pa[1][i] * pb[1][j] + pa[2][i] * pb[2][j];
+
+    // the triangle of A needs an area, which is not negligible against its edges
+    double e1[3] = {pa[1][0] - pa[0][0], pa[1][1] - pa[0][1], pa[1][2] - pa[0][2]};
+    double e2[3] = {pa[2][0] - pa[0][0], pa[2][1] - pa[0][1], pa[2][2] - pa[0][2]};
+    double c[3]  = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+    double area2 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+    double edges = (e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]) * (e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]);
+    return area2 > 1e-12 * edges && edges > 0.0;
+}
+
+inline Registration::RansacResult Registration::robustRegistration(const Matrix<double>& a, const Matrix<double>& b,
+                                                                   const std::vector<size_t>& order, bool progressive,
+                                                                   double inlierThreshold, double confidence, size_t maxHypotheses,
+                                                                   size_t nbrOfThreads)
+{
+    const size_t n          = a.cols();
+    const double threshold2 = inlierThreshold * inlierThreshold;
+    if (b.cols() != n || a.rows() != 3 || b.rows() != 3 || n < 3 || !(inlierThreshold > 0.0) || !(confidence > 0.0 && confidence < 1.0))
+        throw InvalidInputException();
+
+    std::mt19937 gen(42);
+
+    // PROSAC: samples are drawn from the top subsetSize correspondences, which grows
+    // such that the hypotheses are spread as in RANSAC over maxHypotheses draws
+    size_t subsetSize = progressive ? 3 : n;
+    double tN         = static_cast<double>(maxHypotheses);
+    for (size_t i = 0; i < 3; i++)
+        tN *= static_cast<double>(3 - i) / static_cast<double>(n - i);
+    double tNPrime = 1.0;
+
+    auto drawSample = [&](size_t t, size_t* sample) {
+        if (progressive && static_cast<double>(t) >= tNPrime && subsetSize < n)
+        {
+            subsetSize++;
+            double tNext = tN * static_cast<double>(subsetSize) / static_cast<double>(subsetSize - 3);
+            tNPrime += std::ceil(tNext - tN);
+            tN = tNext;
+        }
+
+        // the newest correspondence of the subset is part of the sample, until the subset has been sampled enough
+        bool   withNewest = progressive && subsetSize < n && tNPrime >= static_cast<double>(t);
+        size_t nbrRandom  = withNewest ? 2 : 3;
+        size_t range      = withNewest ? subsetSize - 1 : subsetSize;
+        std::uniform_int_distribution<size_t> dist(0, range - 1);
+        for (size_t s = 0; s < nbrRandom; s++)
+        {
+            bool duplicate = true;
+            while (duplicate)
+            {
+                sample[s] = dist(gen);
+                duplicate = false;
+                for (size_t q = 0; q < s; q++)
+                    duplicate = duplicate || sample[q] == sample[s];
+            }
+        }
+        if (withNewest)
+            sample[2] = subsetSize - 1;
+
+        for (size_t s = 0; s < 3; s++)
+            sample[s] = order[sample[s]];
+    };
+
+    const size_t        batch = hypothesisBatchSize();
+    std::vector<size_t> samples(3 * batch);
+    std::vector<size_t> counts(batch);
+    std::vector<double> transformations(12 * batch);
+
+    size_t              bestCount = 0;
+    std::vector<double> best(12, 0.0);
+    size_t              nbrOfHypotheses = 0;
+    size_t              required        = maxHypotheses;
+
+    while (nbrOfHypotheses < std::min(required, maxHypotheses))
+    {
+        size_t len = std::min(batch, maxHypotheses - nbrOfHypotheses);
+        for (size_t h = 0; h < len; h++)
+            drawSample(nbrOfHypotheses + h + 1, &samples[3 * h]);
+
+        // solve and score the hypotheses [h0, h1) of this batch
+        auto worker = [&](size_t h0, size_t h1) {
+            size_t              m = h1 - h0;
+            std::vector<double> hs(9 * m), centerA(3 * m), centerB(3 * m), u(9 * m), s(3 * m), v(9 * m);
+            std::vector<char>   valid(m);
+            for (size_t h = h0; h < h1; h++)
+            {
+                size_t q = h - h0;
+                valid[q] = minimalCrossCovariance(a.data(), b.data(), n, &samples[3 * h], &hs[9 * q], &centerA[3 * q], &centerB[3 * q]);
+            }
+
+            SmallDecomposition::svd3x3Batch(hs.data(), u.data(), s.data(), v.data(), m, true, 1);
+
+            for (size_t h = h0; h < h1; h++)
+            {
+                size_t  q = h - h0;
+                double* t = &transformations[12 * h];
+                Matrix4x4::composeRigidTransformation(&u[9 * q], &v[9 * q], &centerA[3 * q], &centerB[3 * q], t);
+
+                counts[h] = valid[q] ? countInliers(a.data(), b.data(), n, t, threshold2) : 0;
+            }
+        };
+        Parallel::forRange(0, len, worker, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / (16 * n)));
+
+        for (size_t h = 0; h < len; h++)
+        {
+            if (counts[h] > bestCount)
+            {
+                bestCount = counts[h];
+                std::copy(&transformations[12 * h], &transformations[12 * h] + 12, best.begin());
+            }
+        }
+        nbrOfHypotheses += len;
+
+        // hypotheses needed to draw an all inlier sample with the probability confidence
+        if (bestCount >= 3)
+        {
+            double w         = static_cast<double>(bestCount) / n;
+            double allInlier = w * w * w;
+            double needed    = allInlier >= 1.0 ? 0.0 : std::ceil(std::log(1.0 - confidence) / std::log(1.0 - allInlier));
+            required         = needed < static_cast<double>(maxHypotheses) ? static_cast<size_t>(needed) : maxHypotheses;
+        }
+    }
+
+    if (bestCount < 3)
+        return RansacResult(Matrix4x4(), std::vector<size_t>(), std::numeric_limits<double>::infinity(), nbrOfHypotheses);
+
+    // least squares refinement on the inliers, which may change the inlier set
+    std::vector<size_t> inliers = collectInliers(a.data(), b.data(), n, best.data(), threshold2);
+    Matrix<double>      inA;
+    Matrix<double>      inB;
+    auto                takeInliers = [&]() {
+        inA = Matrix<double>(3, inliers.size());
+        inB = Matrix<double>(3, inliers.size());
+        for (size_t k = 0; k < inliers.size(); k++)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                inA(i, k) = a(i, inliers[k]);
+                inB(i, k) = b(i, inliers[k]);
+            }
+        }
+    };
+
+    Matrix4x4 refined;
+    double    error = 0.0;
+    for (size_t round = 0; round < 3; round++)
+    {
+        takeInliers();
+        refined = Matrix4x4::findRigidTransformation(inA, inB, error);
+        if (round == 2)
+            break;
+
+        std::vector<size_t> next = collectInliers(a.data(), b.data(), n, refined.data(), threshold2);
+        if (next.size() < 3 || next == inliers)
+            break;
+        inliers = next;
+    }
+
+    return RansacResult(refined, inliers, error, nbrOfHypotheses);
+}
+
+inline void Registration::solveSymmetric6x6(double* a, double* b)
+{
+    double trace = 0.0;
+    for (size_t i = 0; i < 6; i++)
+        trace += a[i * 6 + i];
+    for (size_t i = 0; i < 6; i++)
+        a[i * 6 + i] += 1e-12 * trace + std::numeric_limits<double>::min();
+
+    // a = L * L', L in the lower triangle
+    for (size_t j = 0; j < 6; j++)
+    {
+        double d = a[j * 6 + j];
+        for (size_t k = 0; k < j; k++)
+            d -= a[j * 6 + k] * a[j * 6 + k];
+        d            = std::sqrt(std::max(d, std::numeric_limits<double>::min()));
+        a[j * 6 + j] = d;
+        for (size_t i = j + 1; i < 6; i++)
+        {
+            double v = a[i * 6 + j];
+            for (size_t k = 0; k < j; k++)
+                v -= a[i * 6 + k] * a[j * 6 + k];
+            a[i * 6 + j] = v / d;
+        }
+    }
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        for (size_t k = 0; k < i; k++)
+            b[i] -= a[i * 6 + k] * b[k];
+        b[i] /= a[i * 6 + i];
+    }
+    for (size_t i = 6; i-- > 0;)
+    {
+        for (size_t k = i + 1; k < 6; k++)
+            b[i] -= a[k * 6 + i] * b[k];
+        b[i] /= a[i * 6 + i];
+    }
+}
+
+inline void Registration::rotationFromVector(const double* w, double* r)
+{
+    double angle = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    double k[3]  = {0.0, 0.0, 0.0};
+    if (angle > 0.0)
+        for (size_t i = 0; i < 3; i++)
+            k[i] = w[i] / angle;
+
+    // R = I + sin * K + (1 - cos) * K^2, K the cross product matrix of the axis
+    double s = std::sin(angle);
+    double c = 1.0 - std::cos(angle);
+    r[0]     = 1.0 - c * (k[1] * k[1] + k[2] * k[2]);
+    r[1]     = -s * k[2] + c * k[0] * k[1];
+    r[2]     = s * k[1] + c * k[0] * k[2];
+    r[3]     = s * k[2] + c * k[0] * k[1];
+    r[4]     = 1.0 - c * (k[0] * k[0] + k[2] * k[2]);
+    r[5]     = -s * k[0] + c * k[1] * k[2];
+    r[6]     = -s * k[1] + c * k[0] * k[2];
+    r[7]     = s * k[0] + c * k[1] * k[2];
+    r[8]     = 1.0 - c * (k[0] * k[0] + k[1] * k[1]);
+}
+
+inline Matrix<double> Registration::estimateNormals(const KdTree& tree, size_t k, size_t nbrOfThreads)
+{
+    const Matrix<double>& points = tree.points();
+    const size_t          n      = points.cols();
+    Matrix<double>        normals(3, n);
+    normals.fill(0.0);
+
+    auto worker = [&](size_t p0, size_t p1) {
+        for (size_t p = p0; p < p1; p++)
+        {
+            double              query[3]   = {points(0, p), points(1, p), points(2, p)};
+            std::vector<size_t> neighbours = tree.nearestK(query, k);
+
+            double center[3] = {0.0, 0.0, 0.0};
+            for (size_t q : neighbours)
+                for (size_t i = 0; i < 3; i++)
+                    center[i] += points(i, q) / neighbours.size();
+
+            double cov[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+            for (size_t q : neighbours)
+            {
+                double d[3] = {points(0, q) - center[0], points(1, q) - center[1], points(2, q) - center[2]};
+                for (size_t i = 0; i < 3; i++)
+                    for (size_t j = 0; j < 3; j++)
+                        cov[i * 3 + j] += d[i] * d[j];
+            }
+
+            double values[3], vectors[9];
+            SmallDecomposition::symmetricEigen3x3(cov, values, vectors);
+            for (size_t i = 0; i < 3; i++)
+                normals(i, p) = vectors[i * 3];
+        }
+    };
+    Parallel::forRange(0, n, worker, nbrOfThreads, 64);
+
+    return normals;
+}
+
+inline Registration::IcpResult Registration::icp(const Matrix<double>& source, const KdTree& target, const Matrix<double>& targetNormals,
+                                                 const Matrix4x4& initial, const IcpParameters& parameters)
+{
+    const size_t n             = source.cols();
+    const bool   pointToPlane  = parameters.Metric == PointToPlane;
+    const size_t minCorrespond = pointToPlane ? 6 : 3;
+    if (source.rows() != 3 || n < minCorrespond || target.size() < 3 || parameters.NbrOfLevels == 0 || parameters.MaxNbrOfPoints == 0)
+        throw InvalidInputException();
+    if (pointToPlane && (targetNormals.rows() != 3 || targetNormals.cols() != target.size()))
+        throw InvalidInputException();
+
+    const Matrix<double>& targetPoints = target.points();
+    const double          maxDistance2 = parameters.MaxDistance * parameters.MaxDistance;
+    const size_t          finestStride = std::max<size_t>(1, (n + parameters.MaxNbrOfPoints - 1) / parameters.MaxNbrOfPoints);
+
+    Matrix4x4 t               = initial;
+    double    error           = std::numeric_limits<double>::infinity();
+    size_t    nbrOfCorrespond = 0;
+    size_t    nbrOfIterations = 0;
+    bool      converged       = false;
+
+    std::vector<size_t> subset;
+    std::vector<size_t> matches;
+    std::vector<double> distances2;
+    for (size_t level = 0; level < parameters.NbrOfLevels; level++)
+    {
+        // every stride-th source point, but enough for a stable solution
+        size_t stride = finestStride;
+        for (size_t l = level + 1; l < parameters.NbrOfLevels && n / (4 * stride) >= 64; l++)
+            stride *= 4;
+
+        subset.clear();
+        for (size_t k = 0; k < n; k += stride)
+            subset.push_back(k);
+        matches.resize(subset.size());
+        distances2.resize(subset.size());
+
+        converged            = false;
+        double previousError = std::numeric_limits<double>::infinity();
+        for (size_t it = 0; it < parameters.MaxIterations; it++)
+        {
+            // transformed source points and their nearest target points
+            const double* m      = t.data();
+            auto          worker = [&](size_t s0, size_t s1) {
+                for (size_t s = s0; s < s1; s++)
+                {
+                    size_t k        = subset[s];
+                    double x        = source(0, k);
+                    double y        = source(1, k);
+                    double z        = source(2, k);
+                    double query[3] = {m[0] * x + m[1] * y + m[2] * z + m[3], m[4] * x + m[5] * y + m[6] * z + m[7],
+                                       m[8] * x + m[9] * y + m[10] * z + m[11]};
+                    target.nearest(query, matches[s], distances2[s], maxDistance2);
+                }
+            };
+            Parallel::forRange(0, subset.size(), worker, parameters.NbrOfThreads, 256);
+
+            std::vector<size_t> valid;
+            double              sumDistance = 0.0;
+            for (size_t s = 0; s < subset.size(); s++)
+            {
+                if (matches[s] < target.size())
+                {
+                    valid.push_back(s);
+                    sumDistance += std::sqrt(distances2[s]);
+                }
+            }
+
+            nbrOfCorrespond = valid.size();
+            if (nbrOfCorrespond < minCorrespond)
+                return IcpResult(t, error, nbrOfCorrespond, nbrOfIterations, false);
+            error = sumDistance / nbrOfCorrespond;
+
+            // the correspondences do not improve anymore, e.g. they alternate between neighbours
+            if (std::abs(previousError - error) <= parameters.Tolerance * error)
+            {
+                converged = true;
+                break;
+            }
+            previousError = error;
+
+            Matrix4x4 next;
+            if (!pointToPlane)
+            {
+                Matrix<double> a(3, nbrOfCorrespond);
+                Matrix<double> b(3, nbrOfCorrespond);
+                for (size_t v = 0; v < nbrOfCorrespond; v++)
+                {
+                    for (size_t i = 0; i < 3; i++)
+                    {
+                        a(i, v) = source(i, subset[valid[v]]);
+                        b(i, v) = targetPoints(i, matches[valid[v]]);
+                    }
+                }
+                double fitError;
+                next = Matrix4x4::findRigidTransformation(a, b, fitError);
+            }
+            else
+            {
+                // minimize sum(((p + w x p + dt - q) . n)^2) over the rotation vector w and dt
+                double ata[36] = {0.0};
+                double atb[6]  = {0.0};
+                for (size_t v : valid)
+                {
+                    size_t k    = subset[v];
+                    size_t q    = matches[v];
+                    double x    = source(0, k);
+                    double y    = source(1, k);
+                    double z    = source(2, k);
+                    double p[3] = {m[0] * x + m[1] * y + m[2] * z + m[3], m[4] * x + m[5] * y + m[6] * z + m[7],
+                                   m[8] * x + m[9] * y + m[10] * z + m[11]};
+                    double nq[3]  = {targetNormals(0, q), targetNormals(1, q), targetNormals(2, q)};
+                    double row[6] = {p[1] * nq[2] - p[2] * nq[1], p[2] * nq[0] - p[0] * nq[2], p[0] * nq[1] - p[1] * nq[0],
+                                     nq[0], nq[1], nq[2]};
+                    double r = (targetPoints(0, q) - p[0]) * nq[0] + (targetPoints(1, q) - p[1]) * nq[1] +
+                               (targetPoints(2, q) - p[2]) * nq[2];
+                    for (size_t i = 0; i < 6; i++)
+                    {
+                        atb[i] += row[i] * r;
+                        for (size_t j = 0; j < 6; j++)
+                            ata[i * 6 + j] += row[i] * row[j];
+                    }
+                }
+                solveSymmetric6x6(ata, atb);
+
+                double rot[9];
+                rotationFromVector(atb, rot);
+                Matrix4x4 delta;
+                delta.setRotation(Matrix<double>(3, 3, rot));
+                delta.setTranslation(atb[3], atb[4], atb[5]);
+                next = Matrix4x4(delta * t);
+            }
+
+            double change = 0.0;
+            for (size_t e = 0; e < 12; e++)
+                change += std::abs(next.data()[e] - t.data()[e]);
+            t = next;
+            nbrOfIterations++;
+
+            if (change < parameters.Tolerance)
+            {
+                converged = true;
+                break;
+            }
+        }
+    }
+
+    return IcpResult(t, error, nbrOfCorrespond, nbrOfIterations, converged);
+}
+
+inline Registration::IcpResult Registration::icp(const Matrix<double>& source, const Matrix<double>& target, const Matrix4x4& initial,
+                                                 const IcpParameters& parameters)
+{
+    KdTree         tree(target);
+    Matrix<double> normals;
+    if (parameters.Metric == PointToPlane)
+        normals = estimateNormals(tree, 8, parameters.NbrOfThreads);
+
+    return icp(source, tree, normals, initial, parameters);
+}
+
+template <typename R, typename Q>
+Registration::RansacResult Registration::ransac(const Matrix<R>& setA, const Matrix<Q>& setB, double inlierThreshold, double confidence,
+                                                size_t maxHypotheses, size_t nbrOfThreads)
+{
+    std::vector<size_t> order(setA.cols());
+    std::iota(order.begin(), order.end(), 0);
+    return robustRegistration(Matrix<double>(setA), Matrix<double>(setB), order, false, inlierThreshold, confidence, maxHypotheses, nbrOfThreads);
+}
+
+template <typename R, typename Q>
+Registration::RansacResult Registration::prosac(const Matrix<R>& setA, const Matrix<Q>& setB, const std::vector<double>& quality,
+                                                double inlierThreshold, double confidence, size_t maxHypotheses, size_t nbrOfThreads)
+{
+    if (quality.size() != setA.cols())
+        throw InvalidInputException();
+
+    std::vector<size_t> order(setA.cols());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&quality](size_t x, size_t y) { return quality[x] > quality[y]; });
+    return robustRegistration(Matrix<double>(setA), Matrix<double>(setB), order, true, inlierThreshold, confidence, maxHypotheses, nbrOfThreads);
+}
+
+#endif //MY_REGISTRATION_H
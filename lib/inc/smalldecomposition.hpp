@@ -0,0 +1,465 @@
+/****************************************************************************
+** Copyright (c) 2019 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef MY_SMALL_DECOMPOSITION_H
+#define MY_SMALL_DECOMPOSITION_H
+
+#include "kernels.hpp"
+#include "parallel.hpp"
+
+#include <smmintrin.h> // SSE4
+#include <cmath>
+#include <algorithm>
+
+/**
+ * Decompositions of 2x2 and 3x3 matrices without heap allocations and
+ * without data dependent branches: the symmetric Eigen problems are solved
+ * by a fixed number of cyclic Jacobi sweeps and conditions are evaluated by
+ * selects. The matrices are row major double arrays. The batched versions
+ * process four problems at once in SSE registers.
+ */
+class SmallDecomposition
+{
+public:
+    /**
+     * Eigen decomposition of the symmetric 2x2 matrix a by one Jacobi rotation.
+     * @param a Symmetric matrix, 4 values.
+     * @param values Eigen values in ascending order, 2 values.
+     * @param vectors Eigen vectors as columns, 4 values.
+     */
+    static void symmetricEigen2x2(const double* a, double* values, double* vectors);
+
+    /**
+     * Eigen decomposition of the symmetric 3x3 matrix a by cyclic Jacobi sweeps.
+     * @param a Symmetric matrix, 9 values.
+     * @param values Eigen values in ascending order, 3 values.
+     * @param vectors Eigen vectors as columns, 9 values.
+     */
+    static void symmetricEigen3x3(const double* a, double* values, double* vectors);
+
+    /**
+     * Singular value decomposition A = U * diag(s) * V' of the 3x3 matrix a
+     * (McAdams et al.). V are the Eigen vectors of A' * A and U * R = A * V
+     * is factored by Givens rotations.
+     * @param a Matrix, 9 values.
+     * @param u Left singular vectors as columns, 9 values.
+     * @param s Singular values in descending order, 3 values.
+     * @param v Right singular vectors as columns, 9 values.
+     * @param rotations If true, U and V are rotations and s[2] has the sign of
+     *        det(A). V * U' is then the closest rotation to A', as needed for
+     *        rigid registration.
+     */
+    static void svd3x3(const double* a, double* u, double* s, double* v, bool rotations = false);
+
+    /**
+     * symmetricEigen3x3 of count matrices, which are stored one after another.
+     * Four problems are processed at once and the groups are split onto threads.
+     * @param a count symmetric matrices, 9 values each.
+     * @param values count times 3 Eigen values.
+     * @param vectors count times 9 Eigen vector values.
+     * @param count Number of matrices.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void symmetricEigen3x3Batch(const double* a, double* values, double* vectors, size_t count, size_t nbrOfThreads = 0);
+
+    /**
+     * svd3x3 of count matrices, which are stored one after another.
+     * Four problems are processed at once and the groups are split onto threads.
+     * @param a count matrices, 9 values each.
+     * @param u count times 9 values.
+     * @param s count times 3 values.
+     * @param v count times 9 values.
+     * @param count Number of matrices.
+     * @param rotations See svd3x3.
+     * @param nbrOfThreads Maximum number of threads. 0 means Parallel::defaultNbrOfThreads().
+     */
+    static void svd3x3Batch(const double* a, double* u, double* s, double* v, size_t count, bool rotations = false,
+                            size_t nbrOfThreads = 0);
+
+private:
+    // Four doubles in two SSE registers: one lane per problem.
+    struct Lanes
+    {
+        Lanes()
+        {
+        }
+
+        Lanes(double x)
+        : lo(_mm_set1_pd(x)), hi(_mm_set1_pd(x))
+        {
+        }
+
+        Lanes(__m128d l, __m128d h)
+        : lo(l), hi(h)
+        {
+        }
+
+        friend Lanes operator+(const Lanes& x, const Lanes& y)
+        {
+            return Lanes(_mm_add_pd(x.lo, y.lo), _mm_add_pd(x.hi, y.hi));
+        }
+
+        friend Lanes operator-(const Lanes& x, const Lanes& y)
+        {
+            return Lanes(_mm_sub_pd(x.lo, y.lo), _mm_sub_pd(x.hi, y.hi));
+        }
+
+        friend Lanes operator*(const Lanes& x, const Lanes& y)
+        {
+            return Lanes(_mm_mul_pd(x.lo, y.lo), _mm_mul_pd(x.hi, y.hi));
+        }
+
+        friend Lanes operator/(const Lanes& x, const Lanes& y)
+        {
+            return Lanes(_mm_div_pd(x.lo, y.lo), _mm_div_pd(x.hi, y.hi));
+        }
+
+        friend Lanes operator-(const Lanes& x)
+        {
+            return Lanes(_mm_xor_pd(x.lo, _mm_set1_pd(-0.0)), _mm_xor_pd(x.hi, _mm_set1_pd(-0.0)));
+        }
+
+        // Comparisons return masks with all bits of a lane set if true
+        friend Lanes operator<(const Lanes& x, const Lanes& y)
+        {
+            return Lanes(_mm_cmplt_pd(x.lo, y.lo), _mm_cmplt_pd(x.hi, y.hi));
+        }
+
+        friend Lanes operator==(const Lanes& x, const Lanes& y)
+        {
+            return Lanes(_mm_cmpeq_pd(x.lo, y.lo), _mm_cmpeq_pd(x.hi, y.hi));
+        }
+
+        __m128d lo; // problems 0 and 1
+        __m128d hi; // problems 2 and 3
+    };
+
+    // Lane wise helpers with the same names for double and Lanes
+    static double select(bool mask, double x, double y)
+    {
+        return mask ? x : y;
+    }
+
+    static Lanes select(const Lanes& mask, const Lanes& x, const Lanes& y)
+    {
+        return Lanes(_mm_blendv_pd(y.lo, x.lo, mask.lo), _mm_blendv_pd(y.hi, x.hi, mask.hi));
+    }
+
+    static double squareRoot(double x)
+    {
+        return std::sqrt(x);
+    }
+
+    static Lanes squareRoot(const Lanes& x)
+    {
+        return Lanes(_mm_sqrt_pd(x.lo), _mm_sqrt_pd(x.hi));
+    }
+
+    // |magnitude| with the sign of sign
+    static double copySign(double magnitude, double sign)
+    {
+        return std::copysign(magnitude, sign);
+    }
+
+    static Lanes copySign(const Lanes& magnitude, const Lanes& sign)
+    {
+        __m128d signBit = _mm_set1_pd(-0.0);
+        return Lanes(_mm_or_pd(_mm_andnot_pd(signBit, magnitude.lo), _mm_and_pd(signBit, sign.lo)),
+                     _mm_or_pd(_mm_andnot_pd(signBit, magnitude.hi), _mm_and_pd(signBit, sign.hi)));
+    }
+
+    // Loads element e of the four matrices a, a + stride, ... into lanes
+    static Lanes gather(const double* a, size_t stride, size_t e)
+    {
+        return Lanes(_mm_set_pd(a[stride + e], a[e]), _mm_set_pd(a[3 * stride + e], a[2 * stride + e]));
+    }
+
+    static void scatter(const Lanes& x, double* a, size_t stride, size_t e)
+    {
+        _mm_storel_pd(a + e, x.lo);
+        _mm_storeh_pd(a + stride + e, x.lo);
+        _mm_storel_pd(a + 2 * stride + e, x.hi);
+        _mm_storeh_pd(a + 3 * stride + e, x.hi);
+    }
+
+    // Number of cyclic sweeps. Jacobi converges quadratically, so that
+    // the off diagonal part is below rounding errors after a few sweeps.
+    static size_t jacobiSweeps()
+    {
+        return 6;
+    }
+
+    // Jacobi rotation, which zeros s(p, q) of the symmetric matrix s (n x n),
+    // applied to the columns p and q of v.
+    template <class V>
+    static void jacobiRotation(V* s, V* v, size_t n, size_t p, size_t q);
+
+    // Swaps the columns p and q of v (n x n) and the values p and q where mask is set
+    template <class V, class M>
+    static void conditionalSwap(const M& mask, V* values, V* v, size_t n, size_t p, size_t q);
+
+    // Eigen decomposition of the symmetric matrix s (n x n, 2 or 3), which is overwritten.
+    template <class V>
+    static void symmetricEigenCore(V* s, V* values, V* v, size_t n);
+
+    // Givens rotation of the rows j and i of b, which zeros b(i, j), applied to the columns of u.
+    template <class V>
+    static void givensQR(V* b, V* u, size_t j, size_t i);
+
+    template <class V>
+    static void svd3x3Core(const V* a, V* u, V* s, V* v, bool rotations);
+};
+
+template <class V>
+void SmallDecomposition::jacobiRotation(V* s, V* v, size_t n, size_t p, size_t q)
+{
+    V app = s[p * n + p];
+    V aqq = s[q * n + q];
+    V apq = s[p * n + q];
+
+    // t = tan(theta) of the smaller angle, 0 if s(p, q) is 0 already
+    auto isZero = (apq == V(0.0));
+    V    zeta   = (aqq - app) / select(isZero, V(1.0), V(2.0) * apq);
+    V    t      = copySign(V(1.0) / (copySign(zeta, V(1.0)) + squareRoot(V(1.0) + zeta * zeta)), zeta);
+    t           = select(isZero, V(0.0), t);
+    V c         = V(1.0) / squareRoot(V(1.0) + t * t);
+    V sn        = t * c;
+
+    s[p * n + p] = app - t * apq;
+    s[q * n + q] = aqq + t * apq;
+    s[p * n + q] = V(0.0);
+    s[q * n + p] = V(0.0);
+    for (size_t r = 0; r < n; r++)
+    {
+        if (r == p || r == q)
+            continue;
+
+        V arp        = s[r * n + p];
+        V arq        = s[r * n + q];
+        s[r * n + p] = c * arp - sn * arq;
+        s[r * n + q] = sn * arp + c * arq;
+        s[p * n + r] = s[r * n + p];
+        s[q * n + r] = s[r * n + q];
+    }
+
+    for (size_t k = 0; k < n; k++)
+    {
+        V vkp        = v[k * n + p];
+        V vkq        = v[k * n + q];
+        v[k * n + p] = c * vkp - sn * vkq;
+        v[k * n + q] = sn * vkp + c * vkq;
+    }
+}
+
+template <class V, class M>
+void SmallDecomposition::conditionalSwap(const M& mask, V* values, V* v, size_t n, size_t p, size_t q)
+{
+    V vp      = values[p];
+    values[p] = select(mask, values[q], vp);
+    values[q] = select(mask, vp, values[q]);
+    for (size_t k = 0; k < n; k++)
+    {
+        V x          = v[k * n + p];
+        v[k * n + p] = select(mask, v[k * n + q], x);
+        v[k * n + q] = select(mask, x, v[k * n + q]);
+    }
+}
+
+template <class V>
+void SmallDecomposition::symmetricEigenCore(V* s, V* values, V* v, size_t n)
+{
+    for (size_t k = 0; k < n * n; k++)
+        v[k] = V(k % (n + 1) == 0 ? 1.0 : 0.0);
+
+    // a single rotation diagonalizes a 2x2 matrix
+    size_t sweeps = (n == 2) ? 1 : jacobiSweeps();
+    for (size_t sweep = 0; sweep < sweeps; sweep++)
+    {
+        for (size_t p = 0; p + 1 < n; p++)
+            for (size_t q = p + 1; q < n; q++)
+                jacobiRotation(s, v, n, p, q);
+    }
+
+    for (size_t k = 0; k < n; k++)
+        values[k] = s[k * n + k];
+
+    // ascending order by a sorting network
+    conditionalSwap(values[1] < values[0], values, v, n, 0, 1);
+    if (n == 3)
+    {
+        conditionalSwap(values[2] < values[1], values, v, n, 1, 2);
+        conditionalSwap(values[1] < values[0], values, v, n, 0, 1);
+    }
+}
+
+template <class V>
+void SmallDecomposition::givensQR(V* b, V* u, size_t j, size_t i)
+{
+    V    bjj    = b[j * 3 + j];
+    V    bij    = b[i * 3 + j];
+    V    r      = squareRoot(bjj * bjj + bij * bij);
+    auto isZero = (r == V(0.0));
+    V    rInv   = V(1.0) / select(isZero, V(1.0), r);
+    V    c      = select(isZero, V(1.0), bjj * rInv);
+    V    sn     = select(isZero, V(0.0), bij * rInv);
+
+    for (size_t k = 0; k < 3; k++)
+    {
+        V x          = b[j * 3 + k];
+        V y          = b[i * 3 + k];
+        b[j * 3 + k] = c * x + sn * y;
+        b[i * 3 + k] = c * y - sn * x;
+
+        x            = u[k * 3 + j];
+        y            = u[k * 3 + i];
+        u[k * 3 + j] = c * x + sn * y;
+        u[k * 3 + i] = c * y - sn * x;
+    }
+}
+
+template <class V>
+void SmallDecomposition::svd3x3Core(const V* a, V* u, V* s, V* v, bool rotations)
+{
+    // V: Eigen vectors of A' * A in descending order
+    V ata[9];
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 3; j++)
+            ata[i * 3 + j] = a[i] * a[j] + a[3 + i] * a[3 + j] + a[6 + i] * a[6 + j];
+
+    V values[3];
+    V w[9];
+    symmetricEigenCore(ata, values, w, 3);
+    for (size_t k = 0; k < 3; k++)
+    {
+        v[k * 3 + 0] = w[k * 3 + 2];
+        v[k * 3 + 1] = w[k * 3 + 1];
+        v[k * 3 + 2] = w[k * 3 + 0];
+    }
+
+    // V becomes a rotation
+    V det = v[0] * (v[4] * v[8] - v[5] * v[7]) - v[1] * (v[3] * v[8] - v[5] * v[6]) + v[2] * (v[3] * v[7] - v[4] * v[6]);
+    auto isReflection = (det < V(0.0));
+    for (size_t k = 0; k < 3; k++)
+        v[k * 3 + 2] = select(isReflection, -v[k * 3 + 2], v[k * 3 + 2]);
+
+    // B = A * V = U * R, where R is diagonal up to rounding errors
+    V b[9];
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 3; j++)
+            b[i * 3 + j] = a[i * 3] * v[j] + a[i * 3 + 1] * v[3 + j] + a[i * 3 + 2] * v[6 + j];
+
+    for (size_t k = 0; k < 9; k++)
+        u[k] = V(k % 4 == 0 ? 1.0 : 0.0);
+    givensQR(b, u, 0, 1);
+    givensQR(b, u, 0, 2);
+    givensQR(b, u, 1, 2);
+
+    s[0] = b[0];
+    s[1] = b[4];
+    s[2] = b[8];
+    if (!rotations)
+    {
+        auto isNegative = (s[2] < V(0.0));
+        s[2]            = select(isNegative, -s[2], s[2]);
+        for (size_t k = 0; k < 3; k++)
+            u[k * 3 + 2] = select(isNegative, -u[k * 3 + 2], u[k * 3 + 2]);
+    }
+}
+
+inline void SmallDecomposition::symmetricEigen2x2(const double* a, double* values, double* vectors)
+{
+    double s[4];
+    std::copy(a, a + 4, s);
+    symmetricEigenCore(s, values, vectors, 2);
+}
+
+inline void SmallDecomposition::symmetricEigen3x3(const double* a, double* values, double* vectors)
+{
+    double s[9];
+    std::copy(a, a + 9, s);
+    symmetricEigenCore(s, values, vectors, 3);
+}
+
+inline void SmallDecomposition::svd3x3(const double* a, double* u, double* s, double* v, bool rotations)
+{
+    svd3x3Core(a, u, s, v, rotations);
+}
+
+inline void SmallDecomposition::symmetricEigen3x3Batch(const double* a, double* values, double* vectors, size_t count,
+                                                       size_t nbrOfThreads)
+{
+    auto worker = [&](size_t g0, size_t g1) {
+        for (size_t g = g0; g < g1; g++)
+        {
+            size_t first = 4 * g;
+            Lanes  s[9], val[3], vec[9];
+            for (size_t e = 0; e < 9; e++)
+                s[e] = gather(a + 9 * first, 9, e);
+
+            symmetricEigenCore(s, val, vec, 3);
+
+            for (size_t e = 0; e < 3; e++)
+                scatter(val[e], values + 3 * first, 3, e);
+            for (size_t e = 0; e < 9; e++)
+                scatter(vec[e], vectors + 9 * first, 9, e);
+        }
+    };
+
+    size_t nbrOfGroups = count / 4;
+    Parallel::forRange(0, nbrOfGroups, worker, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / 1024));
+
+    for (size_t k = 4 * nbrOfGroups; k < count; k++)
+        symmetricEigen3x3(a + 9 * k, values + 3 * k, vectors + 9 * k);
+}
+
+inline void SmallDecomposition::svd3x3Batch(const double* a, double* u, double* s, double* v, size_t count, bool rotations,
+                                            size_t nbrOfThreads)
+{
+    auto worker = [&](size_t g0, size_t g1) {
+        for (size_t g = g0; g < g1; g++)
+        {
+            size_t first = 4 * g;
+            Lanes  la[9], lu[9], ls[3], lv[9];
+            for (size_t e = 0; e < 9; e++)
+                la[e] = gather(a + 9 * first, 9, e);
+
+            svd3x3Core(la, lu, ls, lv, rotations);
+
+            for (size_t e = 0; e < 9; e++)
+            {
+                scatter(lu[e], u + 9 * first, 9, e);
+                scatter(lv[e], v + 9 * first, 9, e);
+            }
+            for (size_t e = 0; e < 3; e++)
+                scatter(ls[e], s + 3 * first, 3, e);
+        }
+    };
+
+    size_t nbrOfGroups = count / 4;
+    Parallel::forRange(0, nbrOfGroups, worker, nbrOfThreads, std::max<size_t>(1, Kernels::ParallelGrainSize / 2048));
+
+    for (size_t k = 4 * nbrOfGroups; k < count; k++)
+        svd3x3(a + 9 * k, u + 9 * k, s + 3 * k, v + 9 * k, rotations);
+}
+
+#endif //MY_SMALL_DECOMPOSITION_H
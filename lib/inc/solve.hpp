@@ -26,25 +26,124 @@
 
 #include "matrix.hpp"
 #include "transformation.hpp"
+#include "decomposition.hpp"
+#include "kernels.hpp"
 
 class Solve
 {
 public:
+    enum Factorization
+    {
+        LU,       // LU decomposition with partial pivoting. Square matrices.
+        Cholesky, // Cholesky decomposition. Symmetric positive definite matrices.
+        LDLT,     // LDL' decomposition. Symmetric matrices, which do not require pivoting.
+        QR        // QR decomposition. Matrices with at least as many rows as columns, least squares.
+    };
+
+    /**
+     * Factorization of a coefficient matrix, kept for solving
+     * the same system for any number of right hand sides.
+     */
+    class Solver
+    {
+    public:
+        /**
+         * Factorizes the coefficient matrix.
+         * Throws ZeroDeterminantException if the matrix is singular (LU, LDLT, QR)
+         * and NotPositiveDefiniteException if Cholesky fails.
+         * @param mat Matrix of coefficients.
+         * @param factorization Factorization to use.
+         */
+        template <class T>
+        Solver(const Matrix<T>& mat, Factorization factorization = LU);
+
+        /**
+         * Solves mat * X = B. For QR, X is the least squares solution.
+         * @param b Right hand sides (m x k), one system per column.
+         * @return Solution (n x k).
+         */
+        template <class T>
+        Matrix<double> solve(const Matrix<T>& b) const;
+
+        /**
+         * Solves mat * X = B in place. Only for square systems.
+         * @param b Right hand sides (n x k), on return the solution.
+         */
+        void solveInPlace(Matrix<double>& b) const;
+
+        /**
+         * @return Factorization in use.
+         */
+        Factorization factorization() const
+        {
+            return m_factorization;
+        }
+
+        /**
+         * @return Number of rows of the coefficient matrix.
+         */
+        size_t rows() const
+        {
+            return m_rows;
+        }
+
+        /**
+         * @return Number of columns of the coefficient matrix.
+         */
+        size_t cols() const
+        {
+            return m_cols;
+        }
+
+    private:
+        // R * X = B, where B holds Q' * b
+        void solveUpperTriangleR(Matrix<double>& b) const;
+
+        Factorization       m_factorization;
+        size_t              m_rows;
+        size_t              m_cols;
+        Matrix<double>      m_factor; // packed LU, Cholesky L, packed LDL' or packed QR
+        std::vector<double> m_tau;    // reflector factors of QR
+        std::vector<size_t> m_pivots; // row swaps of LU
+    };
+
     /**
-    * Solves linear system of equations.
-    * @param mat Matrix of coefficients.
-    * @param b Condition vector.
-    * @return Solution vector.
-    */
+     * Solves linear system of equations.
+     * @param mat Matrix of coefficients.
+     * @param b Condition vector or matrix of condition vectors (n x k).
+     * @return Solution vector or matrix of solution vectors (n x k).
+     */
     template <class T>
     static Matrix<double> solve_lseq(const Matrix<T>& mat, const Matrix<T>& b);
+
+    /**
+     * Solves the linear system mat * X = B by a factorization. If the same
+     * matrix is used for several calls, prefer a Solver.
+     * @param mat Matrix of coefficients.
+     * @param b Right hand sides (m x k), one system per column.
+     * @param factorization Factorization to use.
+     * @return Solution (n x k).
+     */
+    template <class T, class R>
+    static Matrix<double> solve(const Matrix<T>& mat, const Matrix<R>& b, Factorization factorization = LU);
+
+    /**
+     * Least squares solution of the over-determined system mat * X = B, i.e.
+     * X minimizes ||mat * X - B||. The packed QR decomposition is applied
+     * to B without forming Q.
+     * @param mat Matrix of coefficients (m x n), with m >= n and full column rank.
+     * @param b Right hand sides (m x k), one system per column.
+     * @return Solution (n x k).
+     */
+    template <class T, class R>
+    static Matrix<double> leastSquares(const Matrix<T>& mat, const Matrix<R>& b);
 };
 
 template <class T>
 Matrix<double> Solve::solve_lseq(const Matrix<T>& mat, const Matrix<T>& b)
 {
     // check input
-    if (b.cols() != 1)
+    if (b.cols() < 1)
     {
         std::cout << "Error: Condition vector wrong dimension";
         std::exit(-1);
@@ -61,16 +160,155 @@ Matrix<double> Solve::solve_lseq(const Matrix<T>& mat, const Matrix<T>& b)
     }
 
     // make augmented matrix
-    Matrix<double> a(mat.rows(), mat.cols() + 1);
+    Matrix<double> a(mat.rows(), mat.cols() + b.cols());
     a.setSubMatrix(0, 0, mat);
     a.setSubMatrix(0, mat.cols(), b);
 
     // solve by using full-pivoting reduced echelon transformation
-    std::vector<Matrix<double>> rowOps; // not used
-    Matrix<double>              redEch = Transformation::reduced_echelon(a, rowOps, true);
+    Transformation::reduced_echelon_inplace(a, true);
+
+    // solution vectors are in the last columns
+    return a.subMatrix(0, mat.cols(), mat.rows(), b.cols());
+}
+
+template <class T, class R>
+Matrix<double> Solve::solve(const Matrix<T>& mat, const Matrix<R>& b, Factorization factorization)
+{
+    return Solver(mat, factorization).solve(b);
+}
+
+template <class T, class R>
+Matrix<double> Solve::leastSquares(const Matrix<T>& mat, const Matrix<R>& b)
+{
+    return Solver(mat, QR).solve(b);
+}
+
+template <class T>
+Solve::Solver::Solver(const Matrix<T>& mat, Factorization factorization)
+: m_factorization(factorization), m_rows(mat.rows()), m_cols(mat.cols()), m_factor(mat)
+{
+    switch (m_factorization)
+    {
+        case LU:
+        {
+            if (!mat.isSquare())
+                throw SquareMatrixException();
+
+            size_t nbrRowSwaps = 0;
+            if (Decomposition::luPackedInPlace(m_factor, m_pivots, nbrRowSwaps))
+                throw ZeroDeterminantException();
+            break;
+        }
+
+        case Cholesky:
+        {
+            if (!mat.isSquare())
+                throw SquareMatrixException();
+
+            if (!Decomposition::choleskyPackedInPlace(m_factor))
+                throw NotPositiveDefiniteException();
+            break;
+        }
 
-    // solution vector is in last column
-    return redEch.column(mat.cols());
+        case LDLT:
+        {
+            if (!mat.isSquare())
+                throw SquareMatrixException();
+
+            if (!Decomposition::ldltPackedInPlace(m_factor))
+                throw ZeroDeterminantException();
+            break;
+        }
+
+        case QR:
+        {
+            if (m_rows < m_cols)
+                throw InvalidInputException();
+
+            Decomposition::qrPackedInPlace(m_factor, m_tau);
+
+            // A rank deficient matrix rarely gives an exact zero in R. Diagonal
+            // entries at rounding error level relative to the largest one count as zero.
+            double maxDiag = 0.0;
+            for (size_t i = 0; i < m_cols; i++)
+                maxDiag = std::max(maxDiag, std::abs(m_factor(i, i)));
+
+            double tolerance = m_cols * std::numeric_limits<double>::epsilon() * maxDiag;
+            for (size_t i = 0; i < m_cols; i++)
+            {
+                if (!(std::abs(m_factor(i, i)) > tolerance))
+                    throw ZeroDeterminantException();
+            }
+            break;
+        }
+    }
+}
+
+template <class T>
+Matrix<double> Solve::Solver::solve(const Matrix<T>& b) const
+{
+    if (b.rows() != m_rows)
+        throw InvalidInputException();
+
+    if (m_factorization == QR)
+    {
+        // only the first n rows of Q' * b are needed, the
+        // remaining ones are the residual.
+        Matrix<double> qtb = b;
+        Decomposition::qrPackedApplyQTransposedInPlace(m_factor, m_tau, qtb);
+
+        Matrix<double> x = qtb.subMatrix(0, 0, m_cols, qtb.cols());
+        solveUpperTriangleR(x);
+        return x;
+    }
+
+    Matrix<double> x = b;
+    solveInPlace(x);
+    return x;
+}
+
+inline void Solve::Solver::solveInPlace(Matrix<double>& b) const
+{
+    if (m_rows != m_cols || b.rows() != m_cols)
+        throw InvalidInputException();
+
+    switch (m_factorization)
+    {
+        case LU:
+            Decomposition::luPackedSolveInPlace(m_factor, m_pivots, b);
+            break;
+
+        case Cholesky:
+            Decomposition::choleskyPackedSolveInPlace(m_factor, b);
+            break;
+
+        case LDLT:
+            Decomposition::ldltPackedSolveInPlace(m_factor, b);
+            break;
+
+        case QR:
+            Decomposition::qrPackedApplyQTransposedInPlace(m_factor, m_tau, b);
+            solveUpperTriangleR(b);
+            break;
+    }
+}
+
+inline void Solve::Solver::solveUpperTriangleR(Matrix<double>& b) const
+{
+    size_t  n    = m_cols;
+    size_t  nRhs = b.cols();
+    double* x    = b.data();
+
+    // backward substitution
+    for (size_t ii = n; ii > 0; ii--)
+    {
+        size_t  i  = ii - 1;
+        double* xi = x + i * nRhs;
+        for (size_t j = i + 1; j < n; j++)
+            Kernels::axpy(xi, x + j * nRhs, nRhs, -m_factor(i, j));
+
+        Kernels::scale(xi, nRhs, 1.0 / m_factor(i, i));
+    }
 }
 
 #endif //MY_SOLVE_H
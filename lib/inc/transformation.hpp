@@ -26,61 +26,119 @@
 
 #include "matrix.hpp"
 #include "multiplier.hpp"
+#include "kernels.hpp"
 
 class Transformation
 {
 public:
     /**
- * Computes the Echelon form of matrix mat.
- * @param mat
- * @return Echelon form.
- */
+     * Computes the Echelon form of matrix mat. No row operations are recorded.
+     * @param mat
+     * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
+     * @return Echelon form.
+     */
     template <class T>
-    static Matrix<double> echelon(const Matrix<T>& mat);
+    static Matrix<double> echelon(const Matrix<T>& mat, bool fullPivoting = false);
 
     /**
- * Computes the Echelon form of matrix mat.
- * @param mat
- * @param rowOperations List of required row operations at return.
- * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
- * @return Echelon form.
- */
+     * Computes the Echelon form of matrix mat.
+     * @param mat
+     * @param rowOperations List of required row operations at return, in compact form.
+     * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
+     * @return Echelon form.
+     */
+    template <class T>
+    static Matrix<double> echelon(const Matrix<T>& mat, std::vector<Multiplier::RowOperation>& rowOperations, bool fullPivoting = false);
+
+    /**
+     * Computes the Echelon form of matrix mat.
+     * @param mat
+     * @param rowOperations List of required row operations at return as multiplier matrices.
+     *                      Prefer the compact overload, as each operation costs a full m x m matrix.
+     * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
+     * @return Echelon form.
+     */
     template <class T>
     static Matrix<double> echelon(const Matrix<T>& mat, std::vector<Matrix<double>>& rowOperations, bool fullPivoting = false);
 
     /**
- * Computes the reduced Echelon form of matrix mat.
- * @param mat
- * @return Echelon form.
- */
+     * Computes the reduced Echelon form of matrix mat. No row operations are recorded.
+     * @param mat
+     * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
+     * @return Echelon form.
+     */
+    template <class T>
+    static Matrix<double> reduced_echelon(const Matrix<T>& mat, bool fullPivoting = false);
+
+    /**
+     * Computes the reduced Echelon form of matrix mat.
+     * @param mat
+     * @param rowOperations List of required row operations at return, in compact form.
+     * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
+     * @return Echelon form.
+     */
     template <class T>
-    static Matrix<double> reduced_echelon(const Matrix<T>& mat);
+    static Matrix<double> reduced_echelon(const Matrix<T>& mat, std::vector<Multiplier::RowOperation>& rowOperations, bool fullPivoting = false);
 
     /**
- * Computes the reduced Echelon form of matrix mat.
- * @param mat
- * @param rowOperations List of required row operations at return.
- * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
- * @return Echelon form.
- */
+     * Computes the reduced Echelon form of matrix mat.
+     * @param mat
+     * @param rowOperations List of required row operations at return as multiplier matrices.
+     *                      Prefer the compact overload, as each operation costs a full m x m matrix.
+     * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
+     * @return Echelon form.
+     */
     template <class T>
     static Matrix<double> reduced_echelon(const Matrix<T>& mat, std::vector<Matrix<double>>& rowOperations, bool fullPivoting = false);
+
+    /**
+     * Transforms mat into its reduced Echelon form in place, without
+     * temporary copies of the matrix. No row operations are recorded.
+     * @param mat Matrix, which is the reduced Echelon form at return.
+     * @param fullPivoting If true, pivot is chosen following to pivots abs-max. If false, first non-zero pivot is taken.
+     */
+    static void reduced_echelon_inplace(Matrix<double>& mat, bool fullPivoting = false);
+
+private:
+    // rowOperations may be null, then nothing is recorded
+    static void echelonInPlace(Matrix<double>& mat, std::vector<Multiplier::RowOperation>* rowOperations, bool fullPivoting);
+    static void reducedEchelonInPlace(Matrix<double>& mat, std::vector<Multiplier::RowOperation>* rowOperations, bool fullPivoting);
+
+    static void expandRowOperations(const std::vector<Multiplier::RowOperation>& compact, size_t m, std::vector<Matrix<double>>& rowOperations);
 };
 
 // Algorithm described in
 // http://stattrek.com/matrix-algebra/echelon-transform.aspx#MatrixA
 
 template <class T>
-Matrix<double> Transformation::echelon(const Matrix<T>& mat)
+Matrix<double> Transformation::echelon(const Matrix<T>& mat, bool fullPivoting)
 {
-    std::vector<Matrix<double>> ops; // not used
-    return Transformation::echelon(mat, ops);
+    Matrix<double> ret(mat);
+    echelonInPlace(ret, nullptr, fullPivoting);
+    return ret;
 }
 
 template <class T>
-Matrix<double> Transformation::echelon(const Matrix<T>& mat, std::vector<Matrix<double>>& rowOperations, bool fullPivoting)
+Matrix<double> Transformation::echelon(const Matrix<T>& mat, std::vector<Multiplier::RowOperation>& rowOperations, bool fullPivoting)
 {
     Matrix<double> ret(mat);
+    echelonInPlace(ret, &rowOperations, fullPivoting);
+    return ret;
+}
+
+template <class T>
+Matrix<double> Transformation::echelon(const Matrix<T>& mat, std::vector<Matrix<double>>& rowOperations, bool fullPivoting)
+{
+    std::vector<Multiplier::RowOperation> compact;
+    Matrix<double>                        ret = echelon(mat, compact, fullPivoting);
+    expandRowOperations(compact, mat.rows(), rowOperations);
+    return ret;
+}
+
+inline void Transformation::echelonInPlace(Matrix<double>& ret, std::vector<Multiplier::RowOperation>* rowOperations, bool fullPivoting)
+{
+    std::vector<size_t> rows;
+    std::vector<double> factors;
 
     size_t processingRow = 0;
     for (size_t n = 0; n < ret.cols(); n++)
@@ -115,52 +173,81 @@ Matrix<double> Transformation::echelon(const Matrix<T>& mat, std::vector<Matrix<
             {
                 ret.swapRows(processingRow, pivotRow); // move pivot up
 
-                rowOperations.push_back(Multiplier::swapRow(ret, processingRow, pivotRow));
+                if (rowOperations)
+                    rowOperations->push_back(Multiplier::RowOperation(Multiplier::RowOperation::SwapRows, processingRow, pivotRow, 1.0));
             }
 
-            // adapt pivot line
-            double pivotElement   = ret(processingRow, n);
-            auto   pivotRow       = ret.row(processingRow);
-            auto   scaledPivotRow = pivotRow * (1 / pivotElement);
-            ret.setRow(processingRow, scaledPivotRow);
-            rowOperations.push_back(Multiplier::multiplyRow(ret, 1.0 / pivotElement, processingRow));
+            // adapt pivot line. Entries left of column n are zero.
+            double pivotElement = ret(processingRow, n);
+            Kernels::scaleRow(ret, 1.0 / pivotElement, processingRow, n);
+
+            if (rowOperations)
+                rowOperations->push_back(Multiplier::RowOperation(Multiplier::RowOperation::MultiplyRow, processingRow, processingRow, 1.0 / pivotElement));
 
             double scaledPivotElement = ret(processingRow, n); // should be always 1.0
 
             // add scaled pivot line to below rows so that elements in column n become zero
+            rows.clear();
+            factors.clear();
             for (size_t q = processingRow + 1; q < ret.rows(); q++)
             {
                 double localPivotElement = ret(q, n);
                 double localPivotFactor  = localPivotElement / scaledPivotElement * (-1);
-                auto   newLocalRow       = (scaledPivotRow * localPivotFactor) + ret.row(q);
-                ret.setRow(q, newLocalRow);
-                rowOperations.push_back(Multiplier::addProductOfRow(ret, localPivotFactor, processingRow, q));
+
+                if (rowOperations)
+                    rowOperations->push_back(Multiplier::RowOperation(Multiplier::RowOperation::AddProductRow, processingRow, q, localPivotFactor));
+
+                if (localPivotFactor != 0.0)
+                {
+                    rows.push_back(q);
+                    factors.push_back(localPivotFactor);
+                }
             }
 
+            Kernels::eliminateRows(ret, processingRow, rows, factors, n);
+
             processingRow++;
         }
     }
+}
 
+template <class T>
+Matrix<double> Transformation::reduced_echelon(const Matrix<T>& mat, bool fullPivoting)
+{
+    Matrix<double> ret(mat);
+    reducedEchelonInPlace(ret, nullptr, fullPivoting);
     return ret;
 }
 
 template <class T>
-Matrix<double> Transformation::reduced_echelon(const Matrix<T>& mat)
+Matrix<double> Transformation::reduced_echelon(const Matrix<T>& mat, std::vector<Multiplier::RowOperation>& rowOperations, bool fullPivoting)
 {
-    std::vector<Matrix<double>> rowOps; // not used
-    return reduced_echelon(mat, rowOps);
+    Matrix<double> ret(mat);
+    reducedEchelonInPlace(ret, &rowOperations, fullPivoting);
+    return ret;
 }
 
 template <class T>
 Matrix<double> Transformation::reduced_echelon(const Matrix<T>& mat, std::vector<Matrix<double>>& rowOperations, bool fullPivoting)
 {
-    Matrix<double> echMat = Transformation::echelon(mat, rowOperations, fullPivoting);
+    std::vector<Multiplier::RowOperation> compact;
+    Matrix<double>                        ret = reduced_echelon(mat, compact, fullPivoting);
+    expandRowOperations(compact, mat.rows(), rowOperations);
+    return ret;
+}
+
+inline void Transformation::reducedEchelonInPlace(Matrix<double>& echMat, std::vector<Multiplier::RowOperation>* rowOperations, bool fullPivoting)
+{
+    echelonInPlace(echMat, rowOperations, fullPivoting);
 
     if (echMat.rows() < 2)
     {
-        return echMat;
+        return;
     }
 
+    std::vector<size_t> rows;
+    std::vector<double> factors;
+
     // going from down up
     size_t processingRow = echMat.rows() - 1; // rows is min = 2!
     while (processingRow > 0)                 // when processing row is 1, the last row edited is 0 (first row)
@@ -181,22 +268,42 @@ Matrix<double> Transformation::reduced_echelon(const Matrix<T>& mat, std::vector
 
         if (nonZeroEntryFound)
         {
-            // modify rows above
+            // modify rows above. Entries left of nonZeroCol are zero.
             double pivotElement = echMat(processingRow, nonZeroCol);
 
+            rows.clear();
+            factors.clear();
             for (size_t m = 0; m < processingRow; m++)
             {
                 double rowFactor = -echMat(m, nonZeroCol) / pivotElement;
-                echMat.setRow(m, echMat.row(m) + (echMat.row(processingRow) * rowFactor));
 
-                rowOperations.push_back(Multiplier::addProductOfRow(echMat, rowFactor, processingRow, m));
+                if (rowOperations)
+                    rowOperations->push_back(Multiplier::RowOperation(Multiplier::RowOperation::AddProductRow, processingRow, m, rowFactor));
+
+                if (rowFactor != 0.0)
+                {
+                    rows.push_back(m);
+                    factors.push_back(rowFactor);
+                }
             }
+
+            Kernels::eliminateRows(echMat, processingRow, rows, factors, nonZeroCol);
         }
 
         processingRow--;
     }
+}
 
-    return echMat;
+inline void Transformation::reduced_echelon_inplace(Matrix<double>& mat, bool fullPivoting)
+{
+    reducedEchelonInPlace(mat, nullptr, fullPivoting);
+}
+
+inline void Transformation::expandRowOperations(const std::vector<Multiplier::RowOperation>& compact, size_t m, std::vector<Matrix<double>>& rowOperations)
+{
+    rowOperations.reserve(rowOperations.size() + compact.size());
+    for (const Multiplier::RowOperation& op : compact)
+        rowOperations.push_back(Multiplier::toMatrix(op, m));
 }
 
 #endif //MY_TRANSFORMATION_H
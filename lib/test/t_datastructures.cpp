@@ -711,3 +711,49 @@ TEST(BST, MinMax)
     delete bst;
     delete emptyBST;
 }
+
+TEST(KdTree, Nearest)
+{
+    // duplicates and a coarse grid produce ties and identical split values
+    Matrix<double> points = Matrix<double>::random(3, 2000, -10.0, 10.0);
+    for (size_t k = 0; k < 200; k++)
+        for (size_t i = 0; i < 3; i++)
+            points(i, 1000 + k) = std::round(points(i, k));
+
+    KdTree tree(points, 4);
+    ASSERT_EQ(2000, tree.size());
+
+    Matrix<double> queries = Matrix<double>::random(3, 300, -12.0, 12.0);
+    std::vector<size_t> indices;
+    std::vector<double> distances2;
+    tree.nearest(queries, indices, distances2, std::numeric_limits<double>::infinity(), 3);
+
+    for (size_t q = 0; q < queries.cols(); q++)
+    {
+        double query[3] = {queries(0, q), queries(1, q), queries(2, q)};
+
+        // brute force
+        std::vector<double> all(points.cols());
+        for (size_t k = 0; k < points.cols(); k++)
+            all[k] = std::pow(points(0, k) - query[0], 2) + std::pow(points(1, k) - query[1], 2) + std::pow(points(2, k) - query[2], 2);
+        std::vector<double> sorted = all;
+        std::sort(sorted.begin(), sorted.end());
+
+        ASSERT_DOUBLE_EQ(sorted[0], distances2[q]);
+        ASSERT_DOUBLE_EQ(sorted[0], all[indices[q]]);
+
+        std::vector<size_t> knn = tree.nearestK(query, 10);
+        ASSERT_EQ(10, knn.size());
+        for (size_t k = 0; k < 10; k++)
+            ASSERT_DOUBLE_EQ(sorted[k], all[knn[k]]);
+
+        // a radius, which excludes the nearest point
+        size_t index;
+        double d2;
+        ASSERT_FALSE(tree.nearest(query, index, d2, sorted[0] * 0.99));
+        ASSERT_EQ(tree.size(), index);
+    }
+
+    ASSERT_EQ(2000, tree.nearestK(queries.data(), 5000).size());
+    ASSERT_THROW(KdTree(Matrix<double>(2, 5)), InvalidInputException);
+}
@@ -264,7 +264,7 @@ TEST(Decomposition, EigenvalueNonSymmetricLargest)
     ASSERT_TRUE(sollEigenVec.compare(sigEigenPair.V));
 
 
-    // This calls also the power iteration
+    // This calls the Francis QR algorithm
     std::vector<Decomposition::EigenPair> eigenPair = Decomposition::eigen(m);
 
     ASSERT_TRUE( eigenPair.at(0).Valid );
@@ -272,6 +272,507 @@ TEST(Decomposition, EigenvalueNonSymmetricLargest)
     ASSERT_TRUE(sollEigenVec.compare(eigenPair.at(0).V));
 }
 
+TEST(Decomposition, EigenvalueNonSymmetricAll)
+{
+    for( int k = 0; k < 50; k++ )
+    {
+        // real Eigen values: similar to a diagonal matrix
+        auto d = Matrix<double>::identity(6);
+        for( size_t i = 0; i < 6; i++ )
+            d(i, i) = static_cast<double>(i) - 2.5;
+        auto s = Matrix<double>::random(6, 6, -1.0, 1.0) + Matrix<double>::identity(6) * 4.0;
+        auto m = s * d * s.inverted();
+
+        std::vector<Decomposition::EigenPair> eig = Decomposition::eigen(m);
+        ASSERT_EQ(6, eig.size());
+
+        for( size_t i = 0; i < eig.size(); i++ )
+        {
+            ASSERT_TRUE( eig.at(i).Valid );
+            ASSERT_NEAR( eig.at(i).L, 2.5 - static_cast<double>(i), 0.000001 );
+            ASSERT_TRUE( (m * eig.at(i).V).compare( eig.at(i).L * eig.at(i).V, true, 0.000001 ) );
+        }
+    }
+}
+
+TEST(Decomposition, EigenComplex)
+{
+    // rotation by 90 degree around z, scaled along z
+    double rotData[] = {0,-1,0,  1,0,0,  0,0,2};
+    std::vector<Decomposition::ComplexEigenPair> rot = Decomposition::eigenComplex(Matrix<double>(3,3,rotData));
+    ASSERT_EQ(3, rot.size());
+
+    size_t nbrComplex = 0;
+    for( const Decomposition::ComplexEigenPair& p : rot )
+    {
+        ASSERT_TRUE( p.Valid );
+        if( p.LImag != 0.0 )
+        {
+            ASSERT_NEAR( p.LReal, 0.0, 0.000001 );
+            ASSERT_NEAR( std::abs(p.LImag), 1.0, 0.000001 );
+            nbrComplex++;
+        }
+        else
+        {
+            ASSERT_NEAR( p.LReal, 2.0, 0.000001 );
+        }
+    }
+    ASSERT_EQ(2, nbrComplex);
+
+    for( int k = 0; k < 50; k++ )
+    {
+        size_t n = 3 + static_cast<size_t>(k % 8);
+        auto m = Matrix<double>::random(n, n, -10.0, 10.0);
+
+        std::vector<Decomposition::ComplexEigenPair> eig = Decomposition::eigenComplex(m);
+        ASSERT_EQ(n, eig.size());
+
+        double sumReal = 0.0;
+        double sumImag = 0.0;
+        for( const Decomposition::ComplexEigenPair& p : eig )
+        {
+            ASSERT_TRUE( p.Valid );
+
+            // m * (vr + i*vi) = (lr + i*li) * (vr + i*vi)
+            ASSERT_TRUE( (m * p.VReal).compare( p.LReal * p.VReal - p.LImag * p.VImag, true, 0.000001 ) );
+            ASSERT_TRUE( (m * p.VImag).compare( p.LImag * p.VReal + p.LReal * p.VImag, true, 0.000001 ) );
+            ASSERT_NEAR( std::sqrt( (p.VReal.transpose() * p.VReal)(0,0) + (p.VImag.transpose() * p.VImag)(0,0) ), 1.0, 0.000001 );
+
+            sumReal += p.LReal;
+            sumImag += p.LImag;
+        }
+
+        // trace is the sum of the Eigen values, which come in conjugate pairs
+        double trace = 0.0;
+        for( size_t i = 0; i < n; i++ )
+            trace += m(i, i);
+        ASSERT_NEAR( sumReal, trace, 0.000001 );
+        ASSERT_NEAR( sumImag, 0.0, 0.000001 );
+    }
+}
+
+TEST(Decomposition, Hessenberg)
+{
+    for( int k = 0; k < 20; k++ )
+    {
+        size_t n = 2 + static_cast<size_t>(k);
+        auto m = Matrix<double>::random(n, n, -10.0, 10.0);
+
+        Decomposition::HessenbergResult res = Decomposition::hessenberg(m);
+
+        for( size_t i = 0; i < n; i++ )
+            for( size_t j = 0; j + 1 < i; j++ )
+                ASSERT_EQ( res.H(i, j), 0.0 );
+
+        ASSERT_TRUE( (res.Q.transpose() * res.Q).compare( Matrix<double>::identity(n), true, 0.000001 ) );
+        ASSERT_TRUE( (res.Q * res.H * res.Q.transpose()).compare( m, true, 0.000001 ) );
+    }
+}
+
+TEST(Decomposition, Tridiagonalization)
+{
+    for( int k = 0; k < 20; k++ )
+    {
+        size_t n = 1 + static_cast<size_t>(k);
+        auto m = Matrix<double>::random(n, n, -10.0, 10.0);
+        m = m + m.transpose();
+
+        Decomposition::TridiagonalResult res = Decomposition::tridiagonalization(m);
+        ASSERT_EQ(n, res.Diagonal.size());
+        ASSERT_EQ(n - 1, res.OffDiagonal.size());
+
+        auto t = Matrix<double>(n, n);
+        t.fill(0.0);
+        for( size_t i = 0; i < n; i++ )
+            t(i, i) = res.Diagonal.at(i);
+        for( size_t i = 0; i + 1 < n; i++ )
+        {
+            t(i + 1, i) = res.OffDiagonal.at(i);
+            t(i, i + 1) = res.OffDiagonal.at(i);
+        }
+
+        ASSERT_TRUE( (res.Q.transpose() * res.Q).compare( Matrix<double>::identity(n), true, 0.000001 ) );
+        ASSERT_TRUE( (res.Q * t * res.Q.transpose()).compare( m, true, 0.000001 ) );
+    }
+}
+
+TEST(Decomposition, Schur)
+{
+    for( int k = 0; k < 20; k++ )
+    {
+        size_t n = 3 + static_cast<size_t>(k);
+        auto m = Matrix<double>::random(n, n, -10.0, 10.0);
+
+        Decomposition::SchurResult res = Decomposition::schur(m);
+        ASSERT_TRUE( res.Converged );
+
+        // quasi upper triangle: 2x2 blocks do not touch each other
+        for( size_t i = 1; i < n; i++ )
+        {
+            for( size_t j = 0; j + 1 < i; j++ )
+                ASSERT_EQ( res.T(i, j), 0.0 );
+
+            if( i + 1 < n )
+            {
+                ASSERT_TRUE( res.T(i, i - 1) == 0.0 || res.T(i + 1, i) == 0.0 );
+            }
+        }
+
+        ASSERT_TRUE( (res.Q.transpose() * res.Q).compare( Matrix<double>::identity(n), true, 0.000001 ) );
+        ASSERT_TRUE( (res.Q * res.T * res.Q.transpose()).compare( m, true, 0.000001 ) );
+    }
+}
+
+TEST(Decomposition, QRAlgorithmLarge)
+{
+    size_t n = 150;
+    auto m = Matrix<double>::random(n, n, -1.0, 1.0);
+    m = m + m.transpose();
+
+    std::vector<Decomposition::EigenPair> eig = Decomposition::qrAlgorithm(m, 30, std::numeric_limits<double>::epsilon());
+    ASSERT_EQ(n, eig.size());
+
+    double trace = 0.0;
+    double sum   = 0.0;
+    for( size_t i = 0; i < n; i++ )
+    {
+        const Decomposition::EigenPair& ep = eig.at(i);
+        ASSERT_TRUE( ep.Valid );
+        ASSERT_TRUE( (m * ep.V).compare( ep.L * ep.V, true, 0.000001 ) );
+
+        trace += m(i, i);
+        sum   += ep.L;
+    }
+    ASSERT_NEAR( trace, sum, 0.000001 );
+}
+
+TEST(Decomposition, SymmetricEigenDivideAndConquer)
+{
+    for( int k = 0; k < 12; k++ )
+    {
+        size_t n = 1 + static_cast<size_t>(k * k * 2);
+        auto m = Matrix<double>::random(n, n, -10.0, 10.0);
+        m = m + m.transpose();
+
+        Decomposition::SymmetricEigenResult res = Decomposition::symmetricEigen(m);
+        ASSERT_TRUE( res.Valid );
+        ASSERT_EQ(n, res.Values.size());
+        ASSERT_TRUE( std::is_sorted(res.Values.begin(), res.Values.end()) );
+
+        auto d = Matrix<double>(n, n);
+        d.fill(0.0);
+        for( size_t i = 0; i < n; i++ )
+            d(i, i) = res.Values.at(i);
+
+        ASSERT_TRUE( (m * res.Vectors).compare( res.Vectors * d, true, 0.000001 ) );
+        ASSERT_TRUE( (res.Vectors.transpose() * res.Vectors).compare( Matrix<double>::identity(n), true, 0.000001 ) );
+
+        // Eigen values only
+        Decomposition::SymmetricEigenResult values = Decomposition::symmetricEigen(m, false);
+        ASSERT_TRUE( values.Valid );
+        for( size_t i = 0; i < n; i++ )
+            ASSERT_NEAR( values.Values.at(i), res.Values.at(i), 0.000001 );
+    }
+}
+
+TEST(Decomposition, SymmetricEigenThreads)
+{
+    // the tridiagonalization and the back transformation follow nbrOfThreads
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+
+    size_t n = 400;
+    auto m = Matrix<double>::random(n, n, -1.0, 1.0);
+    m = m + m.transpose();
+
+    for( bool computeVectors : {true, false} )
+    {
+        Parallel::ThreadStatisticScope stats;
+        Decomposition::SymmetricEigenResult res = Decomposition::symmetricEigen(m, computeVectors, 1);
+        ASSERT_TRUE( res.Valid );
+        ASSERT_EQ( 0, stats.startedThreads() );
+    }
+
+    Parallel::ThreadStatisticScope stats;
+    Decomposition::symmetricEigen(m, true, 2);
+    ASSERT_LE( stats.peakThreads(), 2 );
+}
+
+TEST(Decomposition, SymmetricEigenEmpty)
+{
+    Matrix<double> empty(0, 0);
+
+    Decomposition::SymmetricEigenResult res = Decomposition::symmetricEigen(empty);
+    ASSERT_TRUE( res.Valid );
+    ASSERT_TRUE( res.Values.empty() );
+    ASSERT_TRUE( Decomposition::symmetricEigen(empty, false).Values.empty() );
+    ASSERT_TRUE( Decomposition::eigen(empty).empty() );
+}
+
+TEST(Decomposition, SymmetricEigenDeflation)
+{
+    // multiple Eigen values and rank deficient matrices deflate most of the merges
+    size_t n = 150;
+    auto ones = Matrix<double>(n, n);
+    ones.fill(1.0);
+
+    auto repeated = Matrix<double>(n, n);
+    repeated.fill(0.0);
+    for( size_t i = 0; i < n; i++ )
+    {
+        repeated(i, i) = static_cast<double>(i % 3);
+        if( i + 1 < n )
+        {
+            repeated(i, i + 1) = 0.000000000001;
+            repeated(i + 1, i) = 0.000000000001;
+        }
+    }
+
+    auto b = Matrix<double>::random(n, 4, -1.0, 1.0);
+    std::vector<Matrix<double>> mats = { ones, repeated, b * b.transpose(), Matrix<double>::identity(n) };
+
+    for( const Matrix<double>& m : mats )
+    {
+        Decomposition::SymmetricEigenResult res = Decomposition::symmetricEigen(m, true, 3);
+        ASSERT_TRUE( res.Valid );
+
+        for( size_t i = 0; i < n; i++ )
+        {
+            Matrix<double> v = res.Vectors.column(i);
+            ASSERT_TRUE( (m * v).compare( res.Values.at(i) * v, true, 0.000001 ) );
+        }
+        ASSERT_TRUE( (res.Vectors.transpose() * res.Vectors).compare( Matrix<double>::identity(n), true, 0.000001 ) );
+    }
+
+    Decomposition::SymmetricEigenResult onesRes = Decomposition::symmetricEigen(ones);
+    ASSERT_NEAR( onesRes.Values.back(), static_cast<double>(n), 0.000001 );
+    ASSERT_NEAR( onesRes.Values.front(), 0.0, 0.000001 );
+}
+
+TEST(Decomposition, SubspaceIteration)
+{
+    // A = Q * D * Q' with four dominant Eigen values
+    size_t n = 80;
+    auto r = Matrix<double>::random(n, n, -1.0, 1.0);
+    Matrix<double> q = Decomposition::symmetricEigen(r + r.transpose()).Vectors;
+    auto d = Matrix<double>(n, n);
+    d.fill(0.0);
+    for( size_t i = 0; i < n; i++ )
+        d(i, i) = -10.0 + 20.0 * i / n;
+    double dominant[] = {100.0, -90.0, 80.0, 70.0};
+    for( size_t i = 0; i < 4; i++ )
+        d(i * 7, i * 7) = dominant[i];
+    Matrix<double> a = q * d * q.transpose();
+    a = 0.5 * (a + a.transpose());
+
+    std::vector<Decomposition::EigenPair> pairs = Decomposition::subspaceIteration(a, 4, std::vector<Decomposition::EigenPair>(), 1000, 1e-10, 3);
+    ASSERT_EQ(4, pairs.size());
+    for( size_t s = 0; s < 4; s++ )
+    {
+        ASSERT_TRUE( pairs.at(s).Valid );
+        ASSERT_NEAR( pairs.at(s).L, dominant[s], 0.000001 );
+        ASSERT_NEAR( pairs.at(s).V.norm(), 1.0, 0.000001 );
+        ASSERT_TRUE( (a * pairs.at(s).V).compare( pairs.at(s).L * pairs.at(s).V, true, 0.00001 ) );
+    }
+
+    // warm start: the Eigen vectors of the unchanged matrix converge in one step
+    std::vector<Decomposition::EigenPair> again = Decomposition::subspaceIteration(a, 4, pairs, 1);
+    for( size_t s = 0; s < 4; s++ )
+    {
+        ASSERT_TRUE( again.at(s).Valid );
+        ASSERT_NEAR( again.at(s).L, dominant[s], 0.000001 );
+    }
+
+    // slowly changing problem: warm start from the previous Eigen vectors
+    auto e = Matrix<double>::random(n, n, -0.001, 0.001);
+    Matrix<double> b = a + e + e.transpose();
+    std::vector<Decomposition::EigenPair> warm = Decomposition::subspaceIteration(b, 4, pairs, 15);
+    Decomposition::SymmetricEigenResult all = Decomposition::symmetricEigen(b);
+    for( size_t s = 0; s < 4; s++ )
+    {
+        ASSERT_TRUE( warm.at(s).Valid );
+        ASSERT_TRUE( (b * warm.at(s).V).compare( warm.at(s).L * warm.at(s).V, true, 0.00001 ) );
+    }
+    ASSERT_NEAR( warm.at(0).L, all.Values.back(), 0.000001 );
+    ASSERT_NEAR( warm.at(1).L, all.Values.front(), 0.000001 );
+
+    // whole spectrum of a small matrix
+    auto small = Matrix<double>::random(5, 5, -10.0, 10.0);
+    small = small + small.transpose();
+    std::vector<Decomposition::EigenPair> full = Decomposition::subspaceIteration(small, 5);
+    for( const Decomposition::EigenPair& ep : full )
+    {
+        ASSERT_TRUE( ep.Valid );
+        ASSERT_TRUE( (small * ep.V).compare( ep.L * ep.V, true, 0.00001 ) );
+    }
+
+    ASSERT_THROW( Decomposition::subspaceIteration(small, 6), InvalidInputException );
+}
+
+TEST(Decomposition, Lanczos)
+{
+    size_t sizes[] = {5, 40, 150};
+    for( size_t n : sizes )
+    {
+        auto m = Matrix<double>::random(n, n, -10.0, 10.0);
+        m = m + m.transpose();
+        Decomposition::SymmetricEigenResult all = Decomposition::symmetricEigen(m, false);
+
+        size_t k = std::min<size_t>(n, 6);
+        for( bool largest : {true, false} )
+        {
+            std::vector<Decomposition::EigenPair> pairs = Decomposition::lanczos(m, k, largest, 1e-10, 2);
+            ASSERT_EQ(k, pairs.size());
+            for( size_t s = 0; s < k; s++ )
+            {
+                const Decomposition::EigenPair& ep = pairs.at(s);
+                double expected = largest ? all.Values.at(n - 1 - s) : all.Values.at(s);
+                ASSERT_TRUE( ep.Valid );
+                ASSERT_NEAR( ep.L, expected, 0.000001 );
+                ASSERT_NEAR( ep.V.norm(), 1.0, 0.000001 );
+                ASSERT_TRUE( (m * ep.V).compare( ep.L * ep.V, true, 0.00001 ) );
+            }
+        }
+    }
+}
+
+TEST(Decomposition, LanczosOperator)
+{
+    // matrix-free operator: diagonal matrix with a few separated Eigen values at both ends
+    size_t n = 20000;
+    std::vector<double> diag(n);
+    for( size_t i = 0; i < n; i++ )
+        diag[i] = 1.0 + static_cast<double>(i % 1000) / 1000.0;
+    for( size_t i = 0; i < 4; i++ )
+    {
+        diag[i * 997 + 3]  = 10.0 - i;
+        diag[i * 991 + 11] = -5.0 + i;
+    }
+
+    size_t nbrOfCalls = 0;
+    auto op = [&diag, &nbrOfCalls](const Matrix<double>& x, Matrix<double>& y) {
+        nbrOfCalls++;
+        for( size_t i = 0; i < diag.size(); i++ )
+            y(i, 0) = diag[i] * x(i, 0);
+    };
+
+    std::vector<Decomposition::EigenPair> top = Decomposition::lanczosOperator(op, n, 4, true);
+    std::vector<Decomposition::EigenPair> bottom = Decomposition::lanczosOperator(op, n, 4, false);
+    ASSERT_LT(nbrOfCalls, n);
+
+    for( size_t s = 0; s < 4; s++ )
+    {
+        ASSERT_TRUE( top.at(s).Valid );
+        ASSERT_NEAR( top.at(s).L, 10.0 - s, 0.000001 );
+        ASSERT_NEAR( std::abs(top.at(s).V(s * 997 + 3, 0)), 1.0, 0.000001 );
+
+        ASSERT_TRUE( bottom.at(s).Valid );
+        ASSERT_NEAR( bottom.at(s).L, -5.0 + s, 0.000001 );
+        ASSERT_NEAR( std::abs(bottom.at(s).V(s * 991 + 11, 0)), 1.0, 0.000001 );
+    }
+
+    ASSERT_THROW( Decomposition::lanczosOperator(op, n, n + 1), InvalidInputException );
+    ASSERT_TRUE( Decomposition::lanczosOperator(op, n, 0).empty() );
+}
+
+// Example from https://en.wikipedia.org/wiki/Rayleigh_quotient_iteration
+TEST(Decomposition, RayleighIteration)
+{
+    double mat_data[] = {1,2,3,  1,2,1,  3,2,1};
+    auto m = Matrix<double>(3,3,mat_data);
+
+    Matrix<double> initVec(3,1);
+    initVec.fill(1.0);
+
+    Decomposition::EigenPair ep = Decomposition::rayleighIteration(m, initVec, 200.0, 50, std::numeric_limits<double>::epsilon());
+
+    ASSERT_TRUE( ep.Valid );
+    ASSERT_NEAR(ep.L, 3 + std::sqrt(5.0), 0.000001);
+    ASSERT_TRUE( (m * ep.V).compare( ep.L * ep.V, true, 0.000001 ) );
+}
+
+TEST(Decomposition, RayleighIterationBatch)
+{
+    for( int k = 0; k < 20; k++ )
+    {
+        auto m = Matrix<double>::random(6, 6, -10.0, 10.0);
+        m = m * m.transpose();
+
+        std::vector<Decomposition::EigenPair> eig = Decomposition::eigen(m);
+
+        // disturb the Eigen pairs
+        std::vector<Decomposition::EigenPair> disturbed;
+        for( const Decomposition::EigenPair& ep : eig )
+            disturbed.push_back( Decomposition::EigenPair(ep.V + Matrix<double>::random(6, 1, -0.01, 0.01), ep.L * 1.001, false) );
+
+        std::vector<Decomposition::EigenPair> refined = Decomposition::rayleighIteration(m, disturbed, 50, 1e-12, 3);
+        ASSERT_EQ(eig.size(), refined.size());
+
+        for( size_t i = 0; i < refined.size(); i++ )
+        {
+            const Decomposition::EigenPair& ep = refined.at(i);
+            ASSERT_TRUE( ep.Valid );
+            ASSERT_TRUE( (m * ep.V).compare( ep.L * ep.V, true, 0.00001 ) );
+
+            if( eig.at(i).Valid )
+            {
+                ASSERT_NEAR( ep.L, eig.at(i).L, 0.00001 * std::abs(eig.at(i).L) + 0.00001 );
+            }
+        }
+    }
+}
+
+TEST(Decomposition, RayleighIterationBatchThreads)
+{
+    // the batch is the only parallel loop, the LU kernels of the pairs stay serial
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+
+    size_t n = 500;
+    auto   m = Matrix<double>::random(n, n, -1.0, 1.0);
+    m        = m + m.transpose();
+
+    std::vector<Decomposition::EigenPair> start;
+    for( size_t i = 0; i < 4; i++ )
+        start.push_back( Decomposition::EigenPair(Matrix<double>::random(n, 1, -1.0, 1.0), 0.1 * i, false) );
+
+    for( size_t nbrOfThreads : {1, 4} )
+    {
+        Parallel::ThreadStatisticScope stats;
+        Decomposition::rayleighIteration(m, start, 3, 1e-12, nbrOfThreads);
+        ASSERT_EQ( nbrOfThreads - 1, stats.startedThreads() );
+        ASSERT_LE( stats.peakThreads(), nbrOfThreads );
+    }
+}
+
+TEST(Decomposition, LUPackedSolve)
+{
+    for( int k = 0; k < 100; k++ )
+    {
+        auto a = Matrix<double>::random(8, 8, -10.0, 10.0);
+        auto b = Matrix<double>::random(8, 3, -10.0, 10.0);
+
+        Decomposition::LUPackedResult lu = Decomposition::luPacked(a);
+        ASSERT_FALSE( lu.Singular );
+
+        Matrix<double> x = b;
+        Decomposition::luPackedSolveInPlace(lu.LU, lu.Pivots, x);
+
+        ASSERT_TRUE( b.compare(a * x, true, 0.000001) );
+    }
+
+    double singularData[] = {1,2,3,  2,4,6,  1,0,1};
+    ASSERT_TRUE( Decomposition::luPacked(Matrix<double>(3,3,singularData)).Singular );
+
+    // the packed kernels need a square matrix
+    Matrix<double>      tall = Matrix<double>::random(6, 3, -1.0, 1.0);
+    std::vector<size_t> pivots;
+    size_t              nbrRowSwaps;
+    ASSERT_THROW( Decomposition::luPackedInPlace(tall, pivots, nbrRowSwaps), SquareMatrixException );
+
+    Matrix<double> rhs = Matrix<double>::random(6, 1, -1.0, 1.0);
+    pivots.assign(6, 0);
+    ASSERT_THROW( Decomposition::luPackedSolveInPlace(tall, pivots, rhs), SquareMatrixException );
+}
+
 /*
 // Example from https://en.wikipedia.org/wiki/Rayleigh_quotient_iteration
 TEST(Decomposition, EigenvalueAllNonSymmetric)
@@ -393,6 +894,59 @@ TEST(Decomposition, QRBatchTesting)
     }
 }
 
+TEST(Decomposition, QRColumnPivoting)
+{
+    for( int k = 0; k < 50; k++ )
+    {
+        // 7 x 5 matrix of rank 3
+        auto a = Matrix<double>::random(7, 3, -10.0, 10.0) * Matrix<double>::random(3, 5, -10.0, 10.0);
+
+        Decomposition::QRCPResult res = Decomposition::qrColumnPivoting(a);
+        ASSERT_EQ(res.Rank, 3);
+        ASSERT_TRUE(res.Q.isOrthogonal(0.00000001));
+
+        // A * P = Q * R
+        Matrix<double> ap(a.rows(), a.cols());
+        for( size_t j = 0; j < a.cols(); j++ )
+            ap.setColumn(j, a.column(res.Permutation.at(j)));
+
+        ASSERT_TRUE(ap.compare(res.Q * res.R, true, 0.0000001));
+
+        // decreasing diagonal elements in R
+        for( size_t j = 1; j < a.cols(); j++ )
+            ASSERT_LE(std::abs(res.R(j, j)), std::abs(res.R(j - 1, j - 1)) * (1.0 + 1e-12));
+    }
+}
+
+TEST(Decomposition, RangeAndNullSpace)
+{
+    for( int k = 0; k < 50; k++ )
+    {
+        // 6 x 8 matrix of rank 4
+        auto a = Matrix<double>::random(6, 4, -10.0, 10.0) * Matrix<double>::random(4, 8, -10.0, 10.0);
+
+        Matrix<double> range = Decomposition::rangeSpace(a);
+        Matrix<double> null  = Decomposition::nullSpace(a);
+
+        ASSERT_EQ(range.rows(), 6);
+        ASSERT_EQ(range.cols(), 4);
+        ASSERT_EQ(null.rows(), 8);
+        ASSERT_EQ(null.cols(), 4);
+
+        // orthonormal columns
+        ASSERT_TRUE((range.transpose() * range).compare(Matrix<double>::identity(4), true, 0.00000001));
+        ASSERT_TRUE((null.transpose() * null).compare(Matrix<double>::identity(4), true, 0.00000001));
+
+        // a maps the null space to zero
+        Matrix<double> zero(6, 4);
+        zero.fill(0.0);
+        ASSERT_TRUE((a * null).compare(zero, true, 0.000001));
+
+        // columns of a lie in the range: projection does not change them
+        ASSERT_TRUE((range * (range.transpose() * a)).compare(a, true, 0.000001));
+    }
+}
+
 TEST(Decomposition, QRSignChanger)
 {
     double matData[] = {0.8147, 0.0975, 0.1576,
@@ -1066,170 +1620,320 @@ void svdBatchTesting(size_t nTests, size_t matSize, std::atomic<size_t>& cnt)
     }
 }
 
-TEST(Decomposition, SVDGolubKahanBatch)
+TEST(Decomposition, SVDGolubKahanNonSquareAndGraded)
 {
-    std::vector<size_t> sizes = {2, 3, 4, 5, 6, 7, 8, 9, 10, 13, 15, 20, 25, 30};
-    std::vector< std::thread> thr;
-    std::atomic<size_t> cnt(0);
-    size_t total = 0;
-    std::for_each(sizes.begin(), sizes.end(), [&total, &thr, &cnt](size_t s) mutable {
-        size_t nT = 60000/(std::pow(s,3));
-        total += nT;
-        std::cout << "Start SVD batch test with matrix size " << s << " and number " << nT << std::endl;
-        thr.push_back( std::thread(svdBatchTesting, nT, s, std::ref(cnt)) );
-    });
-
-    while(true)
+    std::vector<std::pair<size_t, size_t>> sizes = {{40, 25}, {25, 40}, {1, 7}, {7, 1}, {90, 90}};
+    for (const std::pair<size_t, size_t>& size : sizes)
     {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        double progress = (double)(cnt) / total;
-        std::cout << "SVD Batch testing: " << progress * 100.0 << " %" << std::endl;
-        if(progress > 0.9999)
-            break;
+        auto a = Matrix<double>::random(size.first, size.second, -1.0, 1.0);
+        Decomposition::SVDResult res = Decomposition::svdGolubKahan(a);
+
+        ASSERT_EQ(size.first, res.U.rows());
+        ASSERT_EQ(size.second, res.V.rows());
+        ASSERT_TRUE( res.U.isOrthogonal(1e-10) );
+        ASSERT_TRUE( res.V.isOrthogonal(1e-10) );
+        ASSERT_TRUE( a.compare(res.U * res.S * res.V.transpose(), true, 1e-10 ) );
+        for (size_t k = 1; k < std::min(size.first, size.second); k++)
+            ASSERT_GE(res.S(k - 1, k - 1), res.S(k, k));
     }
 
-    std::for_each(thr.begin(), thr.end(), [](std::thread& t) mutable {
-        t.join();
-    });
-}
+    // graded bidiagonal matrix: the product of the singular values is |det(B)| and
+    // the smallest ones are computed to high relative accuracy
+    size_t n = 8;
+    Matrix<double> b(n, n);
+    b.fill(0.0);
+    double det = 1.0;
+    for (size_t k = 0; k < n; k++)
+    {
+        b(k, k) = std::pow(10.0, -2.0 * k);
+        det *= b(k, k);
+        if (k + 1 < n)
+            b(k, k + 1) = std::pow(10.0, -2.0 * k - 1.0);
+    }
 
+    Matrix<double> bCopy = b;
+    Decomposition::SVDResult res = Decomposition::svdGolubKahanBidiagonal(b);
+    double prod = 1.0;
+    for (size_t k = 0; k < n; k++)
+        prod *= res.S(k, k);
 
+    ASSERT_NEAR(prod / det, 1.0, 1e-12);
+    ASSERT_TRUE( bCopy.compare(res.U * res.S * res.V.transpose(), true, 1e-12 ) );
+}
 
-TEST(Decomposition, SVDGolubKahanMatrixCheckIdentity)
+TEST(Decomposition, SVDModes)
 {
-    size_t cols = 5;
-    Matrix<double> m = Matrix<double>::identity(cols);
-
-    size_t p, q;
-    Decomposition::svdCheckMatrixGolubKahan(m,p,q);
-
-    ASSERT_EQ(q,cols);
-    ASSERT_EQ(p,0);
-
-
-    // one entry
-    cols = 1;
-    m = Matrix<double>::identity(cols);
-
-    Decomposition::svdCheckMatrixGolubKahan(m,p,q);
-
-    ASSERT_EQ(q,cols);
-    ASSERT_EQ(p,0);
+    // square, wide, and tall enough for the QR first path
+    std::vector<std::pair<size_t, size_t>> sizes = {{12, 12}, {9, 15}, {20, 13}, {60, 7}};
+    for (const std::pair<size_t, size_t>& size : sizes)
+    {
+        size_t m = size.first;
+        size_t n = size.second;
+        size_t k = std::min(m, n);
+        auto   a = Matrix<double>::random(m, n, -1.0, 1.0);
+
+        Decomposition::SVDResult full = Decomposition::svd(a);
+        ASSERT_EQ(m, full.U.rows());
+        ASSERT_EQ(m, full.U.cols());
+        ASSERT_EQ(m, full.S.rows());
+        ASSERT_EQ(n, full.S.cols());
+        ASSERT_TRUE( full.U.isOrthogonal(1e-10) );
+        ASSERT_TRUE( full.V.isOrthogonal(1e-10) );
+        ASSERT_TRUE( a.compare(full.U * full.S * full.V.transpose(), true, 1e-10) );
+
+        Decomposition::SVDResult thin = Decomposition::svd(a, Decomposition::ThinSVD);
+        ASSERT_EQ(m, thin.U.rows());
+        ASSERT_EQ(k, thin.U.cols());
+        ASSERT_EQ(k, thin.S.rows());
+        ASSERT_EQ(k, thin.S.cols());
+        ASSERT_EQ(n, thin.V.rows());
+        ASSERT_EQ(k, thin.V.cols());
+        ASSERT_TRUE( Matrix<double>::identity(k).compare(thin.U.transpose() * thin.U, true, 1e-10) );
+        ASSERT_TRUE( Matrix<double>::identity(k).compare(thin.V.transpose() * thin.V, true, 1e-10) );
+        ASSERT_TRUE( a.compare(thin.U * thin.S * thin.V.transpose(), true, 1e-10) );
+
+        std::vector<double> values = Decomposition::singularValues(a);
+        ASSERT_EQ(k, values.size());
+        for (size_t i = 0; i < k; i++)
+            ASSERT_NEAR(full.S(i, i), values.at(i), 1e-10);
+
+        Decomposition::SVDResult left = Decomposition::svd(a, Decomposition::LeftSingularVectorsOnly);
+        ASSERT_EQ(0, left.V.rows());
+        ASSERT_EQ(k, left.U.cols());
+        ASSERT_TRUE( (a * a.transpose() * left.U).compare(left.U * left.S * left.S, true, 1e-8) );
+
+        Decomposition::SVDResult right = Decomposition::svd(a, Decomposition::RightSingularVectorsOnly);
+        ASSERT_EQ(0, right.U.rows());
+        ASSERT_EQ(k, right.V.cols());
+        ASSERT_TRUE( (a.transpose() * a * right.V).compare(right.V * right.S * right.S, true, 1e-8) );
+
+        Decomposition::SVDResult valuesOnly = Decomposition::svd(a, Decomposition::SingularValuesOnly);
+        ASSERT_EQ(0, valuesOnly.U.rows());
+        ASSERT_EQ(0, valuesOnly.V.rows());
+        ASSERT_TRUE( valuesOnly.S.compare(thin.S, true, 1e-10) );
+    }
 }
 
-TEST(Decomposition, SVDGolubKahanMatrixCheckLowerIdentUpperBiag)
+TEST(Decomposition, SVDJacobi)
 {
-    size_t cols = 6;
-    Matrix<double> m = Matrix<double>::identity(cols);
-    m(0,1) = 2;
-    m(1,2) = 3;
-
-    size_t p, q;
-    Decomposition::svdCheckMatrixGolubKahan(m,p,q);
+    // odd and even number of columns, wide and tall enough for the QR first path
+    std::vector<std::pair<size_t, size_t>> sizes = {{1, 1}, {12, 12}, {9, 15}, {20, 13}, {60, 7}};
+    for (const std::pair<size_t, size_t>& size : sizes)
+    {
+        for (size_t threads : {1, 3})
+        {
+            size_t m = size.first;
+            size_t n = size.second;
+            size_t k = std::min(m, n);
+            auto   a = Matrix<double>::random(m, n, -1.0, 1.0);
+
+            Decomposition::SVDResult full = Decomposition::svdJacobi(a, Decomposition::FullSVD, threads);
+            ASSERT_EQ(m, full.S.rows());
+            ASSERT_EQ(n, full.S.cols());
+            ASSERT_TRUE( full.U.isOrthogonal(1e-10) );
+            ASSERT_TRUE( full.V.isOrthogonal(1e-10) );
+            ASSERT_TRUE( a.compare(full.U * full.S * full.V.transpose(), true, 1e-10) );
+
+            std::vector<double> values = Decomposition::singularValues(a);
+            for (size_t i = 0; i < k; i++)
+                ASSERT_NEAR(values.at(i), full.S(i, i), 1e-10);
+
+            Decomposition::SVDResult thin = Decomposition::svdJacobi(a, Decomposition::ThinSVD, threads);
+            ASSERT_EQ(k, thin.U.cols());
+            ASSERT_EQ(k, thin.V.cols());
+            ASSERT_TRUE( a.compare(thin.U * thin.S * thin.V.transpose(), true, 1e-10) );
+
+            Decomposition::SVDResult valuesOnly = Decomposition::svdJacobi(a, Decomposition::SingularValuesOnly, threads);
+            ASSERT_EQ(0, valuesOnly.U.rows());
+            ASSERT_EQ(0, valuesOnly.V.rows());
+            ASSERT_TRUE( valuesOnly.S.compare(thin.S, true, 1e-10) );
+        }
+    }
 
-    ASSERT_EQ(q,cols-3);
-    ASSERT_EQ(p,0);
+    // rank deficient: the left singular vectors are completed
+    Matrix<double> ones(7, 4);
+    ones.fill(1.0);
+    Decomposition::SVDResult rankOne = Decomposition::svdJacobi(ones);
+    ASSERT_TRUE( rankOne.U.isOrthogonal(1e-10) );
+    ASSERT_TRUE( ones.compare(rankOne.U * rankOne.S * rankOne.V.transpose(), true, 1e-10) );
+    ASSERT_NEAR(std::sqrt(28.0), rankOne.S(0, 0), 1e-12);
+
+    // graded columns A = B * D: the product of the singular values is |det(B)| * det(D),
+    // which requires the small singular values to be accurate relative to their size
+    auto b = Matrix<double>::random(5, 5, -1.0, 1.0) + Matrix<double>::identity(5) * 3.0;
+    Matrix<double> d(5, 5);
+    d.fill(0.0);
+    double detD = 1.0;
+    for (size_t i = 0; i < 5; i++)
+    {
+        d(i, i) = std::pow(10.0, -4.0 * i);
+        detD *= d(i, i);
+    }
+    Decomposition::SVDResult graded = Decomposition::svdJacobi(b * d, Decomposition::SingularValuesOnly);
+    double prod = 1.0;
+    for (size_t i = 0; i < 5; i++)
+        prod *= graded.S(i, i);
+    ASSERT_NEAR(1.0, prod / (std::abs(b.determinant()) * detD), 1e-10);
 }
 
-TEST(Decomposition, SVDGolubKahanMatrixCheckLowerIdentMiddleBiagUppestDiag)
+TEST(Decomposition, SVDJacobiThreads)
 {
-    size_t cols = 6;
-    Matrix<double> m = Matrix<double>::identity(cols);
-    m(1,2) = 3;
-
-    size_t p, q;
-    Decomposition::svdCheckMatrixGolubKahan(m,p,q);
-
-    ASSERT_EQ(q,cols-3);
-    ASSERT_EQ(p,1);
+    // the preconditioning QR of a tall matrix follows nbrOfThreads
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+    auto a = Matrix<double>::random(4000, 60, -1.0, 1.0);
+
+    Parallel::ThreadStatisticScope stats;
+    Decomposition::SVDResult res = Decomposition::svdJacobi(a, Decomposition::ThinSVD, 1);
+    ASSERT_EQ(0, stats.startedThreads());
+    ASSERT_TRUE( a.compare(res.U * res.S * res.V.transpose(), true, 1e-10) );
 }
 
-TEST(Decomposition, SVDGolubKahanMatrixCheckAllBiag)
+TEST(Decomposition, SVDRandomized)
 {
-    size_t cols = 4;
-    Matrix<double> m = Matrix<double>::identity(cols);
-    m(0,1) = 3;
-    m(1,2) = 3;
-    m(2,3) = 3;
-
-    size_t p, q;
-    Decomposition::svdCheckMatrixGolubKahan(m,p,q);
-
-    ASSERT_EQ(q,0);
-    ASSERT_EQ(p,0);
+    // rank 8 matrix with known singular values, plus a little noise
+    size_t m = 400;
+    size_t n = 150;
+    size_t r = 8;
+    auto   u = Decomposition::tsqr(Matrix<double>::random(m, r, -1.0, 1.0), true).Q;
+    auto   v = Decomposition::tsqr(Matrix<double>::random(n, r, -1.0, 1.0), true).Q;
+    Matrix<double> s(r, r);
+    s.fill(0.0);
+    for (size_t i = 0; i < r; i++)
+        s(i, i) = std::pow(2.0, 4.0 - i);
+    auto a = u * s * v.transpose() + Matrix<double>::random(m, n, -1e-9, 1e-9);
+
+    Decomposition::SVDResult res = Decomposition::svdRandomized(a, 5);
+    ASSERT_EQ(m, res.U.rows());
+    ASSERT_EQ(5, res.U.cols());
+    ASSERT_EQ(5, res.S.rows());
+    ASSERT_EQ(5, res.S.cols());
+    ASSERT_EQ(n, res.V.rows());
+    ASSERT_EQ(5, res.V.cols());
+    ASSERT_TRUE( Matrix<double>::identity(5).compare(res.U.transpose() * res.U, true, 1e-10) );
+    ASSERT_TRUE( Matrix<double>::identity(5).compare(res.V.transpose() * res.V, true, 1e-10) );
+    for (size_t i = 0; i < 5; i++)
+        ASSERT_NEAR(s(i, i), res.S(i, i), 1e-7);
+
+    // all of the rank recovers the matrix
+    Decomposition::SVDResult all = Decomposition::svdRandomized(a, r, 10, 1);
+    ASSERT_TRUE( a.compare(all.U * all.S * all.V.transpose(), true, 1e-7) );
+
+    // the streamed version with small blocks sees the same matrix
+    auto rowBlock = [&a, n](size_t firstRow, Matrix<double>& block) {
+        block.setSubMatrix(0, 0, a.subMatrix(firstRow, 0, block.rows(), n));
+    };
+    Decomposition::SVDResult streamed = Decomposition::svdRandomizedStreamed(rowBlock, m, n, 5, 10, 2, 33, 3);
+    ASSERT_TRUE( res.S.compare(streamed.S, true, 1e-10) );
+    ASSERT_TRUE( (res.U * res.S * res.V.transpose()).compare(streamed.U * streamed.S * streamed.V.transpose(), true, 1e-8) );
+
+    // slowly decaying spectrum: the dominant values are still close
+    auto b = Matrix<double>::random(120, 90, -1.0, 1.0);
+    std::vector<double> exact = Decomposition::singularValues(b);
+    Decomposition::SVDResult approx = Decomposition::svdRandomized(b, 3, 20, 4);
+    for (size_t i = 0; i < 3; i++)
+        ASSERT_NEAR(exact.at(i), approx.S(i, i), 0.05 * exact.at(i));
+
+    ASSERT_THROW(Decomposition::svdRandomized(a, 0), InvalidInputException);
+    ASSERT_THROW(Decomposition::svdRandomized(a, n + 1), InvalidInputException);
 }
 
-TEST(Decomposition, SVDGolubKahanMatrixCheckUpDiag)
+TEST(Decomposition, SVDRandomizedThreads)
 {
-    size_t cols = 4;
-    Matrix<double> m = Matrix<double>::identity(cols);
-    m(1,2) = 3;
-    m(2,3) = 3;
-
-    size_t p, q;
-    Decomposition::svdCheckMatrixGolubKahan(m,p,q);
-
-    ASSERT_EQ(q,0);
-    ASSERT_EQ(p,1);
+    // the range finder QR follows nbrOfThreads
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+    auto a = Matrix<double>::random(5000, 400, -1.0, 1.0);
+
+    Parallel::ThreadStatisticScope stats;
+    Decomposition::SVDResult res = Decomposition::svdRandomized(a, 40, 10, 1, 1);
+    ASSERT_EQ(0, stats.startedThreads());
+    ASSERT_EQ(40, res.S.rows());
 }
 
-TEST(Decomposition, SVDGolubKahanPaddingGeneral)
+TEST(Decomposition, SVDIncremental)
 {
-    for( size_t p = 0; p < 5; p++ )
+    // rank 6 matrix, which is built up column by column block
+    size_t m = 40;
+    size_t n = 90;
+    size_t r = 6;
+    auto   a = Matrix<double>::random(m, r, -1.0, 1.0) * Matrix<double>::random(r, n, -1.0, 1.0);
+
+    Decomposition::SVDResult inc = Decomposition::svd(a.subMatrix(0, 0, m, 10), Decomposition::ThinSVD);
+    inc = Decomposition::SVDResult(inc.U.subMatrix(0, 0, m, r), inc.S.subMatrix(0, 0, r, r), inc.V.subMatrix(0, 0, 10, r));
+    for (size_t c = 10; c < n; c += 16)
     {
-        for( size_t q = 0; q < 5; q++ )
-        {
-            for( size_t n = 1; n < 5; n++ )
-            {
-                Matrix<double> mat = Matrix<double>::identity(n);
-                Matrix<double> pad = Decomposition::svdPaddingRotation(mat,p,q);
-                Matrix<double> should = Matrix<double>::identity(n+q+p);
-
-                ASSERT_TRUE( pad.compare(should) );
-            }
-        }
+        size_t p = std::min<size_t>(16, n - c);
+        inc      = Decomposition::svdAppendColumns(inc, a.subMatrix(0, c, m, p));
     }
+    ASSERT_EQ(n, inc.V.rows());
+    ASSERT_EQ(r, inc.S.rows());
+    ASSERT_TRUE( Matrix<double>::identity(r).compare(inc.U.transpose() * inc.U, true, 1e-10) );
+    ASSERT_TRUE( Matrix<double>::identity(r).compare(inc.V.transpose() * inc.V, true, 1e-10) );
+    ASSERT_TRUE( a.compare(inc.U * inc.S * inc.V.transpose(), true, 1e-9) );
+
+    std::vector<double> values = Decomposition::singularValues(a);
+    for (size_t i = 0; i < r; i++)
+        ASSERT_NEAR(values.at(i), inc.S(i, i), 1e-9);
+
+    // more new columns than the complement of U has dimensions, and a larger rank
+    auto b = Matrix<double>::random(8, 30, -1.0, 1.0);
+    Decomposition::SVDResult first = Decomposition::svd(b.subMatrix(0, 0, 8, 3), Decomposition::ThinSVD);
+    Decomposition::SVDResult wide  = Decomposition::svdAppendColumns(first, b.subMatrix(0, 3, 8, 27), 8);
+    ASSERT_EQ(8, wide.S.rows());
+    ASSERT_TRUE( b.compare(wide.U * wide.S * wide.V.transpose(), true, 1e-10) );
+
+    // rows
+    Decomposition::SVDResult rows = Decomposition::svd(a.subMatrix(0, 0, 10, n), Decomposition::ThinSVD);
+    rows = Decomposition::SVDResult(rows.U.subMatrix(0, 0, 10, r), rows.S.subMatrix(0, 0, r, r), rows.V.subMatrix(0, 0, n, r));
+    rows = Decomposition::svdAppendRows(rows, a.subMatrix(10, 0, m - 10, n), 0, 3);
+    ASSERT_EQ(m, rows.U.rows());
+    ASSERT_TRUE( a.compare(rows.U * rows.S * rows.V.transpose(), true, 1e-9) );
+
+    // sliding window: remove the oldest columns
+    Decomposition::SVDResult window = Decomposition::svdRemoveColumns(inc, 0, 30);
+    ASSERT_EQ(n - 30, window.V.rows());
+    ASSERT_TRUE( Matrix<double>::identity(r).compare(window.V.transpose() * window.V, true, 1e-10) );
+    ASSERT_TRUE( a.subMatrix(0, 30, m, n - 30).compare(window.U * window.S * window.V.transpose(), true, 1e-9) );
+
+    // remove columns in the middle, leaving fewer columns than the rank
+    Decomposition::SVDResult few = Decomposition::svdRemoveColumns(inc, 2, n - 4);
+    Matrix<double> kept(m, 4);
+    kept.setSubMatrix(0, 0, a.subMatrix(0, 0, m, 2));
+    kept.setSubMatrix(0, 2, a.subMatrix(0, n - 2, m, 2));
+    ASSERT_TRUE( kept.compare(few.U * few.S * few.V.transpose(), true, 1e-9) );
+
+    ASSERT_THROW(Decomposition::svdAppendColumns(inc, Matrix<double>(m + 1, 2)), InvalidInputException);
+    ASSERT_THROW(Decomposition::svdRemoveColumns(inc, 80, 20), InvalidInputException);
+    ASSERT_THROW(Decomposition::svdAppendColumns(Decomposition::svd(a), a), InvalidInputException);
 }
 
-TEST(Decomposition, SVDGolubKahanPaddingMat)
+TEST(Decomposition, SVDGolubKahanBatch)
 {
-    double shouldData[] = {1.0, 0.0, 0.0, 0.0, 0.0,
-                           0.0, 1.5, 2.0, 0.0, 0.0,
-                           0.0, 3.0, 4.0, 0.0, 0.0,
-                           0.0, 0.0, 0.0, 1.0, 0.0,
-                           0.0, 0.0, 0.0, 0.0, 1.0};
-
-    double matData[] = { 1.5, 2.0,
-                         3.0, 4.0};
-
-    Matrix<double> should = Matrix<double>(5,5,shouldData);
-    Matrix<double> mat = Matrix<double>(2,2,matData);
+    std::vector<size_t> sizes = {2, 3, 4, 5, 6, 7, 8, 9, 10, 13, 15, 20, 25, 30};
+    std::vector< std::thread> thr;
+    std::atomic<size_t> cnt(0);
+    size_t total = 0;
+    std::for_each(sizes.begin(), sizes.end(), [&total, &thr, &cnt](size_t s) mutable {
+        size_t nT = 60000/(std::pow(s,3));
+        total += nT;
+        std::cout << "Start SVD batch test with matrix size " << s << " and number " << nT << std::endl;
+        thr.push_back( std::thread(svdBatchTesting, nT, s, std::ref(cnt)) );
+    });
 
-    Matrix<double> padded = Decomposition::svdPaddingRotation(mat, 1 , 2);
+    while(true)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        double progress = (double)(cnt) / total;
+        std::cout << "SVD Batch testing: " << progress * 100.0 << " %" << std::endl;
+        if(progress > 0.9999)
+            break;
+    }
 
-    ASSERT_TRUE( padded.compare(should) );
+    std::for_each(thr.begin(), thr.end(), [](std::thread& t) mutable {
+        t.join();
+    });
 }
 
-TEST(Decomposition, SVDGolubKahanZeroRow)
-{
-    double matData[] =    {1.0, 3.2, 0.0, 0.0, 0.0,
-                           0.0, 2.0, 1.8, 0.0, 0.0,
-                           0.0, 0.0, 0.0, 1.2, 0.0,
-                           0.0, 0.0, 0.0, 1.0, 1.4,
-                           0.0, 0.0, 0.0, 0.0, 1.0};
-
-    Matrix<double> mat = Matrix<double>(5,5,matData);
-    Matrix<double> orig = mat;
-    Matrix<double> givens = Decomposition::svdZeroRow(mat,2);
-
-    // check that the 3rd row is zero
-    for( size_t i = 0; i < 5; i++ )
-        ASSERT_FLOAT_EQ( mat(2,i), 0.0 );
 
-    ASSERT_TRUE( mat.compare(givens * orig, true, 0.000001) );
-
-    std::cout << "SVDGolubKahanZeroRow" << std::endl << mat << std::endl;
-}
 
 TEST(Decomposition, SVDGolubKahanZeroColumnStepByStep)
 {
@@ -1256,28 +1960,6 @@ TEST(Decomposition, SVDGolubKahanZeroColumnStepByStep)
     }
 }
 
-TEST(Decomposition, SVDGolubKahanZeroColumnLast)
-{
-    Matrix<double> mat = Matrix<double>(4,4, {1.0, 1.0, 0.0, 0.0,
-                                              0.0, 1.0, 1.0, 0.0,
-                                              0.0, 0.0, 1.0, 1.0,
-                                              0.0, 0.0, 0.0, 0.0}); //<<<<<
-
-    Matrix<double> orig = mat;
-    Matrix<double> givens = Decomposition::svdZeroColumn(mat,3);
-
-    // assure last row and last column are zero
-    for(size_t k = 0; k < 4; k++)
-    {
-        ASSERT_NEAR(mat(3,k), 0.0, 0.00001);
-        ASSERT_NEAR(mat(k,3), 0.0, 0.00001);
-    }
-
-    ASSERT_TRUE( mat.compare( orig * givens, true, 0.000001) );
-
-    std::cout << "SVDGolubKahanZeroColumnLast" << std::endl << mat << std::endl;
-}
-
 TEST(Decomposition, SVDSort)
 {
     Matrix<double> s_unsorted =  Matrix<double>(4,4, {1.0, 0.0, 0.0, 0.0,
@@ -1341,3 +2023,486 @@ TEST(Decomposition, SVDGolubKahanInaccurateMat)
 
     std::cout << "Diff: " << std::endl << diff;
 }
+
+TEST(Decomposition, Cholesky)
+{
+    double aData[] = {4, 12, -16, 12, 37, -43, -16, -43, 98};
+    auto   a       = Matrix<double>(3, 3, aData);
+
+    // https://en.wikipedia.org/wiki/Cholesky_decomposition
+    double lData[] = {2, 0, 0, 6, 1, 0, -8, 5, 3};
+    auto   lSoll   = Matrix<double>(3, 3, lData);
+
+    auto l = Decomposition::cholesky(a);
+    ASSERT_TRUE(lSoll.compare(l, true, 1e-12));
+    ASSERT_NEAR(Decomposition::choleskyLogDeterminant(l), std::log(a.determinant()), 1e-10);
+
+    ASSERT_TRUE(Decomposition::isPositiveDefinite(a));
+    a(2, 2) = -1.0;
+    ASSERT_FALSE(Decomposition::isPositiveDefinite(a));
+    ASSERT_THROW(Decomposition::cholesky(a), NotPositiveDefiniteException);
+}
+
+TEST(Decomposition, CholeskyBlockedThreads)
+{
+    // spans several blocks, with a partial last block
+    for (size_t n : {1, 63, 64, 65, 150})
+    {
+        auto c = Matrix<double>::random(n, n, -1.0, 1.0);
+        auto a = c * c.transpose() + Matrix<double>::identity(n);
+
+        Matrix<double> l = a;
+        ASSERT_TRUE(Decomposition::choleskyPackedInPlace(l, 3));
+
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = i + 1; j < n; j++)
+                ASSERT_EQ(l(i, j), 0.0);
+
+        ASSERT_TRUE(a.compare(l * l.transpose(), true, 1e-10));
+
+        // the upper triangle is not read
+        Matrix<double> lowerOnly = a;
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = i + 1; j < n; j++)
+                lowerOnly(i, j) = 123.0;
+        ASSERT_TRUE(Decomposition::choleskyPackedInPlace(lowerOnly, 1));
+        ASSERT_TRUE(l.compare(lowerOnly, true, 1e-12));
+
+        auto b = Matrix<double>::random(n, 4, -1.0, 1.0);
+        auto x = b;
+        Decomposition::choleskyPackedSolveInPlace(l, x);
+        ASSERT_TRUE(b.compare(a * x, true, 1e-9));
+    }
+}
+
+TEST(Decomposition, LDLT)
+{
+    // symmetric indefinite, but without zero pivots
+    size_t n = 100;
+    auto   c = Matrix<double>::random(n, n, -1.0, 1.0);
+    auto   a = c + c.transpose();
+    for (size_t i = 0; i < n; i++)
+        a(i, i) += (i % 2 == 0) ? 3.0 * n : -3.0 * n;
+
+    Matrix<double> ld = a;
+    ASSERT_TRUE(Decomposition::ldltPackedInPlace(ld, 2));
+
+    auto l = Matrix<double>::identity(n);
+    auto d = Matrix<double>(n, n);
+    d.fill(0.0);
+    for (size_t i = 0; i < n; i++)
+    {
+        d(i, i) = ld(i, i);
+        for (size_t j = 0; j < i; j++)
+            l(i, j) = ld(i, j);
+    }
+    ASSERT_TRUE(a.compare(l * d * l.transpose(), true, 1e-9));
+
+    auto b = Matrix<double>::random(n, 3, -1.0, 1.0);
+    auto x = b;
+    Decomposition::ldltPackedSolveInPlace(ld, x);
+    ASSERT_TRUE(b.compare(a * x, true, 1e-9));
+
+    // small matrix against the determinant
+    double sData[] = {2, 1, 1, -3};
+    auto   s       = Matrix<double>(2, 2, sData);
+    Matrix<double> sLd = s;
+    ASSERT_TRUE(Decomposition::ldltPackedInPlace(sLd));
+    double sign   = 0.0;
+    double logDet = Decomposition::ldltLogDeterminant(sLd, sign);
+    ASSERT_EQ(sign, -1.0);
+    ASSERT_NEAR(logDet, std::log(7.0), 1e-12);
+
+    double zData[] = {0, 1, 1, 0};
+    Matrix<double> z(2, 2, zData);
+    ASSERT_FALSE(Decomposition::ldltPackedInPlace(z));
+}
+
+TEST(Decomposition, TriangularSolve)
+{
+    size_t n = 20;
+    auto   t = Matrix<double>::random(n, n, -1.0, 1.0);
+    for (size_t i = 0; i < n; i++)
+        t(i, i) = 2.0 + t(i, i);
+
+    for (bool lower : {true, false})
+    {
+        for (bool transposed : {false, true})
+        {
+            for (bool unitDiagonal : {false, true})
+            {
+                // effective triangle matrix
+                auto tri = t;
+                for (size_t i = 0; i < n; i++)
+                {
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        if ((lower && j > i) || (!lower && j < i))
+                            tri(i, j) = 0.0;
+                    }
+                    if (unitDiagonal)
+                        tri(i, i) = 1.0;
+                }
+                if (transposed)
+                    tri = tri.transpose();
+
+                auto b = Matrix<double>::random(n, 5, -1.0, 1.0);
+                auto x = b;
+                Decomposition::triangularSolveInPlace(t, x, lower, transposed, unitDiagonal);
+                ASSERT_TRUE(b.compare(tri * x, true, 1e-10));
+            }
+        }
+    }
+}
+
+TEST(Decomposition, TriangularSolveThreads)
+{
+    // 300 x 300 is large enough to give each thread its own right hand sides.
+    // The Cholesky and LDL' solves substitute through triangularSolveInPlace.
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+
+    size_t n = 300;
+    auto   c = Matrix<double>::random(n, n, -1.0, 1.0);
+    auto   a = c * c.transpose() + Matrix<double>::identity(n);
+
+    Matrix<double> l = a;
+    ASSERT_TRUE(Decomposition::choleskyPackedInPlace(l));
+    Matrix<double> ld = a;
+    ASSERT_TRUE(Decomposition::ldltPackedInPlace(ld));
+
+    for (size_t nRhs : {3, 9, 17})
+    {
+        auto b = Matrix<double>::random(n, nRhs, -1.0, 1.0);
+
+        auto x = b;
+        Decomposition::triangularSolveInPlace(l, x, true, false);
+        ASSERT_TRUE(b.compare(l * x, true, 1e-8));
+
+        x = b;
+        Decomposition::triangularSolveInPlace(l, x, true, true);
+        ASSERT_TRUE(b.compare(l.transpose() * x, true, 1e-8));
+
+        x = b;
+        Decomposition::choleskyPackedSolveInPlace(l, x);
+        ASSERT_TRUE(b.compare(a * x, true, 1e-8));
+
+        x = b;
+        Decomposition::ldltPackedSolveInPlace(ld, x);
+        ASSERT_TRUE(b.compare(a * x, true, 1e-8));
+    }
+}
+
+TEST(Decomposition, QRPacked)
+{
+    for (auto dims : {std::make_pair(8, 5), std::make_pair(5, 8), std::make_pair(6, 6)})
+    {
+        size_t m   = dims.first;
+        size_t n   = dims.second;
+        auto   mat = Matrix<double>::random(m, n, -1.0, 1.0);
+
+        Decomposition::QRPackedResult res = Decomposition::qrPacked(mat);
+        ASSERT_EQ(res.Tau.size(), std::min(m, n));
+
+        // full
+        auto q = Decomposition::qrPackedQ(res.QR, res.Tau, false);
+        auto r = Decomposition::qrPackedR(res.QR, false);
+        ASSERT_TRUE(Matrix<double>::identity(m).compare(q.transpose() * q, true, 1e-12));
+        ASSERT_TRUE(mat.compare(q * r, true, 1e-12));
+        for (size_t i = 0; i < m; i++)
+            for (size_t j = 0; j < std::min(i, n); j++)
+                ASSERT_EQ(r(i, j), 0.0);
+
+        // economy
+        auto qThin = Decomposition::qrPackedQ(res.QR, res.Tau);
+        auto rThin = Decomposition::qrPackedR(res.QR);
+        ASSERT_EQ(qThin.cols(), std::min(m, n));
+        ASSERT_EQ(rThin.rows(), std::min(m, n));
+        ASSERT_TRUE(mat.compare(qThin * rThin, true, 1e-12));
+
+        // implicit application equals multiplication by the formed Q
+        auto b   = Matrix<double>::random(m, 3, -1.0, 1.0);
+        auto qtb = b;
+        Decomposition::qrPackedApplyQTransposedInPlace(res.QR, res.Tau, qtb);
+        ASSERT_TRUE(qtb.compare(q.transpose() * b, true, 1e-12));
+        Decomposition::qrPackedApplyQInPlace(res.QR, res.Tau, qtb);
+        ASSERT_TRUE(qtb.compare(b, true, 1e-12));
+    }
+}
+
+TEST(Decomposition, ApplyHouseholderInPlace)
+{
+    auto a = Matrix<double>::random(7, 6, -1.0, 1.0);
+    auto x = Matrix<double>::random(4, 1, -1.0, 1.0);
+
+    Decomposition::HouseholderResult h  = Decomposition::householder(x);
+    Matrix<double>                   hm = Decomposition::householderMatrix(h.V, h.B);
+
+    // left, on the block starting at (2, 1)
+    auto soll = a;
+    soll.setSubMatrix(2, 1, hm * a.subMatrix(2, 1, 4, 5));
+    auto res = a;
+    Decomposition::applyHouseholderLeft(res, h.V, h.B, 2, 1);
+    ASSERT_TRUE(soll.compare(res, true, 1e-12));
+
+    // right, on the block starting at (3, 2)
+    soll = a;
+    soll.setSubMatrix(3, 2, a.subMatrix(3, 2, 4, 4) * hm);
+    res = a;
+    Decomposition::applyHouseholderRight(res, h.V, h.B, 3, 2);
+    ASSERT_TRUE(soll.compare(res, true, 1e-12));
+
+    ASSERT_THROW(Decomposition::applyHouseholderLeft(res, h.V, h.B, 4, 0), InvalidInputException);
+    ASSERT_THROW(Decomposition::applyHouseholderRight(res, h.V, h.B, 0, 3), InvalidInputException);
+}
+
+TEST(Decomposition, QRPackedBlocked)
+{
+    // several panels of reflectors, partial last panel
+    for (auto dims : {std::make_pair(150, 70), std::make_pair(70, 150), std::make_pair(100, 100)})
+    {
+        size_t m   = dims.first;
+        size_t n   = dims.second;
+        auto   mat = Matrix<double>::random(m, n, -1.0, 1.0);
+
+        Decomposition::QRPackedResult res = Decomposition::qrPacked(mat);
+        auto q = Decomposition::qrPackedQ(res.QR, res.Tau, false);
+        auto r = Decomposition::qrPackedR(res.QR, false);
+
+        ASSERT_TRUE(Matrix<double>::identity(m).compare(q.transpose() * q, true, 1e-12));
+        ASSERT_TRUE(mat.compare(q * r, true, 1e-12));
+
+        // the QRResult interface yields the same with positive diagonal
+        Decomposition::QRResult qrRes = Decomposition::qr(mat);
+        ASSERT_TRUE(mat.compare(qrRes.Q * qrRes.R, true, 1e-12));
+        for (size_t i = 0; i < std::min(m, n); i++)
+        {
+            ASSERT_GE(qrRes.R(i, i), 0.0);
+            ASSERT_NEAR(std::abs(r(i, i)), qrRes.R(i, i), 1e-12);
+        }
+    }
+}
+
+TEST(Decomposition, BidiagonalizationInPlace)
+{
+    auto a = Matrix<double>::random(9, 6, -1.0, 1.0);
+
+    Decomposition::DiagonalizationResult res = Decomposition::bidiagonalization(a);
+    ASSERT_TRUE(Matrix<double>::identity(9).compare(res.U.transpose() * res.U, true, 1e-12));
+    ASSERT_TRUE(Matrix<double>::identity(6).compare(res.V.transpose() * res.V, true, 1e-12));
+    ASSERT_TRUE(a.compare(res.U * res.D * res.V.transpose(), true, 1e-12));
+
+    for (size_t i = 0; i < 9; i++)
+    {
+        for (size_t j = 0; j < 6; j++)
+        {
+            if (j != i && j != i + 1)
+            {
+                ASSERT_NEAR(res.D(i, j), 0.0, 1e-12);
+            }
+        }
+    }
+}
+
+TEST(Decomposition, BidiagonalizationBlocked)
+{
+    // several panels, square and tall, and a rank deficient matrix
+    std::vector<std::pair<size_t, size_t>> sizes = {{70, 70}, {150, 100}, {97, 65}, {33, 1}};
+    for (const std::pair<size_t, size_t>& size : sizes)
+    {
+        size_t m = size.first;
+        size_t n = size.second;
+        auto   a = Matrix<double>::random(m, n, -1.0, 1.0);
+
+        Decomposition::DiagonalizationResult res = Decomposition::bidiagonalization(a);
+        ASSERT_TRUE(Matrix<double>::identity(m).compare(res.U.transpose() * res.U, true, 1e-10));
+        ASSERT_TRUE(Matrix<double>::identity(n).compare(res.V.transpose() * res.V, true, 1e-10));
+        ASSERT_TRUE(a.compare(res.U * res.D * res.V.transpose(), true, 1e-10));
+
+        for (size_t i = 0; i < m; i++)
+        {
+            for (size_t j = 0; j < n; j++)
+            {
+                if (j != i && j != i + 1)
+                {
+                    ASSERT_EQ(res.D(i, j), 0.0);
+                }
+            }
+        }
+
+        // without U and V
+        Decomposition::DiagonalizationResult bOnly = Decomposition::bidiagonalization(a, false, false);
+        ASSERT_EQ(0, bOnly.U.rows());
+        ASSERT_EQ(0, bOnly.V.rows());
+        ASSERT_TRUE(bOnly.D.compare(res.D, true, 1e-12));
+    }
+
+    auto low = Matrix<double>::random(80, 3, -1.0, 1.0) * Matrix<double>::random(3, 60, -1.0, 1.0);
+    Decomposition::DiagonalizationResult lowRes = Decomposition::bidiagonalization(low);
+    ASSERT_TRUE(Matrix<double>::identity(80).compare(lowRes.U.transpose() * lowRes.U, true, 1e-10));
+    ASSERT_TRUE(Matrix<double>::identity(60).compare(lowRes.V.transpose() * lowRes.V, true, 1e-10));
+    ASSERT_TRUE(low.compare(lowRes.U * lowRes.D * lowRes.V.transpose(), true, 1e-10));
+}
+
+TEST(Decomposition, BidiagonalizationTallThreads)
+{
+    // long columns make the panel updates large enough to be split
+    // between threads, with few columns per thread
+    auto a = Matrix<double>::random(30000, 40, -1.0, 1.0);
+
+    Matrix<double> serialD;
+    {
+        Parallel::DefaultNbrOfThreadsScope threads(1);
+        serialD = Decomposition::bidiagonalization(a, false, false).D;
+    }
+
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+    Decomposition::DiagonalizationResult threaded = Decomposition::bidiagonalization(a, false, false);
+    ASSERT_TRUE(serialD.compare(threaded.D, true, 1e-10));
+
+    // orthogonal transformations keep the Frobenius norm
+    double normA = std::sqrt(Kernels::dot(a.data(), a.data(), a.rows() * a.cols()));
+    double normD = std::sqrt(Kernels::dot(threaded.D.data(), threaded.D.data(), a.rows() * a.cols()));
+    ASSERT_NEAR(normA, normD, 1e-8 * normA);
+}
+
+TEST(Decomposition, TSQR)
+{
+    // block counts with an unpaired node in the reduction tree
+    for (size_t blockSize : {0, 40, 64, 200})
+    {
+        size_t m   = 1000;
+        size_t n   = 12;
+        auto   mat = Matrix<double>::random(m, n, -1.0, 1.0);
+
+        Decomposition::QRResult res = Decomposition::tsqr(mat, true, blockSize, 3);
+        ASSERT_EQ(res.Q.rows(), m);
+        ASSERT_EQ(res.Q.cols(), n);
+        ASSERT_EQ(res.R.rows(), n);
+        ASSERT_TRUE(Matrix<double>::identity(n).compare(res.Q.transpose() * res.Q, true, 1e-12));
+        ASSERT_TRUE(mat.compare(res.Q * res.R, true, 1e-12));
+
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < i; j++)
+                ASSERT_EQ(res.R(i, j), 0.0);
+
+        // R is unique up to the signs of its rows
+        Decomposition::QRResult rOnly = Decomposition::tsqr(mat, false, blockSize, 2);
+        ASSERT_EQ(rOnly.Q.rows(), 0);
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = i; j < n; j++)
+                ASSERT_NEAR(std::abs(rOnly.R(i, j)), std::abs(res.R(i, j)), 1e-10);
+    }
+
+    // QR interface, positive diagonal
+    auto                    mat = Matrix<double>::random(300, 5, -1.0, 1.0);
+    Decomposition::QRResult res = Decomposition::qr(mat, true, Decomposition::TSQR);
+    ASSERT_TRUE(mat.compare(res.Q * res.R, true, 1e-12));
+    for (size_t i = 0; i < 5; i++)
+        ASSERT_GT(res.R(i, i), 0.0);
+
+    // wide matrix falls back to one block
+    auto wide = Matrix<double>::random(4, 6, -1.0, 1.0);
+    res       = Decomposition::tsqr(wide, true);
+    ASSERT_TRUE(wide.compare(res.Q * res.R, true, 1e-12));
+}
+
+TEST(Decomposition, TSQRThreadBudget)
+{
+    // the QR kernels of the row blocks must not start default threads on their own
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+    auto                               mat = Matrix<double>::random(4000, 100, -1.0, 1.0);
+    for (size_t nbrOfThreads : {1, 2, 3, 8})
+    {
+        Parallel::ThreadStatisticScope stats;
+        Decomposition::QRResult        res = Decomposition::tsqr(mat, true, 0, nbrOfThreads);
+        ASSERT_LE(stats.peakThreads(), nbrOfThreads);
+        if (nbrOfThreads == 1)
+        {
+            ASSERT_EQ(0, stats.startedThreads());
+        }
+        ASSERT_TRUE(mat.compare(res.Q * res.R, true, 1e-11));
+    }
+
+    // one block gets the whole budget
+    Parallel::ThreadStatisticScope stats;
+    Decomposition::tsqr(mat, false, 4000, 4);
+    ASSERT_LE(stats.peakThreads(), 4);
+    ASSERT_GT(stats.startedThreads(), 0);
+}
+
+TEST(Decomposition, StreamingQR)
+{
+    size_t m = 2000;
+    size_t n = 8;
+    auto   a = Matrix<double>::random(m, n, -1.0, 1.0);
+    auto   x = Matrix<double>::random(n, 1, -1.0, 1.0);
+    auto   b = a * x + Matrix<double>::random(m, 1, -0.01, 0.01);
+
+    // [A b] in chunks of varying size
+    Matrix<double> ab(m, n + 1);
+    ab.setSubMatrix(0, 0, a);
+    ab.setSubMatrix(0, n, b);
+
+    Decomposition::StreamingQR stream(n + 1);
+    size_t                     row = 0;
+    for (size_t chunk : {3, 100, 7, 890, 1000})
+    {
+        stream.addRows(ab.subMatrix(row, 0, chunk, n + 1));
+        row += chunk;
+    }
+    ASSERT_EQ(stream.rows(), m);
+
+    // R'R = [A b]'[A b]
+    const Matrix<double>& r = stream.R();
+    ASSERT_TRUE((ab.transpose() * ab).compare(r.transpose() * r, true, 1e-9));
+
+    // least squares from R: R(0:n, 0:n) * x = R(0:n, n)
+    auto rA = r.subMatrix(0, 0, n, n);
+    auto qb = r.subMatrix(0, n, n, 1);
+    Decomposition::triangularSolveInPlace(rA, qb, false);
+    ASSERT_TRUE(Solve::leastSquares(a, b).compare(qb, true, 1e-10));
+
+    ASSERT_THROW(stream.addRows(a), InvalidInputException);
+}
+
+TEST(Decomposition, GivensInPlace)
+{
+    auto mat = Matrix<double>::random(6, 5, -1.0, 1.0);
+
+    // rows: same as the rotation matrix from the left
+    Decomposition::GivensRotation g    = Decomposition::givensRotation(mat(1, 2), mat(4, 2));
+    Matrix<double>                gMat = Decomposition::givensRotatioColumnDirection(mat(1, 2), mat(4, 2), 6, 2, 1, 4);
+    auto                          res  = mat;
+    Decomposition::applyGivensRotationToRows(res, g, 1, 4);
+    ASSERT_TRUE((gMat * mat).compare(res, true, 1e-14));
+    ASSERT_NEAR(res(4, 2), 0.0, 1e-14);
+
+    // columns: same as the rotation matrix from the right
+    g    = Decomposition::givensRotation(mat(3, 0), mat(3, 2));
+    gMat = Decomposition::givensRotationRowDirection(mat(3, 0), mat(3, 2), 5, 3, 0, 2);
+    res  = mat;
+    Decomposition::applyGivensRotationToColumns(res, g, 0, 2);
+    ASSERT_TRUE((mat * gMat).compare(res, true, 1e-14));
+    ASSERT_NEAR(res(3, 2), 0.0, 1e-14);
+
+    ASSERT_THROW(Decomposition::applyGivensRotationToRows(res, g, 1, 6), InvalidInputException);
+    ASSERT_THROW(Decomposition::applyGivensRotationToColumns(res, g, 5, 1), InvalidInputException);
+}
+
+TEST(Decomposition, QRGivensSchedule)
+{
+    for (auto dims : {std::make_pair(60, 40), std::make_pair(40, 60), std::make_pair(50, 50), std::make_pair(2, 1), std::make_pair(1, 3)})
+    {
+        size_t m   = dims.first;
+        size_t n   = dims.second;
+        auto   mat = Matrix<double>::random(m, n, -1.0, 1.0);
+
+        Decomposition::QRResult givens = Decomposition::qr(mat, true, Decomposition::Givens);
+        ASSERT_TRUE(Matrix<double>::identity(m).compare(givens.Q.transpose() * givens.Q, true, 1e-12));
+        ASSERT_TRUE(mat.compare(givens.Q * givens.R, true, 1e-12));
+
+        // unique with positive diagonal
+        Decomposition::QRResult house = Decomposition::qr(mat, true, Decomposition::Householder);
+        ASSERT_TRUE(house.R.compare(givens.R, true, 1e-10));
+    }
+}
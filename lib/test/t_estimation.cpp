@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "matrix.hpp"
+#include "estimation.hpp"
+
+TEST(Estimation, NormL2)
+{
+    // source https://ch.mathworks.com/help/matlab/ref/norm.html
+    double matData[] = {2, 0, 1,    -1, 1, 0,   -3, 3, 0};
+    auto mat = Matrix<double>(3,3,matData);
+
+    Estimation::NormEstimate est = Estimation::normL2(mat);
+
+    ASSERT_TRUE(est.Converged);
+    ASSERT_NEAR(4.7234, est.Value, 0.0001);
+    ASSERT_LE(est.LowerBound, 4.7235);
+    ASSERT_GE(est.UpperBound, 4.7234);
+
+    // the largest singular value dominates ||A||_F^2, so the bounds are sharp
+    ASSERT_LE(est.ErrorBound(), 1e-9 * est.Value);
+}
+
+TEST(Estimation, NormL2OrthogonalStart)
+{
+    // The column sums of |A| are the right singular vector of the
+    // smaller singular value 0.1 * sqrt(2). The norm is sqrt(2).
+    double matData[] = {1, -1,    0.1, 0.1};
+    auto mat = Matrix<double>(2,2,matData);
+
+    Estimation::NormEstimate est = Estimation::normL2(mat);
+
+    ASSERT_TRUE(est.Converged);
+    ASSERT_NEAR(std::sqrt(2.0), est.Value, 1e-8);
+    ASSERT_LE(est.LowerBound, std::sqrt(2.0) * (1.0 + 1e-12));
+    ASSERT_GE(est.UpperBound, std::sqrt(2.0) * (1.0 - 1e-12));
+    ASSERT_LE(est.ErrorBound(), 1e-9 * est.Value);
+    ASSERT_NEAR(std::sqrt(2.0), mat.normL2(), 1e-8);
+}
+
+TEST(Estimation, NormL2Batch)
+{
+    size_t nbrOfConverged = 0;
+
+    for( int k = 0; k < 100; k++ )
+    {
+        auto mat = Matrix<double>::random(12, 7, -10.0, 10.0);
+
+        // largest singular value is the root of the largest Eigen value of A'A
+        Matrix<double>           ata = mat.transpose() * mat;
+        Decomposition::EigenPair ep  = Decomposition::eigen(ata).at(0);
+        ep                           = Decomposition::rayleighIteration(ata, ep.V, ep.L, 20, 1e-15);
+        double exact                 = std::sqrt(ep.L);
+        Estimation::NormEstimate est = Estimation::normL2(mat, 1e-8);
+
+        ASSERT_LE(est.LowerBound, exact * (1.0 + 1e-12));
+        ASSERT_GE(est.UpperBound, exact * (1.0 - 1e-12));
+
+        // close singular values slow the iteration down
+        if( est.Converged )
+        {
+            ASSERT_NEAR(exact, est.Value, 1e-8 * exact);
+            nbrOfConverged++;
+        }
+    }
+
+    ASSERT_GE(nbrOfConverged, 90);
+}
+
+TEST(Estimation, NormL2DominantBound)
+{
+    for( int k = 0; k < 100; k++ )
+    {
+        // a strong rank one part makes the largest singular value dominate ||A||_F^2
+        auto mat = Matrix<double>::random(12, 7, -1.0, 1.0) + Matrix<double>::random(12, 1, 1.0, 2.0) * Matrix<double>::random(1, 7, 1.0, 2.0);
+
+        double exact                 = Decomposition::singularValues(mat).at(0);
+        Estimation::NormEstimate est = Estimation::normL2(mat, 1e-8);
+
+        ASSERT_TRUE(est.Converged);
+        ASSERT_LE(est.LowerBound, exact * (1.0 + 1e-12));
+        ASSERT_GE(est.UpperBound, exact * (1.0 - 1e-12));
+        ASSERT_LE(est.ErrorBound(), 1e-7 * exact);
+    }
+}
+
+TEST(Estimation, NormL2Zero)
+{
+    Matrix<double> mat(4,3);
+    mat.fill(0.0);
+
+    ASSERT_EQ(0.0, Estimation::normL2(mat).Value);
+}
+
+// from documents/norms.pdf
+TEST(Estimation, ConditionNumbers)
+{
+    double matData[] = {2, -1, 1,   1, 0, 1,   3, -1, 4};
+    auto mat = Matrix<double>(3,3, matData);
+
+    ASSERT_NEAR( 6 * 4.5, Estimation::conditionNumberL1(mat).Value, 0.001);
+    ASSERT_NEAR( 8 * 3.5, Estimation::conditionNumberInf(mat).Value, 0.001);
+}
+
+TEST(Estimation, ConditionNumbersBatch)
+{
+    size_t nbrOfGoodEstimates = 0;
+
+    for( int k = 0; k < 100; k++ )
+    {
+        auto mat = Matrix<double>::random(10, 10, -10.0, 10.0);
+        Matrix<double> inv = mat.inverted();
+
+        double exactL1  = mat.normL1() * inv.normL1();
+        double exactInf = mat.normInf() * inv.normInf();
+
+        Estimation::NormEstimate estL1  = Estimation::conditionNumberL1(mat, 5, 1e-6);
+        Estimation::NormEstimate estInf = Estimation::conditionNumberInf(mat, 5, 1e-6);
+
+        // the estimate is a lower bound. The upper bound is an estimate as well.
+        ASSERT_LE(estL1.LowerBound, exactL1 * (1.0 + 1e-9));
+        ASSERT_GE(estL1.UpperBound, estL1.Value);
+
+        ASSERT_LE(estInf.LowerBound, exactInf * (1.0 + 1e-9));
+        ASSERT_GE(estInf.UpperBound, estInf.Value);
+
+        // ... which is rarely off by more than a factor 3
+        if( estL1.Value * 3.0 >= exactL1 && estInf.Value * 3.0 >= exactInf )
+            nbrOfGoodEstimates++;
+    }
+
+    ASSERT_GE(nbrOfGoodEstimates, 90);
+}
+
+TEST(Estimation, ConditionNumberSingular)
+{
+    double matData[] = {1, 2, 3,   2, 4, 6,   1, 0, 1};
+    auto mat = Matrix<double>(3,3, matData);
+
+    ASSERT_ANY_THROW(Estimation::conditionNumberL1(mat));
+}
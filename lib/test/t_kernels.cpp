@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "matrix.hpp"
+#include "kernels.hpp"
+
+TEST(Kernels, ScaleAxpySwap)
+{
+    // odd lengths cover the scalar remainder of the vectorized loops
+    for (size_t n : {0, 1, 2, 3, 5, 8, 17})
+    {
+        auto x = Matrix<double>::random(1, n, -10.0, 10.0);
+        auto y = Matrix<double>::random(1, n, -10.0, 10.0);
+
+        auto scaled = x;
+        Kernels::scale(scaled.data(), n, -2.5);
+        ASSERT_TRUE(scaled.compare(x * -2.5));
+
+        auto axpy = y;
+        Kernels::axpy(axpy.data(), x.data(), n, 3.0);
+        ASSERT_TRUE(axpy.compare(y + x * 3.0, true, 1e-12));
+
+        auto xs = x;
+        auto ys = y;
+        Kernels::swap(xs.data(), ys.data(), n);
+        ASSERT_TRUE(xs.compare(y));
+        ASSERT_TRUE(ys.compare(x));
+    }
+}
+
+TEST(Kernels, ScaleAxpyInt)
+{
+    int  xData[] = {1, 2, 3, 4, 5};
+    int  yData[] = {5, 4, 3, 2, 1};
+    auto x       = Matrix<int>(1, 5, xData);
+    auto y       = Matrix<int>(1, 5, yData);
+
+    Kernels::axpy(y.data(), x.data(), 5, 2);
+    int  sollData[] = {7, 8, 9, 10, 11};
+    ASSERT_TRUE(y.compare(Matrix<int>(1, 5, sollData)));
+
+    Kernels::scale(x.data(), 5, -1);
+    ASSERT_TRUE(x.compare(Matrix<int>(1, 5, xData) * -1));
+}
+
+TEST(Kernels, RowOperations)
+{
+    auto mat = Matrix<double>::random(4, 7, -10.0, 10.0);
+
+    auto soll = mat;
+    soll.setRow(2, soll.row(2) + soll.row(0) * 1.5);
+    auto res = mat;
+    Kernels::addProductOfRow(res, 1.5, 0, 2);
+    ASSERT_TRUE(soll.compare(res, true, 1e-12));
+
+    // restricted to columns from 3 on
+    soll = mat;
+    for (size_t n = 3; n < mat.cols(); n++)
+        soll(1, n) = mat(1, n) * 4.0;
+    res = mat;
+    Kernels::scaleRow(res, 4.0, 1, 3);
+    ASSERT_TRUE(soll.compare(res));
+
+    ASSERT_THROW(Kernels::scaleRow(res, 1.0, 4), InvalidInputException);
+    ASSERT_THROW(Kernels::addProductOfRow(res, 1.0, 0, 1, 8), InvalidInputException);
+}
+
+TEST(Kernels, EliminateRowsParallel)
+{
+    // 300 x 600 is above the grain size, so several threads share the rows
+    auto mat = Matrix<double>::random(300, 600, -1.0, 1.0);
+
+    std::vector<size_t> rows;
+    std::vector<double> factors;
+    for (size_t m = 1; m < mat.rows(); m++)
+    {
+        rows.push_back(m);
+        factors.push_back(-mat(m, 0) / mat(0, 0));
+    }
+
+    auto serial = mat;
+    for (size_t i = 0; i < rows.size(); i++)
+        Kernels::addProductOfRow(serial, factors[i], 0, rows[i]);
+
+    auto parallel = mat;
+    Kernels::eliminateRows(parallel, 0, rows, factors, 0, 4);
+
+    ASSERT_TRUE(serial.compare(parallel));
+
+    for (size_t m = 1; m < mat.rows(); m++)
+        ASSERT_NEAR(parallel(m, 0), 0.0, 1e-12);
+
+    factors.pop_back();
+    ASSERT_THROW(Kernels::eliminateRows(parallel, 0, rows, factors), InvalidInputException);
+}
+
+TEST(Kernels, Rotation)
+{
+    auto   mat = Matrix<double>::random(5, 7, -1.0, 1.0);
+    double c   = std::cos(0.3);
+    double s   = std::sin(0.3);
+
+    // rows 1 and 3, contiguous
+    auto soll = mat;
+    for (size_t n = 0; n < 7; n++)
+    {
+        soll(1, n) = c * mat(1, n) - s * mat(3, n);
+        soll(3, n) = s * mat(1, n) + c * mat(3, n);
+    }
+    auto res = mat;
+    Kernels::rot(res.data() + 7, res.data() + 3 * 7, 7, c, s);
+    ASSERT_TRUE(soll.compare(res, true, 1e-14));
+
+    // columns 0 and 4, strided
+    soll = mat;
+    for (size_t m = 0; m < 5; m++)
+    {
+        soll(m, 0) = c * mat(m, 0) - s * mat(m, 4);
+        soll(m, 4) = s * mat(m, 0) + c * mat(m, 4);
+    }
+    res = mat;
+    Kernels::rot(res.data(), res.data() + 4, 5, c, s, 7);
+    ASSERT_TRUE(soll.compare(res, true, 1e-14));
+}
+
+TEST(Kernels, MatrixProducts)
+{
+    // k larger than one tile, n larger than one column tile
+    auto a = Matrix<double>::random(37, 300, -1.0, 1.0);
+    auto b = Matrix<double>::random(530, 300, -1.0, 1.0);
+    auto c = Matrix<double>::random(37, 530, -1.0, 1.0);
+
+    for (size_t threads : {1, 3})
+    {
+        auto res = c;
+        Kernels::gemmNT(a, b, res, 0.5, threads);
+        ASSERT_TRUE(res.compare(c + a * b.transpose() * 0.5, true, 1e-11));
+
+        res = c;
+        Kernels::gemmTN(a.transpose(), b.transpose(), res, -2.0, threads);
+        ASSERT_TRUE(res.compare(c - a * b.transpose() * 2.0, true, 1e-11));
+    }
+
+    ASSERT_THROW(Kernels::gemmNT(a, a, c), InvalidInputException);
+    ASSERT_THROW(Kernels::gemmTN(a, b, c), InvalidInputException);
+}
@@ -342,16 +342,62 @@ TEST(Matrix4x4, FindAffineTransformation_Batch)
         }
 
 
-        // todo: This values need to be lower! -> Decrease after implementing a new SVD
-
-        ASSERT_TRUE( t.compare(t_res, true, 0.02) );
-        ASSERT_LT( error, 0.05 );
+        ASSERT_TRUE( t.compare(t_res, true, 1e-6) );
+        ASSERT_LT( error, 1e-6 );
 
         if( run % 100 == 0 )
             std::cout << "Run: " << run << " of " << runs << std::endl;
     }
 }
 
+TEST(Matrix4x4, FindRigidTransformations_Parallel)
+{
+    // a few hundred pairs of small patches, far from the origin
+    size_t count = 700;
+    std::vector<Matrix<double>> setsA, setsB;
+    std::vector<Matrix4x4>      soll;
+    for (size_t p = 0; p < count; p++)
+    {
+        size_t         n      = 3 + p % 10;
+        Matrix<double> inputA = Matrix<double>::random(4, n, -1.0, 1.0);
+        for (size_t k = 0; k < n; k++)
+        {
+            inputA(0, k) += 1e5;
+            inputA(3, k) = 1.0;
+        }
+
+        Matrix4x4 t;
+        Matrix<double> t_rand = Matrix<double>::random(6, 1, -3, 3);
+        t.rotX(t_rand(0,0)); t.rotY(t_rand(1,0)); t.rotZ(t_rand(2,0));
+        t.setTranslation(t_rand(3,0), t_rand(4,0), t_rand(5,0));
+
+        setsA.push_back(inputA.subMatrix(0, 0, 3, n));
+        setsB.push_back((t * inputA).subMatrix(0, 0, 3, n));
+        soll.push_back(t);
+    }
+
+    for (size_t threads : {1, 3})
+    {
+        std::vector<double>    errors;
+        std::vector<Matrix4x4> res = Matrix4x4::findRigidTransformations(setsA, setsB, errors, threads);
+        ASSERT_EQ(count, res.size());
+        ASSERT_EQ(count, errors.size());
+        for (size_t p = 0; p < count; p++)
+        {
+            double    error;
+            Matrix4x4 single = Matrix4x4::findRigidTransformation(setsA[p], setsB[p], error);
+            ASSERT_TRUE( single.compare(res[p], true, 1e-12) );
+            ASSERT_NEAR(error, errors[p], 1e-12);
+            ASSERT_TRUE( soll[p].subMatrix(0, 0, 3, 3).compare(res[p].subMatrix(0, 0, 3, 3), true, 1e-8) );
+            ASSERT_LT(errors[p], 1e-8);
+        }
+    }
+
+    std::vector<double> errors;
+    setsB.pop_back();
+    ASSERT_THROW(Matrix4x4::findRigidTransformations(setsA, setsB, errors), InvalidInputException);
+}
+
 TEST(Matrix4x4, ComputeTransError)
 {
     double p_A_data[] = {1 , 2,
@@ -220,4 +220,9 @@ TEST(MatAdvanced, ConditionNumbers)
 
     ASSERT_NEAR( 6 * 4.5, mat.conditionNumberL1(), 0.001);
     ASSERT_NEAR( 8 * 3.5, mat.conditionNumberInf(), 0.001);
+    ASSERT_NEAR( mat.normL2() * mat.inverted().normL2(), mat.conditionNumberL2(), 0.000001);
+
+    Matrix<double> singular(3, 3);
+    singular.fill(1.0);
+    ASSERT_GT( singular.conditionNumberL2(), 1e14 );
 }
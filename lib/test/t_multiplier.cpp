@@ -69,3 +69,24 @@ TEST(Multiplier, MultiplyRow)
 
     ASSERT_TRUE(soll.compare(res));
 }
+
+TEST(Multiplier, CompactRowOperation)
+{
+    double matData[] = {1, 2, 3, 4, 5, 6};
+    auto   mat       = Matrix<double>(3, 2, matData);
+
+    std::vector<Multiplier::RowOperation> ops;
+    ops.push_back(Multiplier::RowOperation(Multiplier::RowOperation::SwapRows, 0, 2, 1.0));
+    ops.push_back(Multiplier::RowOperation(Multiplier::RowOperation::MultiplyRow, 1, 1, -2.5));
+    ops.push_back(Multiplier::RowOperation(Multiplier::RowOperation::AddProductRow, 1, 0, 3.0));
+
+    // applying in place equals multiplying the expanded operator from left
+    auto soll = mat;
+    for (const auto& op : ops)
+        soll = Multiplier::toMatrix(op, 3) * soll;
+
+    auto res = mat;
+    Multiplier::apply(ops, res);
+
+    ASSERT_TRUE(soll.compare(res));
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <mutex>
+#include "parallel.hpp"
+
+TEST(Parallel, ForRangeChunks)
+{
+    // 9 indices on 8 threads rounds the chunk size up to 2, which only
+    // needs 5 chunks. Every chunk has to be non-empty and inside the range.
+    for (size_t threads : {1, 2, 3, 7, 8, 16})
+    {
+        for (size_t len : {1, 2, 9, 10, 17, 100})
+        {
+            size_t begin = 3;
+            size_t end   = begin + len;
+
+            std::mutex                             lock;
+            std::vector<std::pair<size_t, size_t>> chunks;
+            Parallel::forRange(begin, end, [&](size_t cBegin, size_t cEnd) {
+                std::lock_guard<std::mutex> guard(lock);
+                chunks.push_back(std::make_pair(cBegin, cEnd));
+            }, threads);
+
+            ASSERT_LE(chunks.size(), threads);
+
+            size_t covered = 0;
+            for (const auto& c : chunks)
+            {
+                ASSERT_LE(begin, c.first);
+                ASSERT_LT(c.first, c.second);
+                ASSERT_LE(c.second, end);
+                covered += c.second - c.first;
+            }
+            ASSERT_EQ(covered, len);
+        }
+    }
+}
+
+TEST(Parallel, DefaultNbrOfThreadsScope)
+{
+    size_t hardware = Parallel::defaultNbrOfThreads();
+    {
+        Parallel::DefaultNbrOfThreadsScope outer(5);
+        ASSERT_EQ(5, Parallel::defaultNbrOfThreads());
+        {
+            Parallel::DefaultNbrOfThreadsScope inner(2);
+            ASSERT_EQ(2, Parallel::defaultNbrOfThreads());
+        }
+        ASSERT_EQ(5, Parallel::defaultNbrOfThreads());
+    }
+    ASSERT_EQ(hardware, Parallel::defaultNbrOfThreads());
+}
+
+TEST(Parallel, ThreadStatisticScope)
+{
+    Parallel::ThreadStatisticScope stats;
+    ASSERT_EQ(0, stats.startedThreads());
+    ASSERT_EQ(1, stats.peakThreads());
+
+    Parallel::forRange(0, 10, [](size_t, size_t) {}, 1);
+    ASSERT_EQ(0, stats.startedThreads());
+
+    // nested calls multiply the threads
+    Parallel::forRange(0, 3, [](size_t, size_t) {
+        Parallel::forRange(0, 2, [](size_t, size_t) {}, 2);
+    }, 3);
+    ASSERT_EQ(5, stats.startedThreads());
+    ASSERT_LE(stats.peakThreads(), 6);
+
+    // a second scope only sees the workers started after its construction
+    {
+        Parallel::ThreadStatisticScope inner;
+        Parallel::forRange(0, 4, [](size_t, size_t) {}, 4);
+        ASSERT_EQ(3, inner.startedThreads());
+        ASSERT_LE(inner.peakThreads(), 4);
+    }
+    ASSERT_EQ(8, stats.startedThreads());
+    ASSERT_LE(stats.peakThreads(), 6);
+}
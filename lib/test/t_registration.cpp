@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include "matrix4x4.hpp"
+#include "registration.hpp"
+
+// Point set B = t * A with a fraction of wrong correspondences, which are moved far away
+void makeCorrespondences(size_t n, double outlierRatio, Matrix4x4& t, Matrix<double>& a, Matrix<double>& b, std::vector<bool>& isInlier)
+{
+    Matrix<double> inputA = Matrix<double>::random(4, n, -10.0, 10.0);
+    for (size_t k = 0; k < n; k++)
+        inputA(3, k) = 1.0;
+
+    Matrix<double> t_rand = Matrix<double>::random(6, 1, -3, 3);
+    t = Matrix4x4();
+    t.rotX(t_rand(0,0)); t.rotY(t_rand(1,0)); t.rotZ(t_rand(2,0));
+    t.setTranslation(t_rand(3,0), t_rand(4,0), t_rand(5,0));
+
+    a = inputA.subMatrix(0, 0, 3, n);
+    b = (t * inputA).subMatrix(0, 0, 3, n) + Matrix<double>::random(3, n, -0.01, 0.01);
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    isInlier.assign(n, true);
+    for (size_t k = 0; k < n; k++)
+    {
+        if (dist(gen) < outlierRatio)
+        {
+            isInlier[k] = false;
+            for (size_t i = 0; i < 3; i++)
+                b(i, k) += 5.0 + 20.0 * dist(gen);
+        }
+    }
+}
+
+TEST(Registration, CountInliers)
+{
+    Matrix4x4 t;
+    Matrix<double> a, b;
+    std::vector<bool> isInlier;
+    for (size_t n : {3, 4, 7, 100})
+    {
+        makeCorrespondences(n, 0.4, t, a, b, isInlier);
+        size_t soll = std::count(isInlier.begin(), isInlier.end(), true);
+        ASSERT_EQ(soll, Registration::countInliers(a, b, t, 0.1));
+        ASSERT_EQ(0, Registration::countInliers(a, b, t, 0.0));
+    }
+}
+
+TEST(Registration, Ransac)
+{
+    for (double outlierRatio : {0.0, 0.3, 0.6})
+    {
+        Matrix4x4 t;
+        Matrix<double> a, b;
+        std::vector<bool> isInlier;
+        makeCorrespondences(300, outlierRatio, t, a, b, isInlier);
+
+        Registration::RansacResult res = Registration::ransac(a, b, 0.1);
+        ASSERT_TRUE( t.compare(res.Transformation, true, 0.01) );
+        ASSERT_LT(res.Error, 0.02);
+        ASSERT_EQ(std::count(isInlier.begin(), isInlier.end(), true), res.Inliers.size());
+        for (size_t k : res.Inliers)
+            ASSERT_TRUE(isInlier.at(k));
+
+        // the confidence target ends the search early
+        ASSERT_LT(res.NbrOfHypotheses, 1000);
+
+        // the same with another number of threads
+        Registration::RansacResult res3 = Registration::ransac(a, b, 0.1, 0.99, 10000, 3);
+        ASSERT_TRUE( res.Transformation.compare(res3.Transformation, true, 1e-12) );
+        ASSERT_EQ(res.NbrOfHypotheses, res3.NbrOfHypotheses);
+    }
+
+    // a single wrong correspondence spoils the least squares solution, but not RANSAC
+    Matrix4x4 t;
+    Matrix<double> a, b;
+    std::vector<bool> isInlier;
+    makeCorrespondences(20, 0.0, t, a, b, isInlier);
+    b(0, 3) += 50.0;
+    double error;
+    ASSERT_FALSE( t.compare(Matrix4x4::findRigidTransformation(a, b, error), true, 0.01) );
+    ASSERT_TRUE( t.compare(Registration::ransac(a, b, 0.1).Transformation, true, 0.01) );
+
+    ASSERT_THROW(Registration::ransac(a, b.subMatrix(0, 0, 3, 10), 0.1), InvalidInputException);
+    ASSERT_THROW(Registration::ransac(a, b, -1.0), InvalidInputException);
+}
+
+TEST(Registration, RansacThreads)
+{
+    // with many points each hypothesis is worth its own chunk, so the
+    // last, partial batches of 9 to 11 or 17 hypotheses are split unevenly
+    Matrix4x4 t;
+    Matrix<double> a, b;
+    std::vector<bool> isInlier;
+
+    // the outlier ratio keeps the confidence target out of reach
+    makeCorrespondences(4096, 0.85, t, a, b, isInlier);
+
+    for (size_t maxHypotheses : {73, 74, 75, 81})
+    {
+        Registration::RansacResult res = Registration::ransac(a, b, 0.1, 0.99, maxHypotheses, 8);
+        ASSERT_EQ(maxHypotheses, res.NbrOfHypotheses);
+
+        Registration::RansacResult serial = Registration::ransac(a, b, 0.1, 0.99, maxHypotheses, 1);
+        ASSERT_TRUE( res.Transformation.compare(serial.Transformation, true, 1e-12) );
+        ASSERT_EQ(serial.Inliers, res.Inliers);
+    }
+}
+
+TEST(Registration, Prosac)
+{
+    Matrix4x4 t;
+    Matrix<double> a, b;
+    std::vector<bool> isInlier;
+    makeCorrespondences(500, 0.6, t, a, b, isInlier);
+
+    // the quality ranks most inliers on top
+    std::vector<double> quality(500);
+    for (size_t k = 0; k < 500; k++)
+        quality[k] = (isInlier[k] ? 1.0 : 0.0) + (k % 7) * 0.1;
+
+    Registration::RansacResult prosac = Registration::prosac(a, b, quality, 0.1);
+    Registration::RansacResult ransac = Registration::ransac(a, b, 0.1);
+    ASSERT_TRUE( t.compare(prosac.Transformation, true, 0.01) );
+    ASSERT_EQ(ransac.Inliers, prosac.Inliers);
+    ASSERT_LE(prosac.NbrOfHypotheses, ransac.NbrOfHypotheses);
+
+    // all points are outliers
+    Matrix<double> noise = Matrix<double>::random(3, 50, -100.0, 100.0);
+    Registration::RansacResult none = Registration::ransac(a.subMatrix(0, 0, 3, 50), noise, 0.01, 0.99, 500);
+    ASSERT_TRUE( none.Inliers.empty() );
+    ASSERT_EQ(500, none.NbrOfHypotheses);
+
+    ASSERT_THROW(Registration::prosac(a, b, std::vector<double>(3), 0.1), InvalidInputException);
+}
+
+// Points on a wavy surface, which constrains all six degrees of freedom
+Matrix<double> wavySurface(size_t gridSize)
+{
+    Matrix<double> points(3, gridSize * gridSize);
+    for (size_t i = 0; i < gridSize; i++)
+    {
+        for (size_t j = 0; j < gridSize; j++)
+        {
+            double x                        = -2.0 + 4.0 * i / (gridSize - 1);
+            double y                        = -2.0 + 4.0 * j / (gridSize - 1);
+            points(0, i * gridSize + j) = x;
+            points(1, i * gridSize + j) = y;
+            points(2, i * gridSize + j) = 0.5 * std::sin(2.0 * x) * std::cos(1.5 * y) + 0.1 * x * y;
+        }
+    }
+    return points;
+}
+
+TEST(Registration, IcpPointToPoint)
+{
+    Matrix<double> target = wavySurface(80);
+
+    // the source is the target seen from a slightly moved position
+    Matrix4x4 t;
+    t.rotX(0.05); t.rotY(-0.04); t.rotZ(0.08);
+    t.setTranslation(0.1, -0.05, 0.08);
+    Matrix<double> homogene(4, target.cols());
+    homogene.fill(1.0);
+    homogene.setSubMatrix(0, 0, target);
+    Matrix<double> source = (Matrix<double>(t.inverted_rg()) * homogene).subMatrix(0, 0, 3, target.cols());
+
+    Registration::IcpParameters parameters;
+    parameters.MaxIterations  = 100;
+    parameters.MaxNbrOfPoints = 2000;
+    parameters.Tolerance      = 1e-9;
+    Registration::IcpResult res = Registration::icp(source, target, Matrix4x4(), parameters);
+    ASSERT_TRUE( res.Converged );
+    ASSERT_TRUE( t.compare(res.Transformation, true, 1e-3) );
+    ASSERT_LT(res.Error, 1e-3);
+    ASSERT_GT(res.NbrOfCorrespondences, 1000);
+
+    // the reusable tree, with a good initial transformation
+    KdTree tree(target);
+    Registration::IcpResult fromInitial = Registration::icp(source, tree, Matrix<double>(), t, parameters);
+    ASSERT_TRUE( t.compare(fromInitial.Transformation, true, 1e-6) );
+    ASSERT_LE(fromInitial.NbrOfIterations, res.NbrOfIterations);
+
+    // no correspondence within the maximum distance
+    parameters.MaxDistance = 1e-6;
+    ASSERT_FALSE( Registration::icp(source, tree, Matrix<double>(), Matrix4x4(), parameters).Converged );
+
+    ASSERT_THROW(Registration::icp(source.subMatrix(0, 0, 2, 10), target), InvalidInputException);
+}
+
+TEST(Registration, IcpPointToPlane)
+{
+    Matrix<double> target  = wavySurface(80);
+    KdTree         tree(target);
+    Matrix<double> normals = Registration::estimateNormals(tree);
+
+    // the normals of the surface z = f(x, y) are parallel to (-fx, -fy, 1)
+    for (size_t k = 0; k < target.cols(); k += 97)
+    {
+        double x  = target(0, k);
+        double y  = target(1, k);
+        double fx = std::cos(2.0 * x) * std::cos(1.5 * y) + 0.1 * y;
+        double fy = -0.75 * std::sin(2.0 * x) * std::sin(1.5 * y) + 0.1 * x;
+        double nn = std::sqrt(fx * fx + fy * fy + 1.0);
+        double c  = (-fx * normals(0, k) - fy * normals(1, k) + normals(2, k)) / nn;
+        ASSERT_GT(std::abs(c), 0.99);
+    }
+
+    // the source are other samples of the same surface
+    Matrix4x4 t;
+    t.rotX(-0.03); t.rotY(0.05); t.rotZ(0.06);
+    t.setTranslation(-0.05, 0.1, 0.05);
+    Matrix<double> samples = wavySurface(57);
+    Matrix<double> homogene(4, samples.cols());
+    homogene.fill(1.0);
+    homogene.setSubMatrix(0, 0, samples);
+    Matrix<double> source = (Matrix<double>(t.inverted_rg()) * homogene).subMatrix(0, 0, 3, samples.cols());
+
+    Registration::IcpParameters parameters;
+    parameters.Metric        = Registration::PointToPlane;
+    parameters.MaxIterations = 50;
+    parameters.Tolerance     = 1e-8;
+    Registration::IcpResult res = Registration::icp(source, tree, normals, Matrix4x4(), parameters);
+    ASSERT_TRUE( res.Converged );
+    ASSERT_TRUE( t.compare(res.Transformation, true, 5e-3) );
+
+    ASSERT_THROW(Registration::icp(source, tree, Matrix<double>(), Matrix4x4(), parameters), InvalidInputException);
+}
@@ -34,3 +34,49 @@ TEST(SampleStatistics, Mean)
     ASSERT_FLOAT_EQ(compMean2(0,0), 2.0);
     ASSERT_FLOAT_EQ(compMean2(1,0), 2.0);
 }
+
+TEST(SampleStatistics, Covariance)
+{
+    Matrix<double> mean(2, 1, {1.0, 3.0});
+    std::vector<std::pair<double, Matrix<double>>> axes;
+    axes.push_back(std::pair<double, Matrix<double>>(2.0, Matrix<double>(2, 1, {1.0, 0.0})));
+    axes.push_back(std::pair<double, Matrix<double>>(0.5, Matrix<double>(2, 1, {0.0, 1.0})));
+
+    NormalSampleGenerator gen(mean, axes, 0);
+    std::vector<SamplePtr> samples = gen.getN(20000);
+
+    Matrix<double> cov = SampleStatistic::covariance(samples);
+    ASSERT_NEAR(cov(0, 0), 4.0, 0.2);
+    ASSERT_NEAR(cov(1, 1), 0.25, 0.0125);
+    ASSERT_NEAR(cov(0, 1), 0.0, 0.05);
+    ASSERT_DOUBLE_EQ(cov(0, 1), cov(1, 0));
+
+    ASSERT_THROW(SampleStatistic::covariance(std::vector<SamplePtr>(samples.begin(), samples.begin() + 1)), EmptyContainerException);
+}
+
+TEST(SampleStatistics, NormalLikelihood)
+{
+    Matrix<double> mean(2, 1, {1.0, 3.0});
+    Matrix<double> cov(2, 2, {4.0, 0.0, 0.0, 0.25});
+
+    std::vector<SamplePtr> samples;
+    samples.push_back(SamplePtr(new Sample(Matrix<double>(2, 1, {3.0, 3.0}))));
+    samples.push_back(SamplePtr(new Sample(Matrix<double>(2, 1, {1.0, 2.0}))));
+    samples.push_back(SamplePtr(new Sample(Matrix<double>(2, 1, {1.0, 3.0}))));
+
+    std::vector<double> dist = SampleStatistic::mahalanobisDistances(samples, mean, cov);
+    ASSERT_EQ(dist.size(), 3);
+    ASSERT_NEAR(dist[0], 1.0, 1e-12);
+    ASSERT_NEAR(dist[1], 2.0, 1e-12);
+    ASSERT_NEAR(dist[2], 0.0, 1e-12);
+
+    // closed form of the bivariate normal density with det(cov) = 1
+    double soll = 0.0;
+    for (double d : dist)
+        soll += -std::log(2.0 * M_PI) - 0.5 * d * d;
+
+    ASSERT_NEAR(SampleStatistic::logLikelihoodNormal(samples, mean, cov), soll, 1e-12);
+
+    Matrix<double> indefinite(2, 2, {1.0, 2.0, 2.0, 1.0});
+    ASSERT_THROW(SampleStatistic::logLikelihoodNormal(samples, mean, indefinite), NotPositiveDefiniteException);
+}
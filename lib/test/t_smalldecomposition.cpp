@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "matrix.hpp"
+#include "smalldecomposition.hpp"
+
+// A * V = V * diag(values), V orthogonal and the values ascending
+void checkSymmetricEigen(const Matrix<double>& a, const double* values, const double* vectors)
+{
+    size_t         n = a.rows();
+    Matrix<double> v(n, n, vectors);
+    Matrix<double> d(n, n);
+    d.fill(0.0);
+    for (size_t k = 0; k < n; k++)
+        d(k, k) = values[k];
+
+    ASSERT_TRUE( v.isOrthogonal(1e-12) );
+    ASSERT_TRUE( (a * v).compare(v * d, true, 1e-12) );
+    for (size_t k = 1; k < n; k++)
+        ASSERT_LE(values[k - 1], values[k]);
+}
+
+// A = U * diag(s) * V', U and V orthogonal (rotations) and the values descending
+void checkSVD3x3(const Matrix<double>& a, const double* u, const double* s, const double* v, bool rotations)
+{
+    Matrix<double> mu(3, 3, u);
+    Matrix<double> mv(3, 3, v);
+    Matrix<double> d(3, 3);
+    d.fill(0.0);
+    for (size_t k = 0; k < 3; k++)
+        d(k, k) = s[k];
+
+    ASSERT_TRUE( mu.isOrthogonal(1e-12) );
+    ASSERT_TRUE( mv.isOrthogonal(1e-12) );
+    ASSERT_TRUE( a.compare(mu * d * mv.transpose(), true, 1e-12) );
+    ASSERT_GE(s[0], s[1]);
+    if (rotations)
+    {
+        ASSERT_NEAR(1.0, mu.determinant(), 1e-12);
+        ASSERT_NEAR(1.0, mv.determinant(), 1e-12);
+        ASSERT_GE(s[1], std::abs(s[2]));
+    }
+    else
+    {
+        ASSERT_GE(s[1], s[2]);
+        ASSERT_GE(s[2], 0.0);
+    }
+}
+
+TEST(SmallDecomposition, SymmetricEigen2x2)
+{
+    double diagonal[] = {3.0, 0.0, 0.0, -1.0};
+    double tiny[]     = {1.0, 1e-20, 1e-20, 1.0};
+    std::vector<Matrix<double>> mats = {Matrix<double>::identity(2), Matrix<double>(2, 2, diagonal), Matrix<double>(2, 2, tiny)};
+    for (size_t k = 0; k < 20; k++)
+    {
+        auto r = Matrix<double>::random(2, 2, -5.0, 5.0);
+        mats.push_back(r + r.transpose());
+    }
+
+    for (const Matrix<double>& a : mats)
+    {
+        double values[2];
+        double vectors[4];
+        SmallDecomposition::symmetricEigen2x2(a.data(), values, vectors);
+        checkSymmetricEigen(a, values, vectors);
+    }
+}
+
+TEST(SmallDecomposition, SymmetricEigen3x3)
+{
+    // multiple Eigen values, diagonal and zero matrices
+    Matrix<double> zero(3, 3);
+    zero.fill(0.0);
+    Matrix<double> ones(3, 3);
+    ones.fill(1.0);
+    double diagonal[] = {2.0, 0.0, 0.0, 0.0, -7.0, 0.0, 0.0, 0.0, 1.0};
+    std::vector<Matrix<double>> mats = {zero, ones, Matrix<double>::identity(3), Matrix<double>(3, 3, diagonal)};
+    for (size_t k = 0; k < 200; k++)
+    {
+        auto r = Matrix<double>::random(3, 3, -5.0, 5.0);
+        mats.push_back(r + r.transpose());
+    }
+
+    for (const Matrix<double>& a : mats)
+    {
+        double values[3];
+        double vectors[9];
+        SmallDecomposition::symmetricEigen3x3(a.data(), values, vectors);
+        checkSymmetricEigen(a, values, vectors);
+
+        std::vector<double> ref = Decomposition::symmetricEigen(a).Values;
+        for (size_t k = 0; k < 3; k++)
+            ASSERT_NEAR(ref.at(k), values[k], 1e-12);
+    }
+}
+
+TEST(SmallDecomposition, SVD3x3)
+{
+    // rank deficient, reflections and the zero matrix
+    Matrix<double> zero(3, 3);
+    zero.fill(0.0);
+    Matrix<double> ones(3, 3);
+    ones.fill(1.0);
+    double permutation[] = {0.0, 1.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+    double rankTwo[]     = {1.0, 2.0, 3.0, 2.0, 4.0, 6.0, 0.0, 0.0, 1.0};
+    std::vector<Matrix<double>> mats = {zero, ones, Matrix<double>::identity(3), Matrix<double>::identity(3) * -1.0,
+                                        Matrix<double>(3, 3, permutation), Matrix<double>(3, 3, rankTwo)};
+    for (size_t k = 0; k < 200; k++)
+        mats.push_back(Matrix<double>::random(3, 3, -5.0, 5.0));
+
+    for (const Matrix<double>& a : mats)
+    {
+        for (bool rotations : {false, true})
+        {
+            double u[9], s[3], v[9];
+            SmallDecomposition::svd3x3(a.data(), u, s, v, rotations);
+            checkSVD3x3(a, u, s, v, rotations);
+        }
+
+        double u[9], s[3], v[9];
+        SmallDecomposition::svd3x3(a.data(), u, s, v);
+        std::vector<double> ref = Decomposition::singularValues(a);
+        for (size_t k = 0; k < 3; k++)
+            ASSERT_NEAR(ref.at(k), s[k], 1e-12);
+    }
+}
+
+TEST(SmallDecomposition, Batch)
+{
+    // two groups of four and a remainder of three
+    size_t              count = 11;
+    std::vector<double> a(9 * count);
+    std::vector<double> sym(9 * count);
+    for (size_t k = 0; k < count; k++)
+    {
+        auto r = Matrix<double>::random(3, 3, -5.0, 5.0);
+        auto t = r + r.transpose();
+        std::copy(r.data(), r.data() + 9, a.data() + 9 * k);
+        std::copy(t.data(), t.data() + 9, sym.data() + 9 * k);
+    }
+
+    for (size_t threads : {1, 3})
+    {
+        std::vector<double> values(3 * count), vectors(9 * count);
+        SmallDecomposition::symmetricEigen3x3Batch(sym.data(), values.data(), vectors.data(), count, threads);
+
+        std::vector<double> u(9 * count), s(3 * count), v(9 * count);
+        SmallDecomposition::svd3x3Batch(a.data(), u.data(), s.data(), v.data(), count, true, threads);
+
+        for (size_t k = 0; k < count; k++)
+        {
+            double refValues[3], refVectors[9];
+            SmallDecomposition::symmetricEigen3x3(sym.data() + 9 * k, refValues, refVectors);
+            for (size_t e = 0; e < 3; e++)
+                ASSERT_DOUBLE_EQ(refValues[e], values[3 * k + e]);
+            for (size_t e = 0; e < 9; e++)
+                ASSERT_DOUBLE_EQ(refVectors[e], vectors[9 * k + e]);
+
+            double refU[9], refS[3], refV[9];
+            SmallDecomposition::svd3x3(a.data() + 9 * k, refU, refS, refV, true);
+            for (size_t e = 0; e < 3; e++)
+                ASSERT_DOUBLE_EQ(refS[e], s[3 * k + e]);
+            for (size_t e = 0; e < 9; e++)
+            {
+                ASSERT_DOUBLE_EQ(refU[e], u[9 * k + e]);
+                ASSERT_DOUBLE_EQ(refV[e], v[9 * k + e]);
+            }
+        }
+    }
+}
@@ -39,3 +39,136 @@ TEST(Solve, BatchLinearSystem)
 }
 
 
+
+TEST(Solve, LargeLinearSystem)
+{
+    // large enough that the elimination runs multithreaded
+    auto c = Matrix<double>::random(400, 400, -1.0, 1.0);
+    auto b = Matrix<double>::random(400, 1, -1.0, 1.0);
+
+    auto x = Solve::solve_lseq(c, b);
+
+    ASSERT_TRUE( b.compare(c*x, true, 1e-8) );
+}
+
+TEST(Solve, MultipleRightHandSides)
+{
+    auto c = Matrix<double>::random(20, 20, -1.0, 1.0);
+    auto b = Matrix<double>::random(20, 7, -1.0, 1.0);
+
+    auto xEchelon = Solve::solve_lseq(c, b);
+    ASSERT_EQ(xEchelon.cols(), 7);
+    ASSERT_TRUE(b.compare(c * xEchelon, true, 1e-9));
+
+    auto xLU = Solve::solve(c, b, Solve::LU);
+    ASSERT_TRUE(b.compare(c * xLU, true, 1e-9));
+
+    auto xQR = Solve::solve(c, b, Solve::QR);
+    ASSERT_TRUE(b.compare(c * xQR, true, 1e-9));
+
+    // symmetric positive definite
+    auto spd  = c.transpose() * c + Matrix<double>::identity(20);
+    auto xCho = Solve::solve(spd, b, Solve::Cholesky);
+    ASSERT_TRUE(b.compare(spd * xCho, true, 1e-9));
+}
+
+TEST(Solve, MultipleRightHandSidesThreads)
+{
+    // a 300 x 300 system gives each thread its own columns to substitute.
+    // The column counts do not divide evenly between the 8 threads.
+    Parallel::DefaultNbrOfThreadsScope threads(8);
+
+    auto c = Matrix<double>::random(300, 300, -1.0, 1.0);
+    for (size_t nRhs : {1, 8, 9, 10, 12})
+    {
+        auto b   = Matrix<double>::random(300, nRhs, -1.0, 1.0);
+        auto xLU = Solve::solve(c, b, Solve::LU);
+        ASSERT_TRUE(b.compare(c * xLU, true, 1e-8));
+    }
+}
+
+TEST(Solve, PreparedSolver)
+{
+    auto c   = Matrix<double>::random(30, 30, -1.0, 1.0);
+    auto spd = c * c.transpose() + Matrix<double>::identity(30) * 0.1;
+
+    for (Solve::Factorization f : {Solve::LU, Solve::Cholesky, Solve::LDLT, Solve::QR})
+    {
+        Solve::Solver solver(spd, f);
+        ASSERT_EQ(solver.factorization(), f);
+
+        for (size_t k = 0; k < 5; k++)
+        {
+            auto b = Matrix<double>::random(30, k + 1, -1.0, 1.0);
+            auto x = solver.solve(b);
+            ASSERT_TRUE(b.compare(spd * x, true, 1e-8));
+
+            solver.solveInPlace(b);
+            ASSERT_TRUE(x.compare(b, true, 1e-12));
+        }
+    }
+}
+
+TEST(Solve, LeastSquaresQR)
+{
+    // over-determined: the residual is orthogonal to the columns of mat
+    auto a = Matrix<double>::random(40, 6, -1.0, 1.0);
+    auto b = Matrix<double>::random(40, 3, -1.0, 1.0);
+
+    Solve::Solver solver(a, Solve::QR);
+    auto          x = solver.solve(b);
+    ASSERT_EQ(x.rows(), 6);
+    ASSERT_EQ(x.cols(), 3);
+
+    auto normalEq = a.transpose() * (a * x - b);
+    ASSERT_TRUE(normalEq.compare(Matrix<double>(6, 3, std::vector<double>(18, 0.0)), true, 1e-10));
+
+    Matrix<double> bIn = b;
+    ASSERT_THROW(solver.solveInPlace(bIn), InvalidInputException);
+}
+
+TEST(Solve, SolverErrors)
+{
+    double singularData[] = {1, 2, 2, 4};
+    auto   singular       = Matrix<double>(2, 2, singularData);
+    ASSERT_THROW(Solve::Solver(singular, Solve::LU), ZeroDeterminantException);
+
+    double indefiniteData[] = {1, 2, 2, 1};
+    auto   indefinite       = Matrix<double>(2, 2, indefiniteData);
+    ASSERT_THROW(Solve::Solver(indefinite, Solve::Cholesky), NotPositiveDefiniteException);
+
+    auto wide = Matrix<double>::random(2, 3, -1.0, 1.0);
+    ASSERT_THROW(Solve::Solver(wide, Solve::LU), SquareMatrixException);
+    ASSERT_THROW(Solve::Solver(wide, Solve::QR), InvalidInputException);
+
+    // rank deficient: the third column is the sum of the first two, R(2,2) is only rounding error
+    auto deficient = Matrix<double>::random(8, 3, -1.0, 1.0);
+    for (size_t i = 0; i < 8; i++)
+        deficient(i, 2) = 0.3 * deficient(i, 0) + 0.7 * deficient(i, 1);
+    ASSERT_THROW(Solve::Solver(deficient, Solve::QR), ZeroDeterminantException);
+    Matrix<double> zeros(8, 3);
+    zeros.fill(0.0);
+    ASSERT_THROW(Solve::Solver(zeros, Solve::QR), ZeroDeterminantException);
+
+    Solve::Solver solver(indefinite, Solve::LU);
+    ASSERT_THROW(solver.solve(Matrix<double>(3, 1)), InvalidInputException);
+}
+
+TEST(Solve, LeastSquaresTall)
+{
+    // forming Q would need 20000 x 20000 entries
+    size_t m = 20000;
+    size_t n = 12;
+    auto   a = Matrix<double>::random(m, n, -1.0, 1.0);
+    auto   x = Matrix<double>::random(n, 2, -1.0, 1.0);
+    auto   b = a * x;
+
+    auto xLs = Solve::leastSquares(a, b);
+    ASSERT_TRUE(x.compare(xLs, true, 1e-10));
+
+    // noisy right hand side: compare with the normal equations
+    auto bNoisy   = b + Matrix<double>::random(m, 2, -0.1, 0.1);
+    auto xNoisy   = Solve::leastSquares(a, bNoisy);
+    auto xNormal  = Solve::solve(a.transpose() * a, a.transpose() * bNoisy, Solve::Cholesky);
+    ASSERT_TRUE(xNormal.compare(xNoisy, true, 1e-9));
+}
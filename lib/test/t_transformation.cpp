@@ -89,6 +89,32 @@ TEST(Transformation, ReducedEchelonRowOps)
     ASSERT_TRUE(computedRedEch.compare(stepwiseEchelon));
 }
 
+TEST(Transformation, ReducedEchelonCompactRowOps)
+{
+    for (size_t k = 0; k < 20; k++)
+    {
+        auto mat = Matrix<double>::random(5, 7, -5.0, 5.0);
+
+        std::vector<Multiplier::RowOperation> compactOps;
+        auto                                  compactRedEch = Transformation::reduced_echelon(mat, compactOps, true);
+
+        std::vector<Matrix<double>> denseOps;
+        auto                        denseRedEch = Transformation::reduced_echelon(mat, denseOps, true);
+
+        ASSERT_TRUE(compactRedEch.compare(denseRedEch));
+        ASSERT_EQ(compactOps.size(), denseOps.size());
+
+        // replaying the compact log in place leads to the reduced echelon form
+        auto replayed = mat;
+        Multiplier::apply(compactOps, replayed);
+        ASSERT_TRUE(compactRedEch.compare(replayed, true, 1e-10));
+
+        // the expanded log matches the legacy multiplier matrices
+        for (size_t i = 0; i < compactOps.size(); i++)
+            ASSERT_TRUE(Multiplier::toMatrix(compactOps[i], mat.rows()).compare(denseOps[i]));
+    }
+}
+
 TEST(Transformation, MatrixRank)
 {
     double         inData[9] = {0, 1, 2, 1, 2, 1, 2, 7, 8};
@@ -114,6 +140,22 @@ TEST(Transformation, MatrixRank0)
     ASSERT_EQ(in.getRank(), 0);
 }
 
+TEST(Transformation, MatrixRankLowRankBatch)
+{
+    for (int k = 0; k < 100; k++)
+    {
+        auto in = Matrix<double>::random(10, 4, -100.0, 100.0) * Matrix<double>::random(4, 12, -100.0, 100.0);
+        ASSERT_EQ(in.getRank(), 4);
+        ASSERT_EQ(in.transpose().getRank(), 4);
+    }
+
+    // near singular matrix: rank depends on the tolerance
+    auto in = Matrix<double>::identity(3);
+    in(2, 2) = 1e-8;
+    ASSERT_EQ(in.getRank(), 3);
+    ASSERT_EQ(in.getRank(1e-6), 2);
+}
+
 /*
 // inverse: http://stattrek.com/matrix-algebra/how-to-find-inverse.aspx
 //https://math.dartmouth.edu/archive/m23s06/public_html/handouts/row_reduction_examples.pdf